@@ -0,0 +1,192 @@
+#include "BufferPool.h"
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace VTFLib {
+
+namespace {
+
+// Bookkeeping stored in the BUFFER_ALIGNMENT bytes in front of every buffer
+struct BlockHeader {
+    size_t capacity;
+    size_t allocationSize;
+    bool mapped;
+};
+
+static_assert(sizeof(BlockHeader) <= BUFFER_ALIGNMENT, "BlockHeader must fit in the alignment padding");
+
+BlockHeader* GetHeader(void* buffer) {
+    return reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(buffer) - BUFFER_ALIGNMENT);
+}
+
+} // namespace
+
+BufferPool::BufferPool()
+    : cachedBytes_(0), maxCachedBytes_(256 * 1024 * 1024),
+#if defined(__linux__)
+      hugePages_(true) {
+#else
+      hugePages_(false) {
+#endif
+}
+
+BufferPool::~BufferPool() {
+    Trim();
+}
+
+BufferPool& BufferPool::Shared() {
+    static BufferPool pool;
+    return pool;
+}
+
+size_t BufferPool::GetSizeClass(size_t size) {
+    if (size <= 4096) {
+        return 4096;
+    }
+    
+    // Four classes per power of two, so at most 25% of a buffer is slack
+    size_t power = 1;
+    while (power < size) {
+        power <<= 1;
+    }
+    size_t step = power / 8;
+    return (size + step - 1) / step * step;
+}
+
+void* BufferPool::Acquire(size_t size) {
+    size_t capacity = GetSizeClass(size);
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = freeLists_.find(capacity);
+        if (it != freeLists_.end() && !it->second.empty()) {
+            void* buffer = it->second.back();
+            it->second.pop_back();
+            cachedBytes_ -= capacity;
+            return buffer;
+        }
+    }
+    
+    return Allocate(capacity);
+}
+
+void BufferPool::Release(void* buffer) {
+    if (!buffer) {
+        return;
+    }
+    
+    size_t capacity = GetHeader(buffer)->capacity;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cachedBytes_ + capacity <= maxCachedBytes_) {
+            freeLists_[capacity].push_back(buffer);
+            cachedBytes_ += capacity;
+            return;
+        }
+    }
+    
+    Free(buffer);
+}
+
+void BufferPool::Trim() {
+    std::map<size_t, std::vector<void*>> freeLists;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeLists.swap(freeLists_);
+        cachedBytes_ = 0;
+    }
+    
+    for (auto& entry : freeLists) {
+        for (void* buffer : entry.second) {
+            Free(buffer);
+        }
+    }
+}
+
+void BufferPool::SetMaxCachedBytes(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxCachedBytes_ = bytes;
+        if (cachedBytes_ <= maxCachedBytes_) {
+            return;
+        }
+    }
+    Trim();
+}
+
+size_t BufferPool::GetCachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cachedBytes_;
+}
+
+void BufferPool::SetHugePagesEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hugePages_ = enabled;
+}
+
+void* BufferPool::Allocate(size_t capacity) {
+    size_t allocationSize = capacity + BUFFER_ALIGNMENT;
+    uint8_t* base = nullptr;
+    bool mapped = false;
+    
+#if defined(__linux__)
+    bool hugePages;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hugePages = hugePages_;
+    }
+    if (hugePages && capacity >= HUGE_PAGE_THRESHOLD) {
+        void* memory = mmap(nullptr, allocationSize, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED) {
+            madvise(memory, allocationSize, MADV_HUGEPAGE);
+            base = static_cast<uint8_t*>(memory);
+            mapped = true;
+        }
+    }
+#endif
+    
+    if (!base) {
+#if defined(_WIN32)
+        base = static_cast<uint8_t*>(_aligned_malloc(allocationSize, BUFFER_ALIGNMENT));
+#else
+        void* memory = nullptr;
+        if (posix_memalign(&memory, BUFFER_ALIGNMENT, allocationSize) == 0) {
+            base = static_cast<uint8_t*>(memory);
+        }
+#endif
+    }
+    
+    if (!base) {
+        return nullptr;
+    }
+    
+    void* buffer = base + BUFFER_ALIGNMENT;
+    BlockHeader* header = GetHeader(buffer);
+    header->capacity = capacity;
+    header->allocationSize = allocationSize;
+    header->mapped = mapped;
+    return buffer;
+}
+
+void BufferPool::Free(void* buffer) {
+    BlockHeader* header = GetHeader(buffer);
+    void* base = header;
+    
+#if !defined(_WIN32)
+    if (header->mapped) {
+        munmap(base, header->allocationSize);
+        return;
+    }
+    free(base);
+#else
+    _aligned_free(base);
+#endif
+}
+
+} // namespace VTFLib
@@ -0,0 +1,61 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace VTFLib {
+
+// Alignment of every buffer handed out by BufferPool (one cache line, one AVX-512 register)
+const size_t BUFFER_ALIGNMENT = 64;
+
+// Buffers at least this large may be backed by transparent huge pages
+const size_t HUGE_PAGE_THRESHOLD = 2 * 1024 * 1024;
+
+// Recycles large decode buffers by size class so that flipping between textures
+// doesn't hit the heap (and the kernel) for every 64 MB image. Thread-safe.
+class BufferPool {
+public:
+    BufferPool();
+    ~BufferPool();
+    
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    
+    static BufferPool& Shared();
+    
+    // Get a BUFFER_ALIGNMENT-aligned buffer of at least size bytes (nullptr if out of memory)
+    void* Acquire(size_t size);
+    
+    // Return a buffer obtained from Acquire; it is kept for reuse while the cache has room
+    void Release(void* buffer);
+    
+    // Free every cached buffer
+    void Trim();
+    
+    void SetMaxCachedBytes(size_t bytes);
+    size_t GetCachedBytes() const;
+    
+    // Back large buffers with huge pages where the OS supports it (Linux THP)
+    void SetHugePagesEnabled(bool enabled);
+    
+    // Capacity actually allocated for a request of size bytes
+    static size_t GetSizeClass(size_t size);
+    
+private:
+    mutable std::mutex mutex_;
+    std::map<size_t, std::vector<void*>> freeLists_;
+    size_t cachedBytes_;
+    size_t maxCachedBytes_;
+    bool hugePages_;
+    
+    void* Allocate(size_t capacity);
+    static void Free(void* buffer);
+};
+
+} // namespace VTFLib
+
+#endif // BUFFERPOOL_H
@@ -0,0 +1,250 @@
+#include "DirectoryWalker.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace VTFLib {
+
+namespace {
+
+char ToLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+#if !defined(_WIN32)
+enum class EntryKind { Other, File, Directory };
+
+// Kind of an entry whose type the listing didn't give. Symlinks to files count as files,
+// symlinks to directories as neither, so a link cycle can't trap the walk.
+EntryKind StatEntry(int directoryFd, const char* name) {
+    struct stat info;
+    if (fstatat(directoryFd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+        return EntryKind::Other;
+    }
+    if (S_ISLNK(info.st_mode)) {
+        return fstatat(directoryFd, name, &info, 0) == 0 && S_ISREG(info.st_mode)
+            ? EntryKind::File : EntryKind::Other;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        return EntryKind::Directory;
+    }
+    return S_ISREG(info.st_mode) ? EntryKind::File : EntryKind::Other;
+}
+
+EntryKind KindOf(unsigned char type, int directoryFd, const char* name) {
+    switch (type) {
+    case DT_REG:
+        return EntryKind::File;
+    case DT_DIR:
+        return EntryKind::Directory;
+    case DT_LNK:
+    case DT_UNKNOWN:
+        return StatEntry(directoryFd, name);
+    default:
+        return EntryKind::Other;
+    }
+}
+#endif
+
+#if defined(__linux__)
+// Layout the kernel writes for getdents64; glibc doesn't declare it
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+#endif
+
+// Split one directory's entries into matching files and subdirectories
+bool ListDirectory(const std::string& path, const std::vector<std::string>& suffixes,
+                   std::vector<std::string>& files, std::vector<std::string>& directories) {
+    const std::string prefix = path.back() == '/' ? path : path + '/';
+    
+    auto addEntry = [&](const char* name, bool isDirectory) {
+        std::string entry = name;
+        if (isDirectory) {
+            directories.push_back(prefix + entry);
+        } else if (DirectoryWalker::MatchesSuffix(entry, suffixes)) {
+            files.push_back(prefix + entry);
+        }
+    };
+
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileExA((prefix + '*').c_str(), FindExInfoBasic, &data,
+                                   FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        DWORD attributes = data.dwFileAttributes;
+        if (data.cFileName[0] == '.' || (attributes & FILE_ATTRIBUTE_HIDDEN)) {
+            continue;
+        }
+        bool isDirectory = (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if (isDirectory && (attributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+            continue;
+        }
+        addEntry(data.cFileName, isDirectory);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#elif defined(__linux__)
+    int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // getdents64 hands back a whole buffer of entries per call, types included
+    std::unique_ptr<char[]> buffer(new char[WALK_BUFFER_SIZE]);
+    for (;;) {
+        long bytes = syscall(SYS_getdents64, fd, buffer.get(), WALK_BUFFER_SIZE);
+        if (bytes <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < bytes;) {
+            const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer.get() + offset);
+            offset += entry->d_reclen;
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            EntryKind kind = KindOf(entry->d_type, fd, entry->d_name);
+            if (kind != EntryKind::Other) {
+                addEntry(entry->d_name, kind == EntryKind::Directory);
+            }
+        }
+    }
+    ::close(fd);
+#else
+    DIR* directory = opendir(path.c_str());
+    if (!directory) {
+        return false;
+    }
+    while (const dirent* entry = readdir(directory)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        EntryKind kind = KindOf(entry->d_type, dirfd(directory), entry->d_name);
+        if (kind != EntryKind::Other) {
+            addEntry(entry->d_name, kind == EntryKind::Directory);
+        }
+    }
+    closedir(directory);
+#endif
+    return true;
+}
+
+} // namespace
+
+bool DirectoryWalker::MatchesSuffix(const std::string& name, const std::vector<std::string>& suffixes) {
+    for (const std::string& suffix : suffixes) {
+        if (suffix.size() <= name.size() &&
+            std::equal(suffix.begin(), suffix.end(), name.end() - suffix.size(),
+                       [](char a, char b) { return ToLower(a) == ToLower(b); })) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t DirectoryWalker::Walk(const std::string& root, const std::vector<std::string>& suffixes,
+                             bool recursive, const FileCallback& onFiles,
+                             const std::atomic<bool>* cancel) {
+    if (root.empty()) {
+        return 0;
+    }
+    
+    // Helpers may start after the walk is over, so the shared state outlives this call.
+    // They only touch the arguments while holding a directory, which can't happen then.
+    struct State {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<std::string> directories;  // a stack, so the walk stays depth-first
+        unsigned busy = 0;
+        std::mutex callbackMutex;
+        size_t fileCount = 0;
+    };
+    auto state = std::make_shared<State>();
+    state->directories.push_back(root);
+    
+    const auto* arguments = &suffixes;
+    const auto* callback = &onFiles;
+    
+    auto work = [state, arguments, callback, recursive, cancel] {
+        auto cancelled = [cancel] { return cancel && cancel->load(std::memory_order_relaxed); };
+        
+        std::unique_lock<std::mutex> lock(state->mutex);
+        for (;;) {
+            state->condition.wait(lock, [&state, &cancelled] {
+                return state->busy == 0 || (!state->directories.empty() && !cancelled());
+            });
+            if (!state->directories.empty() && cancelled()) {
+                state->directories.clear();
+            }
+            if (state->directories.empty()) {
+                return;
+            }
+            
+            std::string path = std::move(state->directories.back());
+            state->directories.pop_back();
+            state->busy++;
+            lock.unlock();
+            
+            std::vector<std::string> files;
+            std::vector<std::string> directories;
+            ListDirectory(path, *arguments, files, directories);
+            
+            if (recursive && !directories.empty()) {
+                std::lock_guard<std::mutex> pushLock(state->mutex);
+                for (std::string& directory : directories) {
+                    state->directories.push_back(std::move(directory));
+                }
+                state->condition.notify_all();
+            }
+            
+            if (!files.empty()) {
+                std::sort(files.begin(), files.end());
+                std::lock_guard<std::mutex> callbackLock(state->callbackMutex);
+                state->fileCount += files.size();
+                (*callback)(files);
+            }
+            
+            lock.lock();
+            if (--state->busy == 0) {
+                state->condition.notify_all();
+            }
+        }
+    };
+    
+    if (recursive) {
+        ThreadPool& pool = ThreadPool::Shared();
+        for (unsigned i = 0; i < pool.GetThreadCount(); ++i) {
+            pool.Submit(work);
+        }
+    }
+    work();
+    
+    // A cancelled walk can end while helpers still hold directories
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state] { return state->busy == 0; });
+    return state->fileCount;
+}
+
+} // namespace VTFLib
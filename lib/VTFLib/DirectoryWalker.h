@@ -0,0 +1,39 @@
+#ifndef DIRECTORYWALKER_H
+#define DIRECTORYWALKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace VTFLib {
+
+// Bytes of directory entries read per getdents64 call
+const size_t WALK_BUFFER_SIZE = 64 * 1024;
+
+// Parallel directory tree walk. Subdirectories go on a shared stack that the calling
+// thread and the pool's workers all take from, so wide trees are listed concurrently.
+// Entry types come from the listing itself (d_type on POSIX, attributes on Windows);
+// an entry is only stat'ed when the filesystem doesn't report its type. Hidden entries
+// are skipped and symlinked directories are not followed.
+class DirectoryWalker {
+public:
+    // Receives the matching files of one directory, sorted. Calls are serialized but come
+    // from any of the walking threads, and may be moved from.
+    using FileCallback = std::function<void(std::vector<std::string>& files)>;
+    
+    // Walk root, reporting files whose names end with one of suffixes (case-insensitive,
+    // e.g. ".vtf" or "_dir.vpk"). Returns once the walk is done or cancel was set, with
+    // the number of files reported.
+    static size_t Walk(const std::string& root, const std::vector<std::string>& suffixes,
+                       bool recursive, const FileCallback& onFiles,
+                       const std::atomic<bool>* cancel = nullptr);
+    
+    // Whether a file name ends with one of suffixes, ignoring case
+    static bool MatchesSuffix(const std::string& name, const std::vector<std::string>& suffixes);
+};
+
+} // namespace VTFLib
+
+#endif // DIRECTORYWALKER_H
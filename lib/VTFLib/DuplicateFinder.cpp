@@ -0,0 +1,172 @@
+#include "DuplicateFinder.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "TextureMetadataIndex.h"
+#include "ThreadPool.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <tuple>
+
+namespace VTFLib {
+
+namespace {
+
+// Fields that decide the layout of the image data; equal payloads have equal shapes
+using Shape = std::tuple<uint32_t, uint16_t, uint16_t, uint16_t, uint16_t, uint8_t>;
+
+struct Digest {
+    bool valid = false;
+    uint64_t payloadHash = 0;
+    uint64_t payloadSize = 0;
+    uint64_t fileHash = 0;
+    uint64_t fileSize = 0;
+};
+
+// Shape of a file the index doesn't cover, from its header alone
+bool ReadShape(const std::string& filename, TextureMetadata& texture) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    uint8_t header[sizeof(VTFHeader)];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    return TextureMetadataIndex::ReadHeader(header, static_cast<size_t>(file.gcount()), texture) &&
+           texture.IsValid();
+}
+
+Digest HashTexture(const std::string& filename) {
+    Digest digest;
+    std::shared_ptr<const MappedFile> mapping = MappedFile::Map(filename);
+    if (!mapping) {
+        return digest;
+    }
+    
+    // Loaded in place over the mapping; only the pages hashed are read
+    VTFFile file;
+    if (!file.Load(mapping->GetData(), mapping->GetSize(), mapping)) {
+        return digest;
+    }
+    
+    digest.valid = true;
+    digest.payloadHash = XXHash64(file.GetRawImageData(), file.GetRawImageDataSize());
+    digest.payloadSize = file.GetRawImageDataSize();
+    digest.fileSize = mapping->GetSize();
+    
+    // The header and low-res image are small next to the payload, so this costs little
+    size_t headerSize = static_cast<size_t>(file.GetRawImageData() - mapping->GetData());
+    digest.fileHash = XXHash64(mapping->GetData(), headerSize, digest.payloadHash);
+    return digest;
+}
+
+} // namespace
+
+std::vector<DuplicateGroup> DuplicateFinder::Find(const std::vector<std::string>& filenames,
+                                                   const TextureMetadataIndex* metadata,
+                                                   BatchProgress* progress) {
+    // Shapes come from the index; files it doesn't cover, such as ones added since it was
+    // last refreshed, have their header read so they still meet their indexed twins
+    std::vector<TextureMetadata> shapes(filenames.size());
+    std::vector<char> shaped(filenames.size(), 0);
+    std::vector<uint32_t> unindexed;
+    for (uint32_t i = 0; i < filenames.size(); ++i) {
+        size_t row = metadata ? metadata->Find(filenames[i]) : TextureMetadataIndex::NOT_FOUND;
+        if (row == TextureMetadataIndex::NOT_FOUND) {
+            unindexed.push_back(i);
+            continue;
+        }
+        shapes[i] = metadata->GetMetadata(row);
+        shaped[i] = shapes[i].IsValid();
+    }
+    if (progress) {
+        progress->total += unindexed.size();
+    }
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(unindexed.size()), DUPLICATE_HASH_GRAIN,
+        [&filenames, &unindexed, &shapes, &shaped, progress](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end && !(progress && progress->IsCancelled()); ++i) {
+                uint32_t file = unindexed[i];
+                shaped[file] = ReadShape(filenames[file], shapes[file]);
+            }
+            if (progress) {
+                progress->done += end - begin;
+            }
+        });
+    if (progress && progress->IsCancelled()) {
+        return {};
+    }
+    
+    // Bucket by shape; only files sharing a shape with another can be duplicates
+    std::map<Shape, std::vector<uint32_t>> buckets;
+    for (uint32_t i = 0; i < filenames.size(); ++i) {
+        if (shaped[i]) {
+            const TextureMetadata& texture = shapes[i];
+            buckets[Shape(texture.format, texture.width, texture.height, texture.depth,
+                          texture.frames, texture.mipmapCount)].push_back(i);
+        }
+    }
+    std::vector<uint32_t> candidates;
+    for (const auto& bucket : buckets) {
+        if (bucket.second.size() > 1) {
+            candidates.insert(candidates.end(), bucket.second.begin(), bucket.second.end());
+        }
+    }
+    
+    std::vector<Digest> digests(candidates.size());
+    if (progress) {
+        progress->total += candidates.size();
+    }
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(candidates.size()), DUPLICATE_HASH_GRAIN,
+        [&filenames, &candidates, &digests, progress](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end && !(progress && progress->IsCancelled()); ++i) {
+                digests[i] = HashTexture(filenames[candidates[i]]);
+            }
+            if (progress) {
+                progress->done += end - begin;
+            }
+        });
+    if (progress && progress->IsCancelled()) {
+        return {};
+    }
+    
+    std::map<std::pair<uint64_t, uint64_t>, std::vector<uint32_t>> matches;
+    for (uint32_t i = 0; i < candidates.size(); ++i) {
+        if (digests[i].valid) {
+            matches[{ digests[i].payloadHash, digests[i].payloadSize }].push_back(i);
+        }
+    }
+    
+    std::vector<DuplicateGroup> groups;
+    for (auto& match : matches) {
+        std::vector<uint32_t>& members = match.second;
+        if (members.size() < 2) {
+            continue;
+        }
+        std::sort(members.begin(), members.end(), [&filenames, &candidates](uint32_t a, uint32_t b) {
+            return filenames[candidates[a]] < filenames[candidates[b]];
+        });
+        
+        DuplicateGroup group;
+        group.payloadSize = match.first.second;
+        group.identicalFiles = true;
+        for (uint32_t member : members) {
+            const Digest& digest = digests[member];
+            group.files.push_back(filenames[candidates[member]]);
+            if (member != members.front()) {
+                group.wastedBytes += digest.fileSize;
+            }
+            const Digest& first = digests[members.front()];
+            if (digest.fileHash != first.fileHash || digest.fileSize != first.fileSize) {
+                group.identicalFiles = false;
+            }
+        }
+        groups.push_back(std::move(group));
+    }
+    
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup& a, const DuplicateGroup& b) {
+        return a.wastedBytes != b.wastedBytes ? a.wastedBytes > b.wastedBytes : a.files < b.files;
+    });
+    return groups;
+}
+
+} // namespace VTFLib
@@ -0,0 +1,42 @@
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VTFLib {
+
+class TextureMetadataIndex;
+struct BatchProgress;
+
+// Files hashed per thread pool chunk
+const uint32_t DUPLICATE_HASH_GRAIN = 16;
+
+// Textures whose image data is identical
+struct DuplicateGroup {
+    std::vector<std::string> files;  // sorted
+    uint64_t payloadSize = 0;        // bytes of image data per copy
+    uint64_t wastedBytes = 0;        // file bytes of every copy but the first
+    bool identicalFiles = false;     // the whole files match, headers included
+};
+
+// Finds textures that differ only in path, or only in header fields that don't change
+// the pixels (flags, reflectivity, ...). Textures are first bucketed by shape (size,
+// format, frames, mips) from the metadata index, so one with a unique shape is never
+// opened; the rest are memory-mapped and their image data hashed with XXH64 in parallel.
+// Groups are matched on hash and payload size; 64-bit hashes make a false match vanishingly
+// unlikely, and files are not compared byte by byte.
+class DuplicateFinder {
+public:
+    // Groups of two or more, most wasted bytes first. Files the index doesn't cover, or
+    // every file when there is no index, are bucketed by a read of their header. Progress
+    // counts header reads and hashes.
+    static std::vector<DuplicateGroup> Find(const std::vector<std::string>& filenames,
+                                            const TextureMetadataIndex* metadata = nullptr,
+                                            BatchProgress* progress = nullptr);
+};
+
+} // namespace VTFLib
+
+#endif // DUPLICATEFINDER_H
@@ -0,0 +1,313 @@
+#include "GameIndex.h"
+#include "ThreadPool.h"
+#include "VMTFile.h"
+#include "VPKFile.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace VTFLib {
+
+namespace {
+
+const char* const GAMEINFO_PATH_MACRO = "|gameinfo_path|";
+const char* const ENGINE_PATHS_MACRO = "|all_source_engine_paths|";
+
+// Directories that get their pak01 VPK mounted along with them
+const char* const DIRECTORY_VPK_NAME = "pak01_dir.vpk";
+
+std::string ToLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    });
+    return text;
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool StartsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Whether a '+'-separated list of search path IDs includes GAME
+bool HasGamePathID(const std::string& key) {
+    std::string ids = ToLower(key);
+    size_t begin = 0;
+    while (begin <= ids.size()) {
+        size_t end = ids.find('+', begin);
+        if (end == std::string::npos) {
+            end = ids.size();
+        }
+        if (ids.compare(begin, end - begin, "game") == 0) {
+            return true;
+        }
+        begin = end + 1;
+    }
+    return false;
+}
+
+} // namespace
+
+GameIndex::GameIndex() {
+}
+
+GameIndex::~GameIndex() {
+}
+
+bool GameIndex::Load(const std::string& gameInfoFilename) {
+    if (!LoadSearchPaths(gameInfoFilename)) {
+        return false;
+    }
+    IndexFiles();
+    return true;
+}
+
+bool GameIndex::LoadSearchPaths(const std::string& gameInfoFilename) {
+    searchPaths_.clear();
+    files_.clear();
+    return ResolveSearchPaths(gameInfoFilename) && !searchPaths_.empty();
+}
+
+void GameIndex::IndexFiles() {
+    files_.clear();
+    
+    // Walk every search path at once; each fills its own list
+    std::vector<std::vector<std::pair<std::string, uint32_t>>> found(searchPaths_.size());
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(searchPaths_.size()), 1,
+        [this, &found](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                IndexSearchPath(searchPaths_[i], found[i]);
+            }
+        });
+    
+    size_t total = 0;
+    for (const auto& paths : found) {
+        total += paths.size();
+    }
+    files_.reserve(total);
+    
+    // Merge in priority order; emplace keeps the first search path providing a file
+    for (uint32_t i = 0; i < found.size(); ++i) {
+        for (auto& file : found[i]) {
+            files_.emplace(std::move(file.first), GameFileLocation{ i, file.second });
+        }
+    }
+}
+
+std::shared_ptr<const GameIndex> GameIndex::Open(const std::string& gameInfoFilename) {
+    auto index = std::make_shared<GameIndex>();
+    if (!index->Load(gameInfoFilename)) {
+        return nullptr;
+    }
+    return index;
+}
+
+bool GameIndex::ResolveSearchPaths(const std::string& gameInfoFilename) {
+    VMTFile gameInfo;
+    if (!gameInfo.Load(gameInfoFilename)) {
+        return false;
+    }
+    
+    const VMTNode* root = gameInfo.GetRoot();
+    const VMTNode* name = root->FindChild("game");
+    gameName_ = name ? std::string(name->GetValue()) : std::string();
+    
+    const VMTNode* searchPaths = root->FindPath("FileSystem/SearchPaths");
+    if (!searchPaths) {
+        return false;
+    }
+    
+    // Relative paths and |all_source_engine_paths| start from the directory above the mod
+    std::error_code error;
+    fs::path gameDir = fs::absolute(fs::path(gameInfoFilename), error).parent_path();
+    fs::path baseDir = gameDir.parent_path();
+    
+    for (const VMTNode& entry : searchPaths->GetChildren()) {
+        if (!HasGamePathID(std::string(entry.GetName()))) {
+            continue;
+        }
+        
+        std::string value(entry.GetValue());
+        fs::path path;
+        if (StartsWith(ToLower(value), GAMEINFO_PATH_MACRO)) {
+            path = gameDir / value.substr(strlen(GAMEINFO_PATH_MACRO));
+        } else if (StartsWith(ToLower(value), ENGINE_PATHS_MACRO)) {
+            path = baseDir / value.substr(strlen(ENGINE_PATHS_MACRO));
+        } else if (fs::path(value).is_absolute()) {
+            path = value;
+        } else {
+            path = baseDir / value;
+        }
+        
+        std::string resolved = path.lexically_normal().generic_string();
+        if (resolved.size() > 1 && resolved.back() == '/') {
+            resolved.pop_back();
+        }
+        
+        // "custom/*" mounts every directory and VPK inside, alphabetically
+        if (EndsWith(resolved, "/*")) {
+            fs::path parent = fs::path(resolved).parent_path();
+            std::vector<std::string> children;
+            for (fs::directory_iterator it(parent, error), end; !error && it != end; it.increment(error)) {
+                children.push_back(it->path().generic_string());
+            }
+            std::sort(children.begin(), children.end());
+            for (const std::string& child : children) {
+                AddSearchPath(child);
+            }
+        } else {
+            AddSearchPath(resolved);
+        }
+    }
+    
+    return true;
+}
+
+void GameIndex::AddSearchPath(const std::string& path) {
+    std::error_code error;
+    std::string resolved = path;
+    
+    if (EndsWith(ToLower(path), ".vpk")) {
+        // "hl2/hl2_textures.vpk" names the archive set; its index is hl2_textures_dir.vpk
+        std::string dirFile = path.substr(0, path.size() - 4) + "_dir.vpk";
+        if (fs::is_regular_file(dirFile, error)) {
+            resolved = dirFile;
+        } else if (!fs::is_regular_file(path, error)) {
+            return;
+        }
+        
+        // Numbered data archives aren't search paths of their own
+        std::string stem = fs::path(resolved).stem().string();
+        if (stem.size() > 4 && stem[stem.size() - 4] == '_' &&
+            std::all_of(stem.end() - 3, stem.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return;
+        }
+    } else if (!fs::is_directory(path, error)) {
+        return;
+    }
+    
+    for (const GameSearchPath& existing : searchPaths_) {
+        if (existing.path == resolved) {
+            return;
+        }
+    }
+    
+    GameSearchPath searchPath;
+    searchPath.path = resolved;
+    searchPaths_.push_back(std::move(searchPath));
+    
+    // Loose files in a directory override its pak01 VPK, which comes right after it
+    if (fs::is_directory(resolved, error)) {
+        AddSearchPath((fs::path(resolved) / DIRECTORY_VPK_NAME).generic_string());
+    }
+}
+
+void GameIndex::IndexSearchPath(GameSearchPath& searchPath,
+                                std::vector<std::pair<std::string, uint32_t>>& found) {
+    searchPath.files.clear();
+    
+    if (EndsWith(ToLower(searchPath.path), ".vpk")) {
+        searchPath.vpk = VPKFile::Open(searchPath.path);
+        if (!searchPath.vpk) {
+            return;
+        }
+        
+        // Entries are sorted by path, so the indexed ones form one contiguous run
+        size_t rootLength = strlen(GAME_INDEX_ROOT);
+        for (size_t i = 0; i < searchPath.vpk->GetEntryCount(); ++i) {
+            const char* entryPath = searchPath.vpk->GetEntryPath(searchPath.vpk->GetEntry(i));
+            if (strncmp(entryPath, GAME_INDEX_ROOT, rootLength) == 0) {
+                found.emplace_back(entryPath, static_cast<uint32_t>(i));
+            }
+        }
+        return;
+    }
+    
+    // The materials directory may not be lowercase on case-sensitive file systems
+    std::error_code error;
+    fs::path root(searchPath.path);
+    fs::path materials;
+    std::string rootName(GAME_INDEX_ROOT, strlen(GAME_INDEX_ROOT) - 1);
+    for (fs::directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        if (ToLower(it->path().filename().string()) == rootName && it->is_directory(error)) {
+            materials = it->path();
+            break;
+        }
+    }
+    if (materials.empty()) {
+        return;
+    }
+    
+    auto options = fs::directory_options::skip_permission_denied;
+    for (fs::recursive_directory_iterator it(materials, options, error), end;
+         !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error)) {
+            continue;
+        }
+        std::string relative = it->path().lexically_relative(root).generic_string();
+        found.emplace_back(ToLower(relative), static_cast<uint32_t>(searchPath.files.size()));
+        searchPath.files.push_back(std::move(relative));
+    }
+}
+
+bool GameIndex::Find(const std::string& path, GameFileLocation& location) const {
+    std::string key = ToLower(path);
+    std::replace(key.begin(), key.end(), '\\', '/');
+    
+    auto it = files_.find(key);
+    if (it == files_.end()) {
+        return false;
+    }
+    location = it->second;
+    return true;
+}
+
+std::string GameIndex::GetFilePath(const GameFileLocation& location) const {
+    const GameSearchPath& searchPath = searchPaths_[location.searchPath];
+    if (searchPath.vpk) {
+        return searchPath.path + "/" + searchPath.vpk->GetEntryPath(searchPath.vpk->GetEntry(location.file));
+    }
+    return searchPath.path + "/" + searchPath.files[location.file];
+}
+
+std::shared_ptr<const VTFFile> GameIndex::OpenVTF(const GameFileLocation& location) const {
+    const GameSearchPath& searchPath = searchPaths_[location.searchPath];
+    if (searchPath.vpk) {
+        return searchPath.vpk->OpenVTF(searchPath.vpk->GetEntry(location.file));
+    }
+    return VTFFile::Open(GetFilePath(location));
+}
+
+bool GameIndex::LoadVMT(const GameFileLocation& location, VMTFile& material) const {
+    const GameSearchPath& searchPath = searchPaths_[location.searchPath];
+    if (searchPath.vpk) {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::shared_ptr<const void> owner;
+        if (!searchPath.vpk->GetEntryData(searchPath.vpk->GetEntry(location.file), data, size, owner)) {
+            return false;
+        }
+        return material.Load(data, size, owner);
+    }
+    return material.Load(GetFilePath(location));
+}
+
+std::vector<std::string> GameIndex::GetFiles(const std::string& extension) const {
+    std::string suffix = ToLower(extension);
+    std::vector<std::string> paths;
+    for (const auto& file : files_) {
+        if (EndsWith(file.first, suffix)) {
+            paths.push_back(file.first);
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+} // namespace VTFLib
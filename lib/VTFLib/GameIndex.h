@@ -0,0 +1,83 @@
+#ifndef GAMEINDEX_H
+#define GAMEINDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VTFLib {
+
+class VMTFile;
+class VPKFile;
+class VTFFile;
+
+// Only files under this directory are indexed
+const char* const GAME_INDEX_ROOT = "materials/";
+
+// One GAME search path: a loose directory or a VPK
+struct GameSearchPath {
+    std::string path;                    // absolute directory, or the VPK's _dir file
+    std::shared_ptr<const VPKFile> vpk;  // null for directories
+    std::vector<std::string> files;      // on-disk relative paths of indexed loose files
+};
+
+// Where a game file lives: a search path and a file within it
+struct GameFileLocation {
+    uint32_t searchPath;
+    uint32_t file;  // into GameSearchPath::files, or a VPK entry index
+};
+
+// Index of every material and texture of a Source game install, built from gameinfo.txt.
+// Search paths are walked in parallel; when several provide the same file, the first in
+// gameinfo order wins, as in the engine. Lookups are a single hash probe. Thread-safe
+// once loaded.
+class GameIndex {
+public:
+    GameIndex();
+    ~GameIndex();
+    
+    bool Load(const std::string& gameInfoFilename);
+    
+    // Load in two steps: read gameinfo.txt and find the search paths, which is quick
+    // and fails for a bad file, then walk them all, which can take seconds
+    bool LoadSearchPaths(const std::string& gameInfoFilename);
+    void IndexFiles();
+    
+    // Index a game into a new shareable, read-only object (nullptr on failure)
+    static std::shared_ptr<const GameIndex> Open(const std::string& gameInfoFilename);
+    
+    // Look up a game-relative path such as "materials/brick/wall.vtf" (case-insensitive)
+    bool Find(const std::string& path, GameFileLocation& location) const;
+    
+    // A loose file's path, or "<vpk>/<entry>" for files inside a VPK
+    std::string GetFilePath(const GameFileLocation& location) const;
+    
+    // Load an indexed VTF (nullptr on failure)
+    std::shared_ptr<const VTFFile> OpenVTF(const GameFileLocation& location) const;
+    
+    // Parse an indexed VMT; one inside a VPK is read in place
+    bool LoadVMT(const GameFileLocation& location, VMTFile& material) const;
+    
+    // Game-relative paths of every indexed file with the given extension (e.g. ".vtf")
+    std::vector<std::string> GetFiles(const std::string& extension) const;
+    
+    const std::vector<GameSearchPath>& GetSearchPaths() const { return searchPaths_; }
+    size_t GetFileCount() const { return files_.size(); }
+    const std::string& GetGameName() const { return gameName_; }
+    
+private:
+    std::string gameName_;
+    std::vector<GameSearchPath> searchPaths_;
+    std::unordered_map<std::string, GameFileLocation> files_;
+    
+    bool ResolveSearchPaths(const std::string& gameInfoFilename);
+    void AddSearchPath(const std::string& path);
+    static void IndexSearchPath(GameSearchPath& searchPath,
+                                std::vector<std::pair<std::string, uint32_t>>& found);
+};
+
+} // namespace VTFLib
+
+#endif // GAMEINDEX_H
@@ -0,0 +1,270 @@
+#include "Hash.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define VTFLIB_CRC32_PCLMUL 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define VTFLIB_CRC32_ARM 1
+#endif
+
+#if defined(VTFLIB_CRC32_PCLMUL) && !defined(_MSC_VER)
+#define VTFLIB_TARGET_PCLMUL __attribute__((target("pclmul,sse2")))
+#else
+#define VTFLIB_TARGET_PCLMUL
+#endif
+
+namespace VTFLib {
+
+namespace {
+
+const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+uint64_t RotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Unaligned little-endian reads; memcpy compiles to a plain load on x86 and ARM
+uint64_t Read64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t Read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t Round(uint64_t accumulator, uint64_t input) {
+    accumulator += input * PRIME64_2;
+    accumulator = RotateLeft(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+uint64_t MergeRound(uint64_t accumulator, uint64_t value) {
+    accumulator ^= Round(0, value);
+    return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+// Reflected CRC-32 polynomial
+const uint32_t CRC32_POLYNOMIAL = 0xEDB88320;
+
+// Eight tables for slicing-by-8: table[k][b] is the CRC of byte b followed by k zero bytes
+struct CRC32Tables {
+    uint32_t table[8][256];
+    
+    CRC32Tables() {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32_POLYNOMIAL : 0);
+            }
+            table[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; ++b) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+            }
+        }
+    }
+};
+
+const CRC32Tables& GetCRC32Tables() {
+    static const CRC32Tables tables;
+    return tables;
+}
+
+// Works on the inverted CRC state, like the other kernels
+uint32_t CRC32Slicing(const uint8_t* p, size_t size, uint32_t crc) {
+    const auto& t = GetCRC32Tables().table;
+    while (size >= 8) {
+        uint32_t low = Read32(p) ^ crc;
+        uint32_t high = Read32(p + 4);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(VTFLIB_CRC32_PCLMUL)
+bool HasPCLMUL() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) != 0;
+#else
+    return __builtin_cpu_supports("pclmul");
+#endif
+}
+
+// One 128-bit lane carried forward by the distance k encodes, then combined with next
+VTFLIB_TARGET_PCLMUL
+inline __m128i Fold(__m128i x, __m128i k, __m128i next) {
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), next);
+}
+
+// Carry-less multiplication folding (Intel, "Fast CRC Computation for Generic Polynomials
+// Using PCLMULQDQ"). Takes at least 64 bytes, a multiple of 16.
+VTFLIB_TARGET_PCLMUL
+uint32_t CRC32Folding(const uint8_t* p, size_t size, uint32_t crc) {
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+    const __m128i k5 = _mm_set_epi64x(0, 0x0163CD6124);
+    const __m128i polynomial = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    
+    // Four lanes of 16 bytes, each folded 64 bytes forward per step
+    __m128i x1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                               _mm_cvtsi32_si128(static_cast<int>(crc)));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+    __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48));
+    p += 64;
+    size -= 64;
+    
+    while (size >= 64) {
+        x1 = Fold(x1, k1k2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        x2 = Fold(x2, k1k2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)));
+        x3 = Fold(x3, k1k2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32)));
+        x4 = Fold(x4, k1k2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48)));
+        p += 64;
+        size -= 64;
+    }
+    
+    // Lanes into one, then the remaining 16-byte blocks
+    x1 = Fold(x1, k3k4, x2);
+    x1 = Fold(x1, k3k4, x3);
+    x1 = Fold(x1, k3k4, x4);
+    while (size >= 16) {
+        x1 = Fold(x1, k3k4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        p += 16;
+        size -= 16;
+    }
+    
+    // 128 bits to 64
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5, 0x00), x2);
+    
+    // Barrett reduction to 32 bits
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, polynomial, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, polynomial, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+}
+#endif
+
+#if defined(VTFLIB_CRC32_ARM)
+uint32_t CRC32Instructions(const uint8_t* p, size_t size, uint32_t crc) {
+    while (size >= 8) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        crc = __crc32d(crc, value);
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = __crc32b(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+} // namespace
+
+uint64_t XXHash64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t hash;
+    
+    // Four independent lanes over 32-byte stripes
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = Round(v1, Read64(p));
+            v2 = Round(v2, Read64(p + 8));
+            v3 = Round(v3, Read64(p + 16));
+            v4 = Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = MergeRound(hash, v1);
+        hash = MergeRound(hash, v2);
+        hash = MergeRound(hash, v3);
+        hash = MergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME64_5;
+    }
+    
+    hash += static_cast<uint64_t>(size);
+    
+    // Tail: 8, then 4, then single bytes
+    while (end - p >= 8) {
+        hash ^= Round(0, Read64(p));
+        hash = RotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        hash ^= static_cast<uint64_t>(Read32(p)) * PRIME64_1;
+        hash = RotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= (*p) * PRIME64_5;
+        hash = RotateLeft(hash, 11) * PRIME64_1;
+        p++;
+    }
+    
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint32_t CRC32(const void* data, size_t size, uint32_t crc) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+#if defined(VTFLIB_CRC32_PCLMUL)
+    static const bool pclmul = HasPCLMUL();
+    if (pclmul && size >= 64) {
+        size_t folded = size & ~static_cast<size_t>(15);
+        crc = CRC32Folding(p, folded, crc);
+        p += folded;
+        size -= folded;
+    }
+#elif defined(VTFLIB_CRC32_ARM)
+    crc = CRC32Instructions(p, size, crc);
+    size = 0;
+#endif
+    return ~CRC32Slicing(p, size, crc);
+}
+
+} // namespace VTFLib
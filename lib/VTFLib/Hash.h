@@ -0,0 +1,20 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace VTFLib {
+
+// XXH64 of a buffer: a fast non-cryptographic hash, for telling contents apart
+// (identical output to the reference xxHash implementation)
+uint64_t XXHash64(const void* data, size_t size, uint64_t seed = 0);
+
+// CRC-32 as used by zip and VPK (identical output to zlib's crc32); pass the previous
+// result as crc to continue over more data. Uses PCLMULQDQ folding on x86 and the CRC32
+// instructions on ARMv8 when available, slicing-by-8 tables otherwise.
+uint32_t CRC32(const void* data, size_t size, uint32_t crc = 0);
+
+} // namespace VTFLib
+
+#endif // HASH_H
@@ -0,0 +1,294 @@
+#include "ImageMetrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VTFLIB_METRICS_SSE2 1
+#endif
+
+namespace VTFLib {
+
+namespace {
+
+// SSIM stabilising constants for 8-bit data, (0.01 * 255)^2 and (0.03 * 255)^2
+const double SSIM_C1 = 6.5025;
+const double SSIM_C2 = 58.5225;
+
+double PSNRFromMSE(double mse) {
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+}
+
+// Rec. 601 luma in 8.8 fixed point
+inline uint8_t Luma(const uint8_t* pixel) {
+    return static_cast<uint8_t>((77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8);
+}
+
+void CompareRow(const uint8_t* a, const uint8_t* b, uint32_t width, ImageDifference& difference) {
+    uint32_t x = 0;
+#if defined(VTFLIB_METRICS_SSE2)
+    // Four pixels at a time; the 32-bit lanes of each sum hold R, G, B and A. A row of
+    // 65535 pixels adds at most 65535 * 65025 to a square lane, which still fits.
+    const __m128i zero = _mm_setzero_si128();
+    __m128i absoluteSum = zero;
+    __m128i squaredSum = zero;
+    __m128i maxima = zero;
+    for (; x + 4 <= width; x += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x * 4));
+        __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x * 4));
+        __m128i d = _mm_or_si128(_mm_subs_epu8(p, q), _mm_subs_epu8(q, p));
+        maxima = _mm_max_epu8(maxima, d);
+        
+        __m128i low = _mm_unpacklo_epi8(d, zero);
+        __m128i high = _mm_unpackhi_epi8(d, zero);
+        __m128i pairs = _mm_add_epi16(low, high);
+        absoluteSum = _mm_add_epi32(absoluteSum, _mm_add_epi32(_mm_unpacklo_epi16(pairs, zero), _mm_unpackhi_epi16(pairs, zero)));
+        
+        __m128i lowSquares = _mm_mullo_epi16(low, low);
+        __m128i highSquares = _mm_mullo_epi16(high, high);
+        squaredSum = _mm_add_epi32(squaredSum, _mm_add_epi32(_mm_unpacklo_epi16(lowSquares, zero), _mm_unpackhi_epi16(lowSquares, zero)));
+        squaredSum = _mm_add_epi32(squaredSum, _mm_add_epi32(_mm_unpacklo_epi16(highSquares, zero), _mm_unpackhi_epi16(highSquares, zero)));
+    }
+    
+    alignas(16) uint32_t absolute[4];
+    alignas(16) uint32_t squared[4];
+    alignas(16) uint8_t maximum[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(absolute), absoluteSum);
+    _mm_store_si128(reinterpret_cast<__m128i*>(squared), squaredSum);
+    _mm_store_si128(reinterpret_cast<__m128i*>(maximum), maxima);
+    for (uint32_t c = 0; c < 4; ++c) {
+        difference.absoluteError[c] += absolute[c];
+        difference.squaredError[c] += squared[c];
+        uint8_t channelMax = std::max(std::max(maximum[c], maximum[c + 4]), std::max(maximum[c + 8], maximum[c + 12]));
+        difference.maxError[c] = std::max(difference.maxError[c], channelMax);
+    }
+#endif
+    for (; x < width; ++x) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            uint32_t d = static_cast<uint32_t>(std::abs(a[x * 4 + c] - b[x * 4 + c]));
+            difference.absoluteError[c] += d;
+            difference.squaredError[c] += d * d;
+            difference.maxError[c] = std::max(difference.maxError[c], static_cast<uint8_t>(d));
+        }
+    }
+    difference.pixels += width;
+}
+
+// Sums of x, y, x^2, y^2 and xy over one window of two luma planes
+struct WindowMoments {
+    uint64_t x = 0;
+    uint64_t y = 0;
+    uint64_t xx = 0;
+    uint64_t yy = 0;
+    uint64_t xy = 0;
+};
+
+WindowMoments SumWindow(const uint8_t* x, const uint8_t* y, uint32_t stride, uint32_t width, uint32_t height) {
+    WindowMoments moments;
+#if defined(VTFLIB_METRICS_SSE2)
+    if (width == SSIM_WINDOW_SIZE) {
+        // One row of the window is 8 bytes: SAD against zero sums it, and madd of the
+        // widened values sums products in pairs
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sums = zero;
+        __m128i squares = zero;
+        __m128i products = zero;
+        for (uint32_t row = 0; row < height; ++row) {
+            __m128i p = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + row * stride));
+            __m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + row * stride));
+            sums = _mm_add_epi64(sums, _mm_unpacklo_epi64(_mm_sad_epu8(p, zero), _mm_sad_epu8(q, zero)));
+            __m128i p16 = _mm_unpacklo_epi8(p, zero);
+            __m128i q16 = _mm_unpacklo_epi8(q, zero);
+            squares = _mm_add_epi32(squares, _mm_unpacklo_epi64(
+                _mm_add_epi32(_mm_madd_epi16(p16, p16), _mm_srli_si128(_mm_madd_epi16(p16, p16), 8)),
+                _mm_add_epi32(_mm_madd_epi16(q16, q16), _mm_srli_si128(_mm_madd_epi16(q16, q16), 8))));
+            products = _mm_add_epi32(products, _mm_madd_epi16(p16, q16));
+        }
+        alignas(16) uint64_t sum[2];
+        alignas(16) uint32_t square[4];
+        alignas(16) uint32_t product[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sum), sums);
+        _mm_store_si128(reinterpret_cast<__m128i*>(square), squares);
+        _mm_store_si128(reinterpret_cast<__m128i*>(product), products);
+        moments.x = sum[0];
+        moments.y = sum[1];
+        moments.xx = static_cast<uint64_t>(square[0]) + square[1];
+        moments.yy = static_cast<uint64_t>(square[2]) + square[3];
+        moments.xy = static_cast<uint64_t>(product[0]) + product[1] + product[2] + product[3];
+        return moments;
+    }
+#endif
+    for (uint32_t row = 0; row < height; ++row) {
+        for (uint32_t column = 0; column < width; ++column) {
+            uint32_t p = x[row * stride + column];
+            uint32_t q = y[row * stride + column];
+            moments.x += p;
+            moments.y += q;
+            moments.xx += p * p;
+            moments.yy += q * q;
+            moments.xy += p * q;
+        }
+    }
+    return moments;
+}
+
+double WindowSSIM(const WindowMoments& moments, uint32_t count) {
+    double n = count;
+    double muX = moments.x / n;
+    double muY = moments.y / n;
+    double varianceX = moments.xx / n - muX * muX;
+    double varianceY = moments.yy / n - muY * muY;
+    double covariance = moments.xy / n - muX * muY;
+    return ((2.0 * muX * muY + SSIM_C1) * (2.0 * covariance + SSIM_C2)) /
+           ((muX * muX + muY * muY + SSIM_C1) * (varianceX + varianceY + SSIM_C2));
+}
+
+} // namespace
+
+void ImageDifference::Add(const ImageDifference& other) {
+    pixels += other.pixels;
+    for (uint32_t c = 0; c < 4; ++c) {
+        absoluteError[c] += other.absoluteError[c];
+        squaredError[c] += other.squaredError[c];
+        maxError[c] = std::max(maxError[c], other.maxError[c]);
+    }
+}
+
+double ImageDifference::MeanAbsoluteError(uint32_t channel) const {
+    return pixels ? static_cast<double>(absoluteError[channel]) / pixels : 0.0;
+}
+
+double ImageDifference::MeanSquaredError(uint32_t channel) const {
+    return pixels ? static_cast<double>(squaredError[channel]) / pixels : 0.0;
+}
+
+double ImageDifference::PSNR(uint32_t channel) const {
+    return PSNRFromMSE(MeanSquaredError(channel));
+}
+
+double ImageDifference::CombinedPSNR(uint32_t channelCount) const {
+    uint64_t squared = 0;
+    for (uint32_t c = 0; c < channelCount; ++c) {
+        squared += squaredError[c];
+    }
+    return pixels ? PSNRFromMSE(static_cast<double>(squared) / (static_cast<double>(pixels) * channelCount)) : PSNRFromMSE(0.0);
+}
+
+ImageDifference ImageMetrics::Compare(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                                      uint32_t width, uint32_t height) {
+    ImageDifference difference;
+    for (uint32_t y = 0; y < height; ++y) {
+        CompareRow(a + y * strideA, b + y * strideB, width, difference);
+    }
+    return difference;
+}
+
+double ImageMetrics::SSIM(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                          uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0) {
+        return 1.0;
+    }
+    
+    // Luma planes first, so each window is read as plain bytes
+    std::vector<uint8_t> lumaA(static_cast<size_t>(width) * height);
+    std::vector<uint8_t> lumaB(lumaA.size());
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* rowA = a + y * strideA;
+        const uint8_t* rowB = b + y * strideB;
+        for (uint32_t x = 0; x < width; ++x) {
+            lumaA[static_cast<size_t>(y) * width + x] = Luma(rowA + x * 4);
+            lumaB[static_cast<size_t>(y) * width + x] = Luma(rowB + x * 4);
+        }
+    }
+    
+    uint32_t windowWidth = std::min(width, SSIM_WINDOW_SIZE);
+    uint32_t windowHeight = std::min(height, SSIM_WINDOW_SIZE);
+    double total = 0.0;
+    uint32_t windows = 0;
+    for (uint32_t y = 0; y + windowHeight <= height; y += windowHeight) {
+        for (uint32_t x = 0; x + windowWidth <= width; x += windowWidth) {
+            size_t offset = static_cast<size_t>(y) * width + x;
+            WindowMoments moments = SumWindow(lumaA.data() + offset, lumaB.data() + offset, width, windowWidth, windowHeight);
+            total += WindowSSIM(moments, windowWidth * windowHeight);
+            windows++;
+        }
+    }
+    return total / windows;
+}
+
+void ImageMetrics::AbsoluteDifference(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                                      uint32_t width, uint32_t height, uint8_t* out, size_t strideOut,
+                                      uint32_t gain) {
+    // 255 * 128 still fits the signed 16-bit lanes packus saturates from
+    gain = std::min(gain, 128u);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* rowA = a + y * strideA;
+        const uint8_t* rowB = b + y * strideB;
+        uint8_t* dst = out + y * strideOut;
+        uint32_t x = 0;
+#if defined(VTFLIB_METRICS_SSE2)
+        // Widened to 16 bits for the gain, then packed back with unsigned saturation
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i factor = _mm_set1_epi16(static_cast<short>(gain));
+        const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        for (; x + 4 <= width; x += 4) {
+            __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowA + x * 4));
+            __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowB + x * 4));
+            __m128i d = _mm_or_si128(_mm_subs_epu8(p, q), _mm_subs_epu8(q, p));
+            __m128i low = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), factor);
+            __m128i high = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), factor);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+        }
+#endif
+        for (; x < width; ++x) {
+            for (uint32_t c = 0; c < 3; ++c) {
+                uint32_t d = static_cast<uint32_t>(std::abs(rowA[x * 4 + c] - rowB[x * 4 + c]));
+                dst[x * 4 + c] = static_cast<uint8_t>(std::min(d * gain, 255u));
+            }
+            dst[x * 4 + 3] = 255;
+        }
+    }
+}
+
+void ImageMetrics::Downsample(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out) {
+    uint32_t outWidth = std::max(1u, width / 2);
+    uint32_t outHeight = std::max(1u, height / 2);
+    size_t stride = static_cast<size_t>(width) * 4;
+    for (uint32_t y = 0; y < outHeight; ++y) {
+        const uint8_t* row0 = rgba + std::min(2 * y, height - 1) * stride;
+        const uint8_t* row1 = rgba + std::min(2 * y + 1, height - 1) * stride;
+        uint8_t* dst = out + static_cast<size_t>(y) * outWidth * 4;
+        uint32_t x = 0;
+#if defined(VTFLIB_METRICS_SSE2)
+        // Four source pixels make two: add the rows, then each pixel to its neighbour
+        if (width >= 2) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i rounding = _mm_set1_epi16(2);
+            for (; x + 2 <= outWidth; x += 2) {
+                __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+                __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(q, zero));
+                __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(q, zero));
+                low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+                high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+                __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(low, high), rounding), 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(sum, zero));
+            }
+        }
+#endif
+        for (; x < outWidth; ++x) {
+            const uint8_t* p0 = row0 + std::min(2 * x, width - 1) * 4;
+            const uint8_t* p1 = row0 + std::min(2 * x + 1, width - 1) * 4;
+            const uint8_t* q0 = row1 + std::min(2 * x, width - 1) * 4;
+            const uint8_t* q1 = row1 + std::min(2 * x + 1, width - 1) * 4;
+            for (uint32_t c = 0; c < 4; ++c) {
+                dst[x * 4 + c] = static_cast<uint8_t>((p0[c] + p1[c] + q0[c] + q1[c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+} // namespace VTFLib
@@ -0,0 +1,58 @@
+#ifndef IMAGEMETRICS_H
+#define IMAGEMETRICS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace VTFLib {
+
+// Side of the square windows SSIM is averaged over
+const uint32_t SSIM_WINDOW_SIZE = 8;
+
+// Per-channel differences between two RGBA8888 images (R, G, B, A)
+struct ImageDifference {
+    uint64_t pixels = 0;
+    uint64_t absoluteError[4] = {};
+    uint64_t squaredError[4] = {};
+    uint8_t maxError[4] = {};
+    
+    // Merge the differences of another region
+    void Add(const ImageDifference& other);
+    
+    double MeanAbsoluteError(uint32_t channel) const;
+    double MeanSquaredError(uint32_t channel) const;
+    
+    // Peak signal-to-noise ratio in dB of one channel, or of the first channelCount
+    // together (RGB by default); infinity when they are identical
+    double PSNR(uint32_t channel) const;
+    double CombinedPSNR(uint32_t channelCount = 3) const;
+};
+
+// SSE2 image comparison kernels with scalar fallbacks. Strides are in bytes, so any
+// region of a larger image can be compared in place.
+class ImageMetrics {
+public:
+    // Differences over a width x height region of two RGBA8888 images
+    static ImageDifference Compare(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                                   uint32_t width, uint32_t height);
+    
+    // Mean structural similarity of the luma of two RGBA8888 images, from 1 for identical
+    // images down to around 0 for unrelated ones. Windows are SSIM_WINDOW_SIZE square and
+    // don't overlap; images narrower or shorter than that are one window across.
+    static double SSIM(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                       uint32_t width, uint32_t height);
+    
+    // Per-channel |a - b| of the RGB of two RGBA8888 regions, multiplied by gain (at most
+    // 128) and saturated so small errors show up, into an opaque RGBA8888 image
+    static void AbsoluteDifference(const uint8_t* a, size_t strideA, const uint8_t* b, size_t strideB,
+                                   uint32_t width, uint32_t height, uint8_t* out, size_t strideOut,
+                                   uint32_t gain = 1);
+    
+    // 2x2 box filter of an RGBA8888 image into max(1, width / 2) x max(1, height / 2), the
+    // size of its next mip; an odd last row or column is dropped, as in the mip chain
+    static void Downsample(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out);
+};
+
+} // namespace VTFLib
+
+#endif // IMAGEMETRICS_H
@@ -0,0 +1,364 @@
+#include "Inflate.h"
+#include <cstring>
+
+namespace VTFLib {
+
+namespace {
+
+const int MAX_CODE_BITS = 15;
+const int MAX_LITLEN_CODES = 288;
+const int MAX_DIST_CODES = 30;
+
+// Codes up to this long resolve with one table lookup; longer ones walk the canonical code
+const int FAST_BITS = 10;
+
+const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Order in which code length code lengths are stored in a dynamic block header
+const uint8_t CODE_LENGTH_ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// Canonical Huffman code: per-length counts and symbols sorted by code, plus a lookup
+// table indexed by the next FAST_BITS input bits holding (symbol << 4) | length
+struct Huffman {
+    uint16_t count[MAX_CODE_BITS + 1];
+    uint16_t symbol[MAX_LITLEN_CODES];
+    uint16_t fast[1 << FAST_BITS];
+};
+
+// LSB-first bit reader. Reading past the end yields zero bits and sets overrun.
+struct BitReader {
+    const uint8_t* src;
+    size_t size;
+    size_t pos;
+    uint64_t bits;
+    int bitCount;
+    bool overrun;
+    
+    void Refill() {
+        while (bitCount <= 56) {
+            uint64_t byte = 0;
+            if (pos < size) {
+                byte = src[pos];
+            } else if (pos > size + 8) {
+                overrun = true;
+            }
+            pos++;
+            bits |= byte << bitCount;
+            bitCount += 8;
+        }
+    }
+    
+    uint32_t Peek(int count) {
+        if (bitCount < count) {
+            Refill();
+        }
+        return static_cast<uint32_t>(bits & ((uint64_t(1) << count) - 1));
+    }
+    
+    void Consume(int count) {
+        bits >>= count;
+        bitCount -= count;
+    }
+    
+    uint32_t Read(int count) {
+        if (count == 0) {
+            return 0;
+        }
+        uint32_t value = Peek(count);
+        Consume(count);
+        return value;
+    }
+    
+    // Bytes of real input consumed so far, once aligned to a byte boundary
+    size_t BytePosition() const {
+        return pos - bitCount / 8;
+    }
+    
+    bool Overran() const {
+        return overrun || BytePosition() > size;
+    }
+};
+
+// Build a decoder from code lengths. Incomplete codes are allowed (a single distance code
+// is legal); over-subscribed ones are not.
+bool BuildHuffman(Huffman& h, const uint8_t* lengths, int count) {
+    memset(h.count, 0, sizeof(h.count));
+    for (int i = 0; i < count; ++i) {
+        h.count[lengths[i]]++;
+    }
+    h.count[0] = 0;
+    
+    int left = 1;
+    for (int len = 1; len <= MAX_CODE_BITS; ++len) {
+        left <<= 1;
+        left -= h.count[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+    
+    uint16_t offsets[MAX_CODE_BITS + 2];
+    offsets[1] = 0;
+    for (int len = 1; len <= MAX_CODE_BITS; ++len) {
+        offsets[len + 1] = offsets[len] + h.count[len];
+    }
+    for (int i = 0; i < count; ++i) {
+        if (lengths[i] != 0) {
+            h.symbol[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+        }
+    }
+    
+    // Fill the lookup table; codes are stored MSB-first, so index by the reversed code
+    memset(h.fast, 0, sizeof(h.fast));
+    int code = 0;
+    int index = 0;
+    for (int len = 1; len <= FAST_BITS; ++len) {
+        for (int i = 0; i < h.count[len]; ++i, ++index, ++code) {
+            int reversed = 0;
+            for (int b = 0; b < len; ++b) {
+                reversed |= ((code >> b) & 1) << (len - 1 - b);
+            }
+            uint16_t entry = static_cast<uint16_t>((h.symbol[index] << 4) | len);
+            for (int fill = reversed; fill < (1 << FAST_BITS); fill += 1 << len) {
+                h.fast[fill] = entry;
+            }
+        }
+        code <<= 1;
+    }
+    return true;
+}
+
+// Decode one symbol (-1 on an invalid code)
+int DecodeSymbol(BitReader& in, const Huffman& h) {
+    uint16_t entry = h.fast[in.Peek(FAST_BITS)];
+    if (entry != 0) {
+        in.Consume(entry & 15);
+        return entry >> 4;
+    }
+    
+    // Longer than FAST_BITS: walk the canonical code one bit at a time
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len <= MAX_CODE_BITS; ++len) {
+        code |= static_cast<int>(in.Read(1));
+        int count = h.count[len];
+        if (code - count < first) {
+            return h.symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+bool InflateCodes(BitReader& in, const Huffman& litlen, const Huffman& dist,
+                  uint8_t* dst, size_t dstSize, size_t& out) {
+    for (;;) {
+        int symbol = DecodeSymbol(in, litlen);
+        if (symbol < 0) {
+            return false;
+        }
+        
+        if (symbol < 256) {
+            if (out >= dstSize) {
+                return false;
+            }
+            dst[out++] = static_cast<uint8_t>(symbol);
+        } else if (symbol == 256) {
+            return !in.Overran();
+        } else {
+            symbol -= 257;
+            if (symbol >= 29) {
+                return false;
+            }
+            size_t length = LENGTH_BASE[symbol] + in.Read(LENGTH_EXTRA[symbol]);
+            
+            int distSymbol = DecodeSymbol(in, dist);
+            if (distSymbol < 0 || distSymbol >= MAX_DIST_CODES) {
+                return false;
+            }
+            size_t distance = DIST_BASE[distSymbol] + in.Read(DIST_EXTRA[distSymbol]);
+            
+            if (distance > out || length > dstSize - out) {
+                return false;
+            }
+            
+            // Byte-by-byte so overlapping matches repeat correctly
+            const uint8_t* from = dst + out - distance;
+            uint8_t* to = dst + out;
+            for (size_t i = 0; i < length; ++i) {
+                to[i] = from[i];
+            }
+            out += length;
+        }
+        
+        if (in.Overran()) {
+            return false;
+        }
+    }
+}
+
+bool InflateStored(BitReader& in, uint8_t* dst, size_t dstSize, size_t& out) {
+    // Drop to the byte boundary, then rewind past whole bytes still buffered
+    in.Consume(in.bitCount % 8);
+    size_t pos = in.BytePosition();
+    in.bits = 0;
+    in.bitCount = 0;
+    
+    if (pos + 4 > in.size) {
+        return false;
+    }
+    uint16_t length = static_cast<uint16_t>(in.src[pos] | (in.src[pos + 1] << 8));
+    uint16_t complement = static_cast<uint16_t>(in.src[pos + 2] | (in.src[pos + 3] << 8));
+    pos += 4;
+    if (length != static_cast<uint16_t>(~complement)) {
+        return false;
+    }
+    if (length > in.size - pos || length > dstSize - out) {
+        return false;
+    }
+    
+    memcpy(dst + out, in.src + pos, length);
+    out += length;
+    in.pos = pos + length;
+    return true;
+}
+
+bool InflateFixed(BitReader& in, uint8_t* dst, size_t dstSize, size_t& out) {
+    static Huffman litlen;
+    static Huffman dist;
+    static bool built = [] {
+        uint8_t lengths[MAX_LITLEN_CODES];
+        int i = 0;
+        for (; i < 144; ++i) lengths[i] = 8;
+        for (; i < 256; ++i) lengths[i] = 9;
+        for (; i < 280; ++i) lengths[i] = 7;
+        for (; i < 288; ++i) lengths[i] = 8;
+        BuildHuffman(litlen, lengths, MAX_LITLEN_CODES);
+        for (i = 0; i < MAX_DIST_CODES; ++i) lengths[i] = 5;
+        BuildHuffman(dist, lengths, MAX_DIST_CODES);
+        return true;
+    }();
+    (void)built;
+    
+    return InflateCodes(in, litlen, dist, dst, dstSize, out);
+}
+
+bool InflateDynamic(BitReader& in, uint8_t* dst, size_t dstSize, size_t& out) {
+    int litlenCount = static_cast<int>(in.Read(5)) + 257;
+    int distCount = static_cast<int>(in.Read(5)) + 1;
+    int codeLengthCount = static_cast<int>(in.Read(4)) + 4;
+    if (litlenCount > 286 || distCount > MAX_DIST_CODES) {
+        return false;
+    }
+    
+    uint8_t lengths[MAX_LITLEN_CODES + MAX_DIST_CODES];
+    memset(lengths, 0, sizeof(lengths));
+    for (int i = 0; i < codeLengthCount; ++i) {
+        lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(in.Read(3));
+    }
+    
+    Huffman codeLengths;
+    if (!BuildHuffman(codeLengths, lengths, 19)) {
+        return false;
+    }
+    
+    // Literal/length and distance code lengths, run-length coded
+    int index = 0;
+    while (index < litlenCount + distCount) {
+        int symbol = DecodeSymbol(in, codeLengths);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = static_cast<uint8_t>(symbol);
+            continue;
+        }
+        
+        uint8_t repeated = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return false;
+            }
+            repeated = lengths[index - 1];
+            repeat = 3 + static_cast<int>(in.Read(2));
+        } else if (symbol == 17) {
+            repeat = 3 + static_cast<int>(in.Read(3));
+        } else {
+            repeat = 11 + static_cast<int>(in.Read(7));
+        }
+        if (index + repeat > litlenCount + distCount) {
+            return false;
+        }
+        while (repeat--) {
+            lengths[index++] = repeated;
+        }
+    }
+    
+    // A block without an end-of-block code can never finish
+    if (lengths[256] == 0) {
+        return false;
+    }
+    
+    Huffman litlen;
+    Huffman dist;
+    if (!BuildHuffman(litlen, lengths, litlenCount) ||
+        !BuildHuffman(dist, lengths + litlenCount, distCount)) {
+        return false;
+    }
+    
+    return InflateCodes(in, litlen, dist, dst, dstSize, out);
+}
+
+} // namespace
+
+bool Inflate(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    BitReader in = { src, srcSize, 0, 0, 0, false };
+    size_t out = 0;
+    
+    bool last = false;
+    while (!last) {
+        last = in.Read(1) != 0;
+        uint32_t type = in.Read(2);
+        
+        bool ok;
+        if (type == 0) {
+            ok = InflateStored(in, dst, dstSize, out);
+        } else if (type == 1) {
+            ok = InflateFixed(in, dst, dstSize, out);
+        } else if (type == 2) {
+            ok = InflateDynamic(in, dst, dstSize, out);
+        } else {
+            ok = false;
+        }
+        
+        if (!ok || in.Overran()) {
+            return false;
+        }
+    }
+    
+    return out == dstSize;
+}
+
+} // namespace VTFLib
@@ -0,0 +1,15 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace VTFLib {
+
+// Decompress a raw DEFLATE stream (RFC 1951, as stored in zip entries) into dst.
+// Succeeds only if the stream is valid and produces exactly dstSize bytes.
+bool Inflate(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+} // namespace VTFLib
+
+#endif // INFLATE_H
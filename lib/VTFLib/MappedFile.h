@@ -0,0 +1,42 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace VTFLib {
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first access, so
+// mapping a multi-gigabyte archive costs nothing until its entries are actually read.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool Open(const std::string& filename);
+    void Close();
+    
+    // Map a file into a new shareable object (nullptr on failure)
+    static std::shared_ptr<const MappedFile> Map(const std::string& filename);
+    
+    const uint8_t* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+    bool IsOpen() const { return data_ != nullptr; }
+    
+private:
+    const uint8_t* data_;
+    size_t size_;
+#if defined(_WIN32)
+    void* fileHandle_;
+    void* mappingHandle_;
+#endif
+};
+
+} // namespace VTFLib
+
+#endif // MAPPEDFILE_H
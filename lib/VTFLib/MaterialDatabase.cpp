@@ -0,0 +1,298 @@
+#include "MaterialDatabase.h"
+#include "GameIndex.h"
+#include "ThreadPool.h"
+#include "VMTFile.h"
+#include <algorithm>
+
+namespace VTFLib {
+
+namespace {
+
+std::string ToLower(std::string_view text) {
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    });
+    return lower;
+}
+
+bool IsTextureParameter(const std::string& name) {
+    for (const char* parameter : VMT_TEXTURE_PARAMETERS) {
+        if (name == parameter) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// Rows parsed by one thread, with strings interned locally until the serial merge
+struct MaterialDatabase::Chunk {
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, StringId> ids;
+    
+    std::vector<StringId> paths;
+    std::vector<StringId> shaders;
+    std::vector<uint32_t> parameterCounts;
+    std::vector<StringId> parameterNames;
+    std::vector<StringId> parameterValues;
+    size_t failedCount = 0;
+    
+    StringId Intern(std::string_view text) {
+        auto it = ids.find(text);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        StringId id = static_cast<StringId>(strings.size());
+        const std::string& stored = strings.emplace_back(text);
+        ids.emplace(stored, id);
+        return id;
+    }
+};
+
+MaterialDatabase::MaterialDatabase() : failedCount_(0) {
+    Clear();
+}
+
+MaterialDatabase::~MaterialDatabase() {
+}
+
+void MaterialDatabase::Clear() {
+    strings_.clear();
+    stringIds_.clear();
+    textureKeys_.clear();
+    paths_.clear();
+    shaders_.clear();
+    firstParameter_.assign(1, 0);
+    parameterNames_.clear();
+    parameterValues_.clear();
+    failedCount_ = 0;
+    
+    Intern(std::string_view());
+}
+
+bool MaterialDatabase::Build(const std::vector<std::string>& filenames) {
+    return Build(filenames, [&filenames](uint32_t i, VMTFile& material) {
+        return material.Load(filenames[i]);
+    });
+}
+
+bool MaterialDatabase::Build(const GameIndex& game) {
+    std::vector<std::string> paths = game.GetFiles(".vmt");
+    return Build(paths, [&game, &paths](uint32_t i, VMTFile& material) {
+        GameFileLocation location;
+        return game.Find(paths[i], location) && game.LoadVMT(location, material);
+    });
+}
+
+bool MaterialDatabase::Build(const std::vector<std::string>& paths,
+                             const std::function<bool(uint32_t, VMTFile&)>& load) {
+    Clear();
+    
+    // Each chunk parses into its own table, so the threads share nothing
+    uint32_t count = static_cast<uint32_t>(paths.size());
+    std::vector<Chunk> chunks((count + MATERIAL_PARSE_GRAIN - 1) / MATERIAL_PARSE_GRAIN);
+    ThreadPool::Shared().ParallelFor(count, MATERIAL_PARSE_GRAIN,
+        [&paths, &load, &chunks](uint32_t begin, uint32_t end) {
+            Chunk& chunk = chunks[begin / MATERIAL_PARSE_GRAIN];
+            chunk.Intern(std::string_view());
+            for (uint32_t i = begin; i < end; ++i) {
+                VMTFile material;
+                if (load(i, material)) {
+                    ParseMaterial(material, paths[i], chunk);
+                } else {
+                    chunk.failedCount++;
+                }
+            }
+        });
+    
+    // Merge in chunk order so rows keep the order of the input
+    for (Chunk& chunk : chunks) {
+        Merge(chunk);
+    }
+    
+    textureKeys_.assign(strings_.size(), false);
+    for (const char* parameter : VMT_TEXTURE_PARAMETERS) {
+        StringId id = FindString(parameter);
+        if (id != 0) {
+            textureKeys_[id] = true;
+        }
+    }
+    
+    return !paths_.empty();
+}
+
+std::shared_ptr<const MaterialDatabase> MaterialDatabase::Open(const std::vector<std::string>& filenames) {
+    auto database = std::make_shared<MaterialDatabase>();
+    if (!database->Build(filenames)) {
+        return nullptr;
+    }
+    return database;
+}
+
+std::shared_ptr<const MaterialDatabase> MaterialDatabase::Open(const GameIndex& game) {
+    auto database = std::make_shared<MaterialDatabase>();
+    if (!database->Build(game)) {
+        return nullptr;
+    }
+    return database;
+}
+
+void MaterialDatabase::ParseMaterial(const VMTFile& material, const std::string& path, Chunk& chunk) {
+    std::string shader = ToLower(material.GetShader());
+    
+    uint32_t parameterCount = 0;
+    auto addParameters = [&chunk, &parameterCount](const VMTNode& block) {
+        for (const VMTNode& child : block.GetChildren()) {
+            // Blocks such as Proxies carry no material parameters
+            if (!child.GetChildren().empty()) {
+                continue;
+            }
+            std::string name = ToLower(child.GetName());
+            std::string value = IsTextureParameter(name) ? NormalizeTexturePath(child.GetValue())
+                                                         : std::string(child.GetValue());
+            chunk.parameterNames.push_back(chunk.Intern(name));
+            chunk.parameterValues.push_back(chunk.Intern(value));
+            parameterCount++;
+        }
+    };
+    
+    for (const VMTNode* block : material.GetParameterBlocks()) {
+        addParameters(*block);
+    }
+    
+    chunk.paths.push_back(chunk.Intern(path));
+    chunk.shaders.push_back(chunk.Intern(shader));
+    chunk.parameterCounts.push_back(parameterCount);
+}
+
+void MaterialDatabase::Merge(Chunk& chunk) {
+    failedCount_ += chunk.failedCount;
+    
+    std::vector<StringId> remap;
+    remap.reserve(chunk.strings.size());
+    for (const std::string& text : chunk.strings) {
+        remap.push_back(Intern(text));
+    }
+    
+    for (size_t i = 0; i < chunk.paths.size(); ++i) {
+        paths_.push_back(remap[chunk.paths[i]]);
+        shaders_.push_back(remap[chunk.shaders[i]]);
+        firstParameter_.push_back(firstParameter_.back() + chunk.parameterCounts[i]);
+    }
+    for (size_t i = 0; i < chunk.parameterNames.size(); ++i) {
+        parameterNames_.push_back(remap[chunk.parameterNames[i]]);
+        parameterValues_.push_back(remap[chunk.parameterValues[i]]);
+    }
+    
+    chunk = Chunk();
+}
+
+MaterialDatabase::StringId MaterialDatabase::Intern(std::string_view text) {
+    auto it = stringIds_.find(text);
+    if (it != stringIds_.end()) {
+        return it->second;
+    }
+    StringId id = static_cast<StringId>(strings_.size());
+    const std::string& stored = strings_.emplace_back(text);
+    stringIds_.emplace(stored, id);
+    return id;
+}
+
+MaterialDatabase::StringId MaterialDatabase::FindString(std::string_view text) const {
+    auto it = stringIds_.find(text);
+    return it != stringIds_.end() ? it->second : 0;
+}
+
+const std::string& MaterialDatabase::GetParameter(size_t material, std::string_view name) const {
+    StringId id = FindString(ToLower(name));
+    if (id != 0) {
+        for (uint32_t p = firstParameter_[material]; p < firstParameter_[material + 1]; ++p) {
+            if (parameterNames_[p] == id) {
+                return strings_[parameterValues_[p]];
+            }
+        }
+    }
+    return strings_[0];
+}
+
+std::vector<std::string> MaterialDatabase::GetTextureReferences(size_t material) const {
+    std::vector<std::string> textures;
+    for (uint32_t p = firstParameter_[material]; p < firstParameter_[material + 1]; ++p) {
+        if (textureKeys_[parameterNames_[p]] && parameterValues_[p] != 0) {
+            textures.push_back(strings_[parameterValues_[p]]);
+        }
+    }
+    return textures;
+}
+
+std::vector<std::pair<std::string, uint32_t>> MaterialDatabase::GetShaders() const {
+    std::unordered_map<StringId, uint32_t> counts;
+    for (StringId shader : shaders_) {
+        counts[shader]++;
+    }
+    
+    std::vector<std::pair<std::string, uint32_t>> shaders;
+    shaders.reserve(counts.size());
+    for (const auto& count : counts) {
+        shaders.emplace_back(strings_[count.first], count.second);
+    }
+    std::sort(shaders.begin(), shaders.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return shaders;
+}
+
+std::vector<uint32_t> MaterialDatabase::FindMaterialsWithParameter(std::string_view name) const {
+    std::vector<uint32_t> materials;
+    StringId id = FindString(ToLower(name));
+    if (id == 0) {
+        return materials;
+    }
+    
+    for (uint32_t m = 0; m < paths_.size(); ++m) {
+        for (uint32_t p = firstParameter_[m]; p < firstParameter_[m + 1]; ++p) {
+            if (parameterNames_[p] == id) {
+                materials.push_back(m);
+                break;
+            }
+        }
+    }
+    return materials;
+}
+
+std::vector<uint32_t> MaterialDatabase::FindMaterialsWithShader(std::string_view shader) const {
+    std::vector<uint32_t> materials;
+    StringId id = FindString(ToLower(shader));
+    if (id == 0) {
+        return materials;
+    }
+    
+    for (uint32_t m = 0; m < shaders_.size(); ++m) {
+        if (shaders_[m] == id) {
+            materials.push_back(m);
+        }
+    }
+    return materials;
+}
+
+std::string MaterialDatabase::NormalizeTexturePath(std::string_view path) {
+    std::string normalized = ToLower(path);
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    normalized.erase(std::unique(normalized.begin(), normalized.end(), [](char a, char b) {
+        return a == '/' && b == '/';
+    }), normalized.end());
+    
+    size_t start = normalized.find_first_not_of('/');
+    normalized.erase(0, std::min(start, normalized.size()));
+    if (normalized.compare(0, 10, "materials/") == 0) {
+        normalized.erase(0, 10);
+    }
+    if (normalized.size() > 4 && normalized.compare(normalized.size() - 4, 4, ".vtf") == 0) {
+        normalized.resize(normalized.size() - 4);
+    }
+    return normalized;
+}
+
+} // namespace VTFLib
@@ -0,0 +1,98 @@
+#ifndef MATERIALDATABASE_H
+#define MATERIALDATABASE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace VTFLib {
+
+class GameIndex;
+class VMTFile;
+
+// Materials parsed per thread pool chunk
+const uint32_t MATERIAL_PARSE_GRAIN = 64;
+
+// Every material of a directory or game install, parsed in parallel into a columnar
+// table. Shaders, parameter names and values are interned, so a query over the whole
+// set is a scan of integer columns. Thread-safe once built.
+class MaterialDatabase {
+public:
+    // Id of an interned string; 0 is the empty string
+    using StringId = uint32_t;
+    
+    MaterialDatabase();
+    ~MaterialDatabase();
+    
+    // Parse every VMT in the list; unreadable files are counted and skipped
+    bool Build(const std::vector<std::string>& filenames);
+    
+    // Parse every VMT of a game install, reading those in VPKs in place
+    bool Build(const GameIndex& game);
+    
+    // Build into a new shareable, read-only object (nullptr if nothing parsed)
+    static std::shared_ptr<const MaterialDatabase> Open(const std::vector<std::string>& filenames);
+    static std::shared_ptr<const MaterialDatabase> Open(const GameIndex& game);
+    
+    size_t GetMaterialCount() const { return paths_.size(); }
+    size_t GetFailedCount() const { return failedCount_; }
+    
+    // Columns of one material
+    const std::string& GetPath(size_t material) const { return strings_[paths_[material]]; }
+    const std::string& GetShader(size_t material) const { return strings_[shaders_[material]]; }
+    
+    // A top-level parameter of one material, or "" if unset (name is case-insensitive)
+    const std::string& GetParameter(size_t material, std::string_view name) const;
+    
+    // Texture paths a material references, normalized as by NormalizeTexturePath
+    std::vector<std::string> GetTextureReferences(size_t material) const;
+    
+    // Every shader in use with its material count, most used first
+    std::vector<std::pair<std::string, uint32_t>> GetShaders() const;
+    
+    // Materials that set a parameter (e.g. "$envmap"), in build order
+    std::vector<uint32_t> FindMaterialsWithParameter(std::string_view name) const;
+    
+    // Materials that use a shader (case-insensitive), in build order
+    std::vector<uint32_t> FindMaterialsWithShader(std::string_view shader) const;
+    
+    // Lowercase, forward slashes, no "materials/" prefix and no ".vtf" extension
+    static std::string NormalizeTexturePath(std::string_view path);
+    
+private:
+    struct Chunk;
+    
+    // Interned strings; a deque never moves its elements, so the map's views stay valid
+    std::deque<std::string> strings_;
+    std::unordered_map<std::string_view, StringId> stringIds_;
+    std::vector<bool> textureKeys_;  // by StringId: whether the name is a texture parameter
+    
+    // One row per material
+    std::vector<StringId> paths_;
+    std::vector<StringId> shaders_;
+    std::vector<uint32_t> firstParameter_;  // parameter rows [first[i], first[i + 1])
+    
+    // One row per top-level parameter
+    std::vector<StringId> parameterNames_;
+    std::vector<StringId> parameterValues_;
+    
+    size_t failedCount_;
+    
+    void Clear();
+    bool Build(const std::vector<std::string>& paths,
+               const std::function<bool(uint32_t, VMTFile&)>& load);
+    StringId Intern(std::string_view text);
+    StringId FindString(std::string_view text) const;
+    void Merge(Chunk& chunk);
+    static void ParseMaterial(const VMTFile& material, const std::string& path, Chunk& chunk);
+};
+
+} // namespace VTFLib
+
+#endif // MATERIALDATABASE_H
@@ -0,0 +1,121 @@
+#include "MipChainChecker.h"
+#include "ImageMetrics.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace VTFLib {
+
+namespace {
+
+uint32_t MipWidth(const VTFFile& file, uint32_t mipmap) {
+    return std::max(1, file.GetWidth() >> mipmap);
+}
+
+uint32_t MipHeight(const VTFFile& file, uint32_t mipmap) {
+    return std::max(1, file.GetHeight() >> mipmap);
+}
+
+} // namespace
+
+bool MipChainReport::HasOutliers() const {
+    return std::any_of(mips.begin(), mips.end(), [](const MipComparison& mip) { return mip.outlier; });
+}
+
+const MipComparison* MipChainReport::GetWorst() const {
+    auto worst = std::min_element(mips.begin(), mips.end(),
+                                  [](const MipComparison& a, const MipComparison& b) { return a.ssim < b.ssim; });
+    return worst == mips.end() ? nullptr : &*worst;
+}
+
+bool MipChainChecker::Check(const VTFFile& file, std::vector<MipComparison>& mips, uint32_t frame) {
+    mips.clear();
+    if (!file.IsLoaded() || frame >= file.GetFrameCount()) {
+        return false;
+    }
+    
+    // Only mips big enough to judge are compared, and decoded along with their parents
+    uint32_t compared = 0;
+    while (compared + 1 < file.GetMipmapCount() &&
+           MipWidth(file, compared + 1) * MipHeight(file, compared + 1) >= MIP_CHECK_MIN_PIXELS) {
+        compared++;
+    }
+    if (compared == 0) {
+        return true;
+    }
+    
+    std::vector<std::unique_ptr<uint8_t[]>> levels(compared + 1);
+    std::atomic<bool> decoded(true);
+    ThreadPool::Shared().ParallelFor(compared + 1, 1, [&file, &levels, &decoded, frame](uint32_t begin, uint32_t end) {
+        for (uint32_t mipmap = begin; mipmap < end; ++mipmap) {
+            levels[mipmap].reset(new uint8_t[static_cast<size_t>(MipWidth(file, mipmap)) * MipHeight(file, mipmap) * 4]);
+            if (!file.GetImageData(levels[mipmap].get(), frame, mipmap)) {
+                decoded = false;
+            }
+        }
+    });
+    if (!decoded) {
+        return false;
+    }
+    
+    mips.resize(compared);
+    ThreadPool::Shared().ParallelFor(compared, 1, [&file, &levels, &mips](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            uint32_t mipmap = i + 1;
+            uint32_t width = MipWidth(file, mipmap);
+            uint32_t height = MipHeight(file, mipmap);
+            std::unique_ptr<uint8_t[]> expected(new uint8_t[static_cast<size_t>(width) * height * 4]);
+            ImageMetrics::Downsample(levels[mipmap - 1].get(), MipWidth(file, mipmap - 1), MipHeight(file, mipmap - 1),
+                                     expected.get());
+            
+            MipComparison& mip = mips[i];
+            mip.mipmap = mipmap;
+            mip.width = static_cast<uint16_t>(width);
+            mip.height = static_cast<uint16_t>(height);
+            mip.psnr = ImageMetrics::Compare(levels[mipmap].get(), width * 4, expected.get(), width * 4, width, height).CombinedPSNR();
+            mip.ssim = ImageMetrics::SSIM(levels[mipmap].get(), width * 4, expected.get(), width * 4, width, height);
+            mip.outlier = mip.ssim < MIP_OUTLIER_SSIM || mip.psnr < MIP_OUTLIER_PSNR;
+        }
+    });
+    return true;
+}
+
+std::vector<MipChainReport> MipChainChecker::CheckFiles(const std::vector<std::string>& filenames,
+                                                        BatchProgress* progress) {
+    std::vector<MipChainReport> reports(filenames.size());
+    if (progress) {
+        progress->total += filenames.size();
+    }
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(filenames.size()), MIP_CHECK_GRAIN,
+        [&filenames, &reports, progress](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end && !(progress && progress->IsCancelled()); ++i) {
+                // Loaded in place over the mapping; unreadable files are VTFValidator's business
+                std::shared_ptr<const MappedFile> mapping = MappedFile::Map(filenames[i]);
+                VTFFile file;
+                if (!mapping || !file.Load(mapping->GetData(), mapping->GetSize(), mapping)) {
+                    continue;
+                }
+                reports[i].path = filenames[i];
+                Check(file, reports[i].mips);
+            }
+            if (progress) {
+                progress->done += end - begin;
+            }
+        });
+    
+    std::vector<MipChainReport> flagged;
+    for (MipChainReport& report : reports) {
+        if (report.HasOutliers()) {
+            flagged.push_back(std::move(report));
+        }
+    }
+    std::stable_sort(flagged.begin(), flagged.end(), [](const MipChainReport& a, const MipChainReport& b) {
+        return a.GetWorst()->ssim < b.GetWorst()->ssim;
+    });
+    return flagged;
+}
+
+} // namespace VTFLib
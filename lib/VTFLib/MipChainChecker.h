@@ -0,0 +1,61 @@
+#ifndef MIPCHAINCHECKER_H
+#define MIPCHAINCHECKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VTFLib {
+
+class VTFFile;
+struct BatchProgress;
+
+// Files checked per thread pool chunk; each decodes a whole mip chain
+const uint32_t MIP_CHECK_GRAIN = 2;
+
+// Mips with fewer pixels than this are too small to judge and aren't compared
+const uint32_t MIP_CHECK_MIN_PIXELS = 16;
+
+// A mip is an outlier when its luma SSIM against the downsampled parent falls below this
+// (a different image), or its RGB PSNR does (retinted or repainted with the same shapes).
+// Sharper mip filters and block compression stay well above both, even on small mips.
+const double MIP_OUTLIER_SSIM = 0.5;
+const double MIP_OUTLIER_PSNR = 18.0;
+
+// How well one mip matches a 2x2 box filter of the mip above it
+struct MipComparison {
+    uint32_t mipmap;
+    uint16_t width;
+    uint16_t height;
+    double psnr;   // RGB, in dB; infinity when identical
+    double ssim;   // luma
+    bool outlier;
+};
+
+// The mips of one texture that don't look like a downsample of their parent
+struct MipChainReport {
+    std::string path;
+    std::vector<MipComparison> mips;  // every mip compared, smallest index first
+    
+    bool HasOutliers() const;
+    const MipComparison* GetWorst() const;  // lowest SSIM (nullptr without comparisons)
+};
+
+// Finds hand-edited or mismatched mips, which shimmer in game but look fine one level
+// at a time in the viewer. Every mip is decoded and compared with the box-filtered mip
+// above it using the SSE2 PSNR and SSIM kernels of ImageMetrics.
+class MipChainChecker {
+public:
+    // Compare every mip of one frame of a texture with its parent; false if the texture
+    // can't be decoded
+    static bool Check(const VTFFile& file, std::vector<MipComparison>& mips, uint32_t frame = 0);
+    
+    // Memory-map and check files in parallel. Reports only the textures with outliers,
+    // worst first. Progress counts files.
+    static std::vector<MipChainReport> CheckFiles(const std::vector<std::string>& filenames,
+                                                  BatchProgress* progress = nullptr);
+};
+
+} // namespace VTFLib
+
+#endif // MIPCHAINCHECKER_H
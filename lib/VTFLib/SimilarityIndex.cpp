@@ -0,0 +1,261 @@
+#include "SimilarityIndex.h"
+#include "ThreadPool.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VTFLIB_SIMILARITY_SSE2 1
+#endif
+
+namespace VTFLib {
+
+namespace {
+
+// Coefficients per side kept from the DCT; 8x8 of them make the 64-bit hash
+const uint32_t HASH_SIDE = 8;
+
+uint32_t HistogramDistance(const uint8_t* a, const uint8_t* b) {
+#if defined(VTFLIB_SIMILARITY_SSE2)
+    // Each SAD sums 8 absolute differences into both 64-bit halves
+    __m128i sum = _mm_setzero_si128();
+    for (uint32_t i = 0; i < SIMILARITY_HISTOGRAM_BINS; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(x, y));
+    }
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+#else
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < SIMILARITY_HISTOGRAM_BINS; ++i) {
+        sum += static_cast<uint32_t>(std::abs(a[i] - b[i]));
+    }
+    return sum;
+#endif
+}
+
+uint32_t HashDistance(uint64_t a, uint64_t b) {
+    return static_cast<uint32_t>(std::bitset<64>(a ^ b).count()) * SIMILARITY_HASH_WEIGHT;
+}
+
+// Box-filter the image's luma down to SIMILARITY_SAMPLE_SIZE squared; smaller sides are
+// stretched by repeating pixels
+void SampleLuma(const uint8_t* rgba, uint32_t width, uint32_t height, float* luma) {
+    const uint32_t n = SIMILARITY_SAMPLE_SIZE;
+    for (uint32_t y = 0; y < n; ++y) {
+        uint32_t y0 = y * height / n;
+        uint32_t y1 = std::max(y0 + 1, (y + 1) * height / n);
+        for (uint32_t x = 0; x < n; ++x) {
+            uint32_t x0 = x * width / n;
+            uint32_t x1 = std::max(x0 + 1, (x + 1) * width / n);
+            float sum = 0.0f;
+            for (uint32_t sy = y0; sy < y1; ++sy) {
+                const uint8_t* pixel = rgba + (static_cast<size_t>(sy) * width + x0) * 4;
+                for (uint32_t sx = x0; sx < x1; ++sx, pixel += 4) {
+                    sum += 0.299f * pixel[0] + 0.587f * pixel[1] + 0.114f * pixel[2];
+                }
+            }
+            luma[y * n + x] = sum / static_cast<float>((y1 - y0) * (x1 - x0));
+        }
+    }
+}
+
+// Bits set where the low-frequency DCT coefficients exceed their median. The DC term
+// only carries overall brightness, so it is left out of both the median and the hash.
+uint64_t DCTHash(const float* luma) {
+    const uint32_t n = SIMILARITY_SAMPLE_SIZE;
+    const float pi = 3.14159265358979f;
+    
+    float basis[HASH_SIDE][SIMILARITY_SAMPLE_SIZE];
+    for (uint32_t u = 0; u < HASH_SIDE; ++u) {
+        float scale = std::sqrt((u == 0 ? 1.0f : 2.0f) / n);
+        for (uint32_t x = 0; x < n; ++x) {
+            basis[u][x] = scale * std::cos((2 * x + 1) * u * pi / (2 * n));
+        }
+    }
+    
+    // Separable: rows first, then columns, keeping only the lowest frequencies
+    float rows[SIMILARITY_SAMPLE_SIZE][HASH_SIDE];
+    for (uint32_t y = 0; y < n; ++y) {
+        for (uint32_t u = 0; u < HASH_SIDE; ++u) {
+            float sum = 0.0f;
+            for (uint32_t x = 0; x < n; ++x) {
+                sum += luma[y * n + x] * basis[u][x];
+            }
+            rows[y][u] = sum;
+        }
+    }
+    float coefficients[HASH_SIDE * HASH_SIDE];
+    for (uint32_t v = 0; v < HASH_SIDE; ++v) {
+        for (uint32_t u = 0; u < HASH_SIDE; ++u) {
+            float sum = 0.0f;
+            for (uint32_t y = 0; y < n; ++y) {
+                sum += rows[y][u] * basis[v][y];
+            }
+            coefficients[v * HASH_SIDE + u] = sum;
+        }
+    }
+    
+    float ac[HASH_SIDE * HASH_SIDE - 1];
+    std::copy(coefficients + 1, coefficients + HASH_SIDE * HASH_SIDE, ac);
+    const size_t middle = (HASH_SIDE * HASH_SIDE - 1) / 2;
+    std::nth_element(ac, ac + middle, ac + HASH_SIDE * HASH_SIDE - 1);
+    float median = ac[middle];
+    
+    uint64_t hash = 0;
+    for (uint32_t i = 1; i < HASH_SIDE * HASH_SIDE; ++i) {
+        if (coefficients[i] > median) {
+            hash |= uint64_t(1) << i;
+        }
+    }
+    return hash;
+}
+
+} // namespace
+
+PerceptualDescriptor SimilarityIndex::Describe(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    PerceptualDescriptor descriptor;
+    if (!rgba || width == 0 || height == 0) {
+        return descriptor;
+    }
+    
+    float luma[SIMILARITY_SAMPLE_SIZE * SIMILARITY_SAMPLE_SIZE];
+    SampleLuma(rgba, width, height, luma);
+    descriptor.hash = DCTHash(luma);
+    
+    // Alpha is left out: many formats store unrelated data there
+    uint32_t counts[SIMILARITY_HISTOGRAM_BINS] = {};
+    size_t pixels = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < pixels; ++i) {
+        const uint8_t* pixel = rgba + i * 4;
+        counts[(pixel[0] >> 6) * 16 + (pixel[1] >> 6) * 4 + (pixel[2] >> 6)]++;
+    }
+    for (uint32_t bin = 0; bin < SIMILARITY_HISTOGRAM_BINS; ++bin) {
+        descriptor.histogram[bin] = static_cast<uint8_t>((counts[bin] * 255ull + pixels / 2) / pixels);
+    }
+    return descriptor;
+}
+
+bool SimilarityIndex::Describe(const VTFFile& file, PerceptualDescriptor& descriptor) {
+    if (!file.IsLoaded() || file.GetMipmapCount() == 0) {
+        return false;
+    }
+    
+    // The smallest mip that still fills the sample grid is the cheapest to decode
+    uint32_t mipmap = 0;
+    while (mipmap + 1 < file.GetMipmapCount() &&
+           static_cast<uint32_t>(file.GetWidth() >> (mipmap + 1)) >= SIMILARITY_SAMPLE_SIZE &&
+           static_cast<uint32_t>(file.GetHeight() >> (mipmap + 1)) >= SIMILARITY_SAMPLE_SIZE) {
+        mipmap++;
+    }
+    
+    uint32_t width = std::max(1, file.GetWidth() >> mipmap);
+    uint32_t height = std::max(1, file.GetHeight() >> mipmap);
+    std::unique_ptr<uint8_t[]> rgba(new uint8_t[static_cast<size_t>(width) * height * 4]);
+    if (!file.GetImageData(rgba.get(), 0, mipmap)) {
+        return false;
+    }
+    descriptor = Describe(rgba.get(), width, height);
+    return true;
+}
+
+uint32_t SimilarityIndex::Distance(const PerceptualDescriptor& a, const PerceptualDescriptor& b) {
+    return HashDistance(a.hash, b.hash) + HistogramDistance(a.histogram, b.histogram);
+}
+
+void SimilarityIndex::Set(const std::string& key, const PerceptualDescriptor& descriptor) {
+    auto it = rows_.find(key);
+    uint32_t row;
+    if (it != rows_.end()) {
+        row = it->second;
+    } else {
+        row = static_cast<uint32_t>(keys_.size());
+        rows_.emplace(key, row);
+        keys_.push_back(key);
+        hashes_.push_back(0);
+        histograms_.resize(histograms_.size() + SIMILARITY_HISTOGRAM_BINS);
+    }
+    hashes_[row] = descriptor.hash;
+    std::memcpy(&histograms_[static_cast<size_t>(row) * SIMILARITY_HISTOGRAM_BINS],
+                descriptor.histogram, SIMILARITY_HISTOGRAM_BINS);
+}
+
+void SimilarityIndex::Remove(const std::string& key) {
+    auto it = rows_.find(key);
+    if (it == rows_.end()) {
+        return;
+    }
+    
+    // The last row fills the hole, keeping the columns dense
+    uint32_t row = it->second;
+    uint32_t last = static_cast<uint32_t>(keys_.size() - 1);
+    rows_.erase(it);
+    if (row != last) {
+        keys_[row] = std::move(keys_[last]);
+        hashes_[row] = hashes_[last];
+        std::memcpy(&histograms_[static_cast<size_t>(row) * SIMILARITY_HISTOGRAM_BINS],
+                    &histograms_[static_cast<size_t>(last) * SIMILARITY_HISTOGRAM_BINS],
+                    SIMILARITY_HISTOGRAM_BINS);
+        rows_[keys_[row]] = row;
+    }
+    keys_.pop_back();
+    hashes_.pop_back();
+    histograms_.resize(histograms_.size() - SIMILARITY_HISTOGRAM_BINS);
+}
+
+void SimilarityIndex::Clear() {
+    keys_.clear();
+    hashes_.clear();
+    histograms_.clear();
+    rows_.clear();
+}
+
+bool SimilarityIndex::Get(const std::string& key, PerceptualDescriptor& descriptor) const {
+    auto it = rows_.find(key);
+    if (it == rows_.end()) {
+        return false;
+    }
+    descriptor.hash = hashes_[it->second];
+    std::memcpy(descriptor.histogram, &histograms_[static_cast<size_t>(it->second) * SIMILARITY_HISTOGRAM_BINS],
+                SIMILARITY_HISTOGRAM_BINS);
+    return true;
+}
+
+std::vector<SimilarityIndex::Match> SimilarityIndex::FindSimilar(const PerceptualDescriptor& query, size_t count,
+                                                                 uint32_t maxDistance) const {
+    std::vector<uint32_t> distances(keys_.size());
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(keys_.size()), SIMILARITY_QUERY_GRAIN,
+        [this, &query, &distances](uint32_t begin, uint32_t end) {
+            for (uint32_t row = begin; row < end; ++row) {
+                distances[row] = HashDistance(query.hash, hashes_[row]) +
+                    HistogramDistance(query.histogram, &histograms_[static_cast<size_t>(row) * SIMILARITY_HISTOGRAM_BINS]);
+            }
+        });
+    
+    std::vector<uint32_t> rows;
+    for (uint32_t row = 0; row < distances.size(); ++row) {
+        if (distances[row] <= maxDistance) {
+            rows.push_back(row);
+        }
+    }
+    
+    auto nearer = [this, &distances](uint32_t a, uint32_t b) {
+        return distances[a] != distances[b] ? distances[a] < distances[b] : keys_[a] < keys_[b];
+    };
+    size_t kept = std::min(count, rows.size());
+    std::partial_sort(rows.begin(), rows.begin() + kept, rows.end(), nearer);
+    
+    std::vector<Match> matches;
+    matches.reserve(kept);
+    for (size_t i = 0; i < kept; ++i) {
+        matches.push_back({ keys_[rows[i]], distances[rows[i]] });
+    }
+    return matches;
+}
+
+} // namespace VTFLib
@@ -0,0 +1,75 @@
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VTFLib {
+
+class VTFFile;
+
+// Side of the luma grid the DCT hash is taken from; mips this size or larger are used
+const uint32_t SIMILARITY_SAMPLE_SIZE = 32;
+
+// Colour histogram of 4 levels per RGB channel
+const uint32_t SIMILARITY_HISTOGRAM_BINS = 64;
+
+// Each differing hash bit weighs as much as this many histogram units (of 255 per image)
+const uint32_t SIMILARITY_HASH_WEIGHT = 4;
+
+// Rows scored per thread pool chunk during a query
+const uint32_t SIMILARITY_QUERY_GRAIN = 8192;
+
+// Compact perceptual fingerprint of a texture: a 64-bit DCT hash of the luma structure
+// and a colour histogram scaled to 255, so near-identical images (rescaled, recompressed,
+// slightly retouched) land close together whatever their size or format.
+struct PerceptualDescriptor {
+    uint64_t hash = 0;
+    uint8_t histogram[SIMILARITY_HISTOGRAM_BINS] = {};
+};
+
+// Descriptors of every texture seen, in contiguous columns, and a brute-force nearest
+// neighbour query over them. Scoring a row is a popcount and four SSE2 sum-of-absolute-
+// differences, so even 100k textures are scanned in a few milliseconds. Not thread-safe.
+class SimilarityIndex {
+public:
+    struct Match {
+        std::string key;
+        uint32_t distance;
+    };
+    
+    // Descriptor of an RGBA8888 image
+    static PerceptualDescriptor Describe(const uint8_t* rgba, uint32_t width, uint32_t height);
+    
+    // Descriptor of a texture, decoded from its smallest mip of at least SIMILARITY_SAMPLE_SIZE
+    // on each side (or mip 0 of smaller textures); false if it can't be decoded
+    static bool Describe(const VTFFile& file, PerceptualDescriptor& descriptor);
+    
+    // 0 for identical descriptors; SIMILARITY_HASH_WEIGHT * 64 + 510 at most
+    static uint32_t Distance(const PerceptualDescriptor& a, const PerceptualDescriptor& b);
+    
+    // Add or replace the descriptor of a key
+    void Set(const std::string& key, const PerceptualDescriptor& descriptor);
+    void Remove(const std::string& key);
+    void Clear();
+    
+    size_t GetCount() const { return keys_.size(); }
+    bool Get(const std::string& key, PerceptualDescriptor& descriptor) const;
+    
+    // Up to count entries within maxDistance of query, nearest first (ties by key)
+    std::vector<Match> FindSimilar(const PerceptualDescriptor& query, size_t count,
+                                   uint32_t maxDistance) const;
+    
+private:
+    std::vector<std::string> keys_;
+    std::vector<uint64_t> hashes_;
+    std::vector<uint8_t> histograms_;  // SIMILARITY_HISTOGRAM_BINS per row
+    std::unordered_map<std::string, uint32_t> rows_;
+};
+
+} // namespace VTFLib
+
+#endif // SIMILARITYINDEX_H
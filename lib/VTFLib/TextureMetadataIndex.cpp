@@ -0,0 +1,423 @@
+#include "TextureMetadataIndex.h"
+#include "GameIndex.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "VPKFile.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace VTFLib {
+
+namespace {
+
+struct IndexHeader {
+    char signature[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t pathBytes;
+};
+
+// Byte offset of every column for a given row count
+struct Layout {
+    size_t modified, fileSize, pathOffsets, format, flags;
+    size_t width, height, depth, frames, mipmapCount, version, paths;
+    size_t total;
+    
+    Layout(size_t count, size_t pathBytes) {
+        size_t offset = sizeof(IndexHeader);
+        auto column = [&offset](size_t bytes) {
+            offset = (offset + 7) & ~static_cast<size_t>(7);
+            size_t start = offset;
+            offset += bytes;
+            return start;
+        };
+        modified = column(count * sizeof(int64_t));
+        fileSize = column(count * sizeof(uint64_t));
+        pathOffsets = column((count + 1) * sizeof(uint32_t));
+        format = column(count * sizeof(uint32_t));
+        flags = column(count * sizeof(uint32_t));
+        width = column(count * sizeof(uint16_t));
+        height = column(count * sizeof(uint16_t));
+        depth = column(count * sizeof(uint16_t));
+        frames = column(count * sizeof(uint16_t));
+        mipmapCount = column(count);
+        version = column(count);
+        paths = column(pathBytes);
+        total = offset;
+    }
+};
+
+template <typename T>
+const T* ColumnAt(const uint8_t* data, size_t offset) {
+    return reinterpret_cast<const T*>(data + offset);
+}
+
+template <typename T>
+T* ColumnAt(uint8_t* data, size_t offset) {
+    return reinterpret_cast<T*>(data + offset);
+}
+
+bool Stamp(const std::string& filename, TextureMetadata& metadata) {
+    std::error_code error;
+    uintmax_t size = fs::file_size(filename, error);
+    if (error) {
+        return false;
+    }
+    fs::file_time_type modified = fs::last_write_time(filename, error);
+    if (error) {
+        return false;
+    }
+    metadata.fileSize = size;
+    metadata.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+    return true;
+}
+
+bool ReadFileHeader(const std::string& filename, TextureMetadata& metadata) {
+    // Only the header is read; the image data is never touched
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    uint8_t header[sizeof(VTFHeader)];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    return TextureMetadataIndex::ReadHeader(header, static_cast<size_t>(file.gcount()), metadata);
+}
+
+} // namespace
+
+TextureMetadataIndex::TextureMetadataIndex() : data_(nullptr), size_(0), count_(0) {
+}
+
+TextureMetadataIndex::~TextureMetadataIndex() {
+}
+
+void TextureMetadataIndex::Clear() {
+    mapping_.reset();
+    storage_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    count_ = 0;
+    columns_ = Columns();
+}
+
+bool TextureMetadataIndex::Load(const std::string& filename) {
+    Clear();
+    
+    std::shared_ptr<const MappedFile> mapping = MappedFile::Map(filename);
+    if (!mapping || !Attach(mapping->GetData(), mapping->GetSize())) {
+        Clear();
+        return false;
+    }
+    mapping_ = std::move(mapping);
+    return true;
+}
+
+bool TextureMetadataIndex::Attach(const uint8_t* data, size_t size) {
+    if (size < sizeof(IndexHeader)) {
+        return false;
+    }
+    
+    IndexHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.signature, METADATA_INDEX_SIGNATURE, 4) != 0 ||
+        header.version != METADATA_INDEX_VERSION) {
+        return false;
+    }
+    
+    Layout layout(header.count, header.pathBytes);
+    if (layout.total != size) {
+        return false;
+    }
+    
+    Columns columns;
+    columns.modified = ColumnAt<int64_t>(data, layout.modified);
+    columns.fileSize = ColumnAt<uint64_t>(data, layout.fileSize);
+    columns.pathOffsets = ColumnAt<uint32_t>(data, layout.pathOffsets);
+    columns.format = ColumnAt<uint32_t>(data, layout.format);
+    columns.flags = ColumnAt<uint32_t>(data, layout.flags);
+    columns.width = ColumnAt<uint16_t>(data, layout.width);
+    columns.height = ColumnAt<uint16_t>(data, layout.height);
+    columns.depth = ColumnAt<uint16_t>(data, layout.depth);
+    columns.frames = ColumnAt<uint16_t>(data, layout.frames);
+    columns.mipmapCount = ColumnAt<uint8_t>(data, layout.mipmapCount);
+    columns.version = ColumnAt<uint8_t>(data, layout.version);
+    columns.paths = ColumnAt<char>(data, layout.paths);
+    
+    // A truncated or damaged file must not send a path outside the block
+    if (columns.pathOffsets[0] != 0 || columns.pathOffsets[header.count] != header.pathBytes) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.count; ++i) {
+        if (columns.pathOffsets[i] > columns.pathOffsets[i + 1]) {
+            return false;
+        }
+    }
+    
+    data_ = data;
+    size_ = size;
+    count_ = header.count;
+    columns_ = columns;
+    return true;
+}
+
+bool TextureMetadataIndex::Save(const std::string& filename) const {
+    // Written beside the target and renamed over it, so readers never see half a file
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        if (data_) {
+            file.write(reinterpret_cast<const char*>(data_), static_cast<std::streamsize>(size_));
+        } else {
+            IndexHeader header = {};
+            memcpy(header.signature, METADATA_INDEX_SIGNATURE, 4);
+            header.version = METADATA_INDEX_VERSION;
+            Layout layout(0, 0);
+            std::vector<char> empty(layout.total, 0);
+            memcpy(empty.data(), &header, sizeof(header));
+            file.write(empty.data(), static_cast<std::streamsize>(empty.size()));
+        }
+        if (!file) {
+            return false;
+        }
+    }
+    
+    std::error_code error;
+    fs::rename(temporary, filename, error);
+    if (error) {
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+size_t TextureMetadataIndex::Refresh(const std::vector<std::string>& filenames) {
+    std::vector<Row> rows(filenames.size());
+    std::vector<char> stamped(filenames.size(), 0);
+    
+    // Stamping is a stat per file, which is worth spreading out on network mounts
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(filenames.size()), METADATA_READ_GRAIN,
+        [&filenames, &rows, &stamped](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                rows[i].path = filenames[i];
+                stamped[i] = Stamp(filenames[i], rows[i].metadata);
+            }
+        });
+    
+    // Files that can't be stat'ed are gone
+    size_t kept = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (stamped[i]) {
+            if (kept != i) {
+                rows[kept] = std::move(rows[i]);
+            }
+            kept++;
+        }
+    }
+    rows.resize(kept);
+    
+    return Refresh(rows, [](const Row& row, TextureMetadata& metadata) {
+        return ReadFileHeader(row.path, metadata);
+    });
+}
+
+size_t TextureMetadataIndex::Refresh(const GameIndex& game) {
+    const std::vector<GameSearchPath>& searchPaths = game.GetSearchPaths();
+    
+    // Every entry of a VPK shares the stamp of its directory file
+    std::vector<int64_t> vpkModified(searchPaths.size(), 0);
+    for (size_t i = 0; i < searchPaths.size(); ++i) {
+        TextureMetadata stamp;
+        if (searchPaths[i].vpk && Stamp(searchPaths[i].path, stamp)) {
+            vpkModified[i] = stamp.modified;
+        }
+    }
+    
+    std::vector<std::string> paths = game.GetFiles(".vtf");
+    std::vector<Row> rows;
+    std::vector<GameFileLocation> locations;
+    rows.reserve(paths.size());
+    locations.reserve(paths.size());
+    for (std::string& path : paths) {
+        GameFileLocation location;
+        if (!game.Find(path, location)) {
+            continue;
+        }
+        
+        Row row;
+        const GameSearchPath& searchPath = searchPaths[location.searchPath];
+        if (searchPath.vpk) {
+            const VPKEntry& entry = searchPath.vpk->GetEntry(location.file);
+            row.metadata.fileSize = static_cast<uint64_t>(entry.preloadBytes) + entry.length;
+            row.metadata.modified = vpkModified[location.searchPath];
+        } else if (!Stamp(game.GetFilePath(location), row.metadata)) {
+            continue;
+        }
+        row.path = std::move(path);
+        row.source = static_cast<uint32_t>(locations.size());
+        rows.push_back(std::move(row));
+        locations.push_back(location);
+    }
+    
+    return Refresh(rows, [&game, &locations, &searchPaths](const Row& row, TextureMetadata& metadata) {
+        const GameFileLocation& location = locations[row.source];
+        const GameSearchPath& searchPath = searchPaths[location.searchPath];
+        if (!searchPath.vpk) {
+            return ReadFileHeader(game.GetFilePath(location), metadata);
+        }
+        
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::shared_ptr<const void> owner;
+        return searchPath.vpk->GetEntryData(searchPath.vpk->GetEntry(location.file), data, size, owner) &&
+               ReadHeader(data, size, metadata);
+    });
+}
+
+size_t TextureMetadataIndex::Refresh(std::vector<Row>& rows,
+                                     const std::function<bool(const Row&, TextureMetadata&)>& read) {
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.path < b.path; });
+    rows.erase(std::unique(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        return a.path == b.path;
+    }), rows.end());
+    
+    // Both sides are sorted, so matching old rows is a single merge
+    std::vector<uint32_t> stale;
+    size_t old = 0;
+    for (uint32_t i = 0; i < rows.size(); ++i) {
+        while (old < count_ && GetPath(old) < rows[i].path) {
+            old++;
+        }
+        TextureMetadata& metadata = rows[i].metadata;
+        if (old < count_ && GetPath(old) == rows[i].path &&
+            columns_.fileSize[old] == metadata.fileSize && columns_.modified[old] == metadata.modified) {
+            metadata = GetMetadata(old);
+        } else {
+            stale.push_back(i);
+        }
+    }
+    
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(stale.size()), METADATA_READ_GRAIN,
+        [&rows, &stale, &read](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                Row& row = rows[stale[i]];
+                TextureMetadata metadata;
+                metadata.fileSize = row.metadata.fileSize;
+                metadata.modified = row.metadata.modified;
+                if (!read(row, metadata)) {
+                    metadata.format = static_cast<uint32_t>(IMAGE_FORMAT_NONE);
+                }
+                row.metadata = metadata;
+            }
+        });
+    
+    Build(rows);
+    return stale.size();
+}
+
+void TextureMetadataIndex::Build(const std::vector<Row>& rows) {
+    size_t pathBytes = 0;
+    for (const Row& row : rows) {
+        pathBytes += row.path.size();
+    }
+    
+    Layout layout(rows.size(), pathBytes);
+    std::vector<uint64_t> storage((layout.total + 7) / 8, 0);
+    uint8_t* data = reinterpret_cast<uint8_t*>(storage.data());
+    
+    IndexHeader header = {};
+    memcpy(header.signature, METADATA_INDEX_SIGNATURE, 4);
+    header.version = METADATA_INDEX_VERSION;
+    header.count = static_cast<uint32_t>(rows.size());
+    header.pathBytes = static_cast<uint32_t>(pathBytes);
+    memcpy(data, &header, sizeof(header));
+    
+    uint32_t* pathOffsets = ColumnAt<uint32_t>(data, layout.pathOffsets);
+    char* paths = ColumnAt<char>(data, layout.paths);
+    pathOffsets[0] = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const TextureMetadata& metadata = rows[i].metadata;
+        ColumnAt<int64_t>(data, layout.modified)[i] = metadata.modified;
+        ColumnAt<uint64_t>(data, layout.fileSize)[i] = metadata.fileSize;
+        ColumnAt<uint32_t>(data, layout.format)[i] = metadata.format;
+        ColumnAt<uint32_t>(data, layout.flags)[i] = metadata.flags;
+        ColumnAt<uint16_t>(data, layout.width)[i] = metadata.width;
+        ColumnAt<uint16_t>(data, layout.height)[i] = metadata.height;
+        ColumnAt<uint16_t>(data, layout.depth)[i] = metadata.depth;
+        ColumnAt<uint16_t>(data, layout.frames)[i] = metadata.frames;
+        ColumnAt<uint8_t>(data, layout.mipmapCount)[i] = metadata.mipmapCount;
+        ColumnAt<uint8_t>(data, layout.version)[i] = metadata.version;
+        
+        memcpy(paths + pathOffsets[i], rows[i].path.data(), rows[i].path.size());
+        pathOffsets[i + 1] = pathOffsets[i] + static_cast<uint32_t>(rows[i].path.size());
+    }
+    
+    Clear();
+    storage_ = std::move(storage);
+    Attach(reinterpret_cast<const uint8_t*>(storage_.data()), layout.total);
+}
+
+std::string_view TextureMetadataIndex::GetPath(size_t row) const {
+    uint32_t begin = columns_.pathOffsets[row];
+    return std::string_view(columns_.paths + begin, columns_.pathOffsets[row + 1] - begin);
+}
+
+TextureMetadata TextureMetadataIndex::GetMetadata(size_t row) const {
+    TextureMetadata metadata;
+    metadata.fileSize = columns_.fileSize[row];
+    metadata.modified = columns_.modified[row];
+    metadata.format = columns_.format[row];
+    metadata.flags = columns_.flags[row];
+    metadata.width = columns_.width[row];
+    metadata.height = columns_.height[row];
+    metadata.depth = columns_.depth[row];
+    metadata.frames = columns_.frames[row];
+    metadata.mipmapCount = columns_.mipmapCount[row];
+    metadata.version = columns_.version[row];
+    return metadata;
+}
+
+size_t TextureMetadataIndex::Find(std::string_view path) const {
+    size_t low = 0;
+    size_t high = count_;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (GetPath(middle) < path) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < count_ && GetPath(low) == path ? low : NOT_FOUND;
+}
+
+bool TextureMetadataIndex::ReadHeader(const uint8_t* data, size_t size, TextureMetadata& metadata) {
+    if (!data || size < sizeof(VTFHeader)) {
+        return false;
+    }
+    
+    VTFHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (strncmp(header.signature, VTF_SIGNATURE, 4) != 0 ||
+        header.version[0] != 7 || header.version[1] > 5) {
+        return false;
+    }
+    
+    metadata.format = header.highResImageFormat;
+    metadata.flags = header.flags;
+    metadata.width = header.width;
+    metadata.height = header.height;
+    metadata.depth = header.version[1] >= 2 ? header.depth : 1;  // depth arrived in 7.2
+    metadata.frames = header.frames;
+    metadata.mipmapCount = header.mipmapCount;
+    metadata.version = static_cast<uint8_t>(header.version[1]);
+    return true;
+}
+
+} // namespace VTFLib
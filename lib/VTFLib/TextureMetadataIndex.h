@@ -0,0 +1,124 @@
+#ifndef TEXTUREMETADATAINDEX_H
+#define TEXTUREMETADATAINDEX_H
+
+#include "VTFFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace VTFLib {
+
+class GameIndex;
+class MappedFile;
+
+// Signature and layout version of a saved index; files of another version are rebuilt
+const char METADATA_INDEX_SIGNATURE[] = "VTMI";
+const uint32_t METADATA_INDEX_VERSION = 1;
+
+// Headers read per thread pool chunk during a refresh
+const uint32_t METADATA_READ_GRAIN = 64;
+
+// Header fields of one texture plus the stamp it was read at
+struct TextureMetadata {
+    uint64_t fileSize = 0;
+    int64_t modified = 0;  // file system time stamp; only compared for equality
+    uint32_t format = static_cast<uint32_t>(IMAGE_FORMAT_NONE);
+    uint32_t flags = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint16_t depth = 0;
+    uint16_t frames = 0;
+    uint8_t mipmapCount = 0;
+    uint8_t version = 0;  // minor version, 7.x
+    
+    // Unreadable files keep a row too, so they aren't read again until they change
+    bool IsValid() const { return format != static_cast<uint32_t>(IMAGE_FORMAT_NONE); }
+};
+
+// Header metadata of every texture of a directory or game install, kept as sorted columns
+// in a single block that is written to disk as is. A saved index is memory-mapped and
+// queried in place, so opening one costs nothing however many textures it covers. A
+// refresh re-reads only the files whose size or modification time changed, and only
+// their header. Thread-safe for reading; Load and Refresh must not race with anything.
+//
+// File layout (native byte order): signature, version, row count and path bytes as four
+// 32-bit words, then 8-byte aligned columns: modified, fileSize, pathOffsets (count + 1),
+// format, flags, width, height, depth, frames, mipmapCount, version and the path bytes.
+class TextureMetadataIndex {
+public:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    
+    TextureMetadataIndex();
+    ~TextureMetadataIndex();
+    
+    // Map a saved index. Fails, leaving the index empty, if the file is missing or stale.
+    bool Load(const std::string& filename);
+    
+    // Write the index, replacing the file atomically
+    bool Save(const std::string& filename) const;
+    
+    // Bring the index up to date with a set of VTF files: rows whose stamp still matches
+    // are kept, changed and new files are read, rows of files not listed are dropped.
+    // Returns the number of files read.
+    size_t Refresh(const std::vector<std::string>& filenames);
+    
+    // The same for every VTF of a game install, keyed by game-relative path. Files inside
+    // a VPK are stamped with their entry size and the VPK's modification time.
+    size_t Refresh(const GameIndex& game);
+    
+    void Clear();
+    
+    size_t GetCount() const { return count_; }
+    
+    // Rows are sorted by path
+    std::string_view GetPath(size_t row) const;
+    TextureMetadata GetMetadata(size_t row) const;
+    
+    // Row of a path, or NOT_FOUND
+    size_t Find(std::string_view path) const;
+    
+    // Parse the fields of a VTF header; false if the data isn't one
+    static bool ReadHeader(const uint8_t* data, size_t size, TextureMetadata& metadata);
+    
+private:
+    struct Columns {
+        const int64_t* modified = nullptr;
+        const uint64_t* fileSize = nullptr;
+        const uint32_t* pathOffsets = nullptr;
+        const uint32_t* format = nullptr;
+        const uint32_t* flags = nullptr;
+        const uint16_t* width = nullptr;
+        const uint16_t* height = nullptr;
+        const uint16_t* depth = nullptr;
+        const uint16_t* frames = nullptr;
+        const uint8_t* mipmapCount = nullptr;
+        const uint8_t* version = nullptr;
+        const char* paths = nullptr;
+    };
+    
+    struct Row {
+        std::string path;
+        TextureMetadata metadata;
+        uint32_t source = 0;  // the caller's index of where the file lives
+    };
+    
+    // The index block lives in either the mapped file or storage_
+    std::shared_ptr<const MappedFile> mapping_;
+    std::vector<uint64_t> storage_;  // 64-bit words keep the columns aligned
+    const uint8_t* data_;
+    size_t size_;
+    size_t count_;
+    Columns columns_;
+    
+    bool Attach(const uint8_t* data, size_t size);
+    size_t Refresh(std::vector<Row>& rows, const std::function<bool(const Row&, TextureMetadata&)>& read);
+    void Build(const std::vector<Row>& rows);
+};
+
+} // namespace VTFLib
+
+#endif // TEXTUREMETADATAINDEX_H
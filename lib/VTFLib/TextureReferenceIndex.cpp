@@ -0,0 +1,171 @@
+#include "TextureReferenceIndex.h"
+#include "MaterialDatabase.h"
+#include "VMTFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace VTFLib {
+
+namespace {
+
+const char* const MATERIALS_DIRECTORY = "materials/";
+
+} // namespace
+
+TextureReferenceIndex::TextureReferenceIndex() : presentCount_(0) {
+}
+
+TextureReferenceIndex::~TextureReferenceIndex() {
+}
+
+void TextureReferenceIndex::Clear() {
+    materials_.clear();
+    textures_.clear();
+    presentCount_ = 0;
+}
+
+void TextureReferenceIndex::AddMaterials(const MaterialDatabase& database) {
+    materials_.reserve(materials_.size() + database.GetMaterialCount());
+    for (size_t i = 0; i < database.GetMaterialCount(); ++i) {
+        SetMaterial(database.GetPath(i), database.GetTextureReferences(i));
+    }
+}
+
+void TextureReferenceIndex::SetMaterial(const std::string& material, const std::vector<std::string>& textures) {
+    std::vector<std::string>& references = materials_[material];
+    Unlink(material, references);
+    references.clear();
+    
+    for (const std::string& texture : textures) {
+        std::string key = MaterialDatabase::NormalizeTexturePath(texture);
+        if (key.empty() || std::find(references.begin(), references.end(), key) != references.end()) {
+            continue;
+        }
+        textures_[key].materials.push_back(material);
+        references.push_back(std::move(key));
+    }
+}
+
+void TextureReferenceIndex::SetMaterial(const std::string& material, const VMTFile& file) {
+    std::vector<std::string> textures;
+    for (const VMTNode* reference : file.GetTextureReferences()) {
+        textures.emplace_back(reference->GetValue());
+    }
+    SetMaterial(material, textures);
+}
+
+void TextureReferenceIndex::RemoveMaterial(const std::string& material) {
+    auto it = materials_.find(material);
+    if (it == materials_.end()) {
+        return;
+    }
+    Unlink(material, it->second);
+    materials_.erase(it);
+}
+
+void TextureReferenceIndex::AddTexture(const std::string& path) {
+    Texture& texture = textures_[TextureKey(path)];
+    if (texture.copies++ == 0) {
+        presentCount_++;
+    }
+}
+
+void TextureReferenceIndex::RemoveTexture(const std::string& path) {
+    auto it = textures_.find(TextureKey(path));
+    if (it == textures_.end() || it->second.copies == 0) {
+        return;
+    }
+    if (--it->second.copies == 0) {
+        presentCount_--;
+        Release(it);
+    }
+}
+
+std::vector<std::string> TextureReferenceIndex::GetMaterialsUsing(const std::string& texture) const {
+    auto it = textures_.find(TextureKey(texture));
+    if (it == textures_.end()) {
+        return {};
+    }
+    std::vector<std::string> materials = it->second.materials;
+    std::sort(materials.begin(), materials.end());
+    return materials;
+}
+
+std::vector<std::string> TextureReferenceIndex::GetTexturesOf(const std::string& material) const {
+    auto it = materials_.find(material);
+    return it != materials_.end() ? it->second : std::vector<std::string>();
+}
+
+std::vector<std::pair<std::string, std::string>> TextureReferenceIndex::GetMissingReferences() const {
+    std::vector<std::pair<std::string, std::string>> missing;
+    for (const auto& texture : textures_) {
+        if (texture.second.copies > 0 || IsEngineTexture(texture.first)) {
+            continue;
+        }
+        for (const std::string& material : texture.second.materials) {
+            missing.emplace_back(material, texture.first);
+        }
+    }
+    std::sort(missing.begin(), missing.end());
+    return missing;
+}
+
+std::vector<std::string> TextureReferenceIndex::GetOrphanTextures() const {
+    std::vector<std::string> orphans;
+    for (const auto& texture : textures_) {
+        if (texture.second.copies > 0 && texture.second.materials.empty()) {
+            orphans.push_back(texture.first);
+        }
+    }
+    std::sort(orphans.begin(), orphans.end());
+    return orphans;
+}
+
+std::string TextureReferenceIndex::TextureKey(const std::string& path) {
+    std::string key = MaterialDatabase::NormalizeTexturePath(path);
+    
+    // Cut everything up to the last "materials/" directory, as the engine resolves from there
+    size_t length = strlen(MATERIALS_DIRECTORY);
+    for (size_t pos = key.rfind(MATERIALS_DIRECTORY); pos != std::string::npos;
+         pos = pos > 0 ? key.rfind(MATERIALS_DIRECTORY, pos - 1) : std::string::npos) {
+        if (pos == 0 || key[pos - 1] == '/') {
+            key.erase(0, pos + length);
+            break;
+        }
+    }
+    return key;
+}
+
+bool TextureReferenceIndex::IsEngineTexture(const std::string& texture) {
+    for (const char* prefix : ENGINE_TEXTURE_PREFIXES) {
+        if (texture.compare(0, strlen(prefix), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TextureReferenceIndex::Unlink(const std::string& material, const std::vector<std::string>& textures) {
+    for (const std::string& key : textures) {
+        auto it = textures_.find(key);
+        if (it == textures_.end()) {
+            continue;
+        }
+        std::vector<std::string>& materials = it->second.materials;
+        auto entry = std::find(materials.begin(), materials.end(), material);
+        if (entry != materials.end()) {
+            *entry = std::move(materials.back());
+            materials.pop_back();
+        }
+        Release(it);
+    }
+}
+
+void TextureReferenceIndex::Release(std::unordered_map<std::string, Texture>::iterator texture) {
+    // Forget textures that are neither present nor referenced
+    if (texture->second.copies == 0 && texture->second.materials.empty()) {
+        textures_.erase(texture);
+    }
+}
+
+} // namespace VTFLib
@@ -0,0 +1,80 @@
+#ifndef TEXTUREREFERENCEINDEX_H
+#define TEXTUREREFERENCEINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace VTFLib {
+
+class MaterialDatabase;
+class VMTFile;
+
+// Values of texture parameters that name engine resources rather than files
+const char* const ENGINE_TEXTURE_PREFIXES[] = { "_rt_", "env_cubemap", "engine/" };
+
+// Which materials reference which textures, and which textures exist, kept in both
+// directions so either side can be looked up or updated without a rescan. Textures are
+// keyed by normalized path ("brick/wall"); materials by whatever path they were added
+// under. Not thread-safe; owned by one thread.
+class TextureReferenceIndex {
+public:
+    TextureReferenceIndex();
+    ~TextureReferenceIndex();
+    
+    void Clear();
+    
+    // Add every material of a database
+    void AddMaterials(const MaterialDatabase& database);
+    
+    // Replace the references of one material; an empty list keeps it as referencing nothing
+    void SetMaterial(const std::string& material, const std::vector<std::string>& textures);
+    void SetMaterial(const std::string& material, const VMTFile& file);
+    void RemoveMaterial(const std::string& material);
+    
+    // Record that a texture file exists or is gone; the path is keyed by TextureKey.
+    // Copies are counted, so a texture in two places stays present until both are removed.
+    void AddTexture(const std::string& path);
+    void RemoveTexture(const std::string& path);
+    
+    // Materials referencing a texture, sorted
+    std::vector<std::string> GetMaterialsUsing(const std::string& texture) const;
+    
+    // Textures a material references, in parameter order
+    std::vector<std::string> GetTexturesOf(const std::string& material) const;
+    
+    // (material, texture) for every reference to a texture that is not present, sorted
+    std::vector<std::pair<std::string, std::string>> GetMissingReferences() const;
+    
+    // Textures present that no material references, sorted
+    std::vector<std::string> GetOrphanTextures() const;
+    
+    size_t GetMaterialCount() const { return materials_.size(); }
+    size_t GetTextureCount() const { return presentCount_; }
+    
+    // Key of a texture file: the path below its last "materials/" directory when there is
+    // one, normalized like a material's reference to it
+    static std::string TextureKey(const std::string& path);
+    
+    // Whether a reference names an engine resource such as a render target
+    static bool IsEngineTexture(const std::string& texture);
+    
+private:
+    struct Texture {
+        std::vector<std::string> materials;  // referencing materials, unordered
+        uint32_t copies = 0;
+    };
+    
+    std::unordered_map<std::string, std::vector<std::string>> materials_;
+    std::unordered_map<std::string, Texture> textures_;
+    size_t presentCount_;
+    
+    void Unlink(const std::string& material, const std::vector<std::string>& textures);
+    void Release(std::unordered_map<std::string, Texture>::iterator texture);
+};
+
+} // namespace VTFLib
+
+#endif // TEXTUREREFERENCEINDEX_H
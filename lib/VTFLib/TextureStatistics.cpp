@@ -0,0 +1,130 @@
+#include "TextureStatistics.h"
+#include "TextureMetadataIndex.h"
+#include "ThreadPool.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace VTFLib {
+
+namespace {
+
+bool IsPowerOfTwo(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+// The part of the statistics one chunk of rows adds up
+struct Partial {
+    TextureTally total;
+    uint64_t unreadable = 0;
+    uint64_t nonPowerOfTwo = 0;
+    uint64_t fullMipChain = 0;
+    uint64_t partialMipChain = 0;
+    uint64_t noMipChain = 0;
+    uint64_t cubemaps = 0;
+    uint64_t animated = 0;
+    uint64_t volumes = 0;
+    std::map<uint32_t, TextureTally> formats;
+    std::map<std::pair<uint16_t, uint16_t>, TextureTally> resolutions;
+    std::vector<LargestTexture> largest;
+};
+
+bool Larger(const LargestTexture& a, const LargestTexture& b) {
+    return a.vramBytes != b.vramBytes ? a.vramBytes > b.vramBytes : a.row < b.row;
+}
+
+// Keep the count largest, most VRAM first
+void TrimLargest(std::vector<LargestTexture>& largest, size_t count) {
+    size_t kept = std::min(count, largest.size());
+    std::partial_sort(largest.begin(), largest.begin() + kept, largest.end(), Larger);
+    largest.resize(kept);
+}
+
+} // namespace
+
+uint64_t TextureStatistics::VRAMSize(const TextureMetadata& metadata) {
+    return VTFFile::ComputeTextureSize(metadata.width, metadata.height, metadata.depth, metadata.frames,
+                                       GetFaceCount(metadata.flags), metadata.mipmapCount,
+                                       static_cast<VTFImageFormat>(metadata.format));
+}
+
+TextureStatistics TextureStatistics::Compute(const TextureMetadataIndex& index, size_t largestCount) {
+    uint32_t rowCount = static_cast<uint32_t>(index.GetCount());
+    std::vector<Partial> partials((rowCount + STATISTICS_GRAIN - 1) / STATISTICS_GRAIN);
+    
+    ThreadPool::Shared().ParallelFor(rowCount, STATISTICS_GRAIN,
+        [&index, &partials, largestCount](uint32_t begin, uint32_t end) {
+            Partial& partial = partials[begin / STATISTICS_GRAIN];
+            for (uint32_t row = begin; row < end; ++row) {
+                TextureMetadata texture = index.GetMetadata(row);
+                if (!texture.IsValid()) {
+                    partial.unreadable++;
+                    continue;
+                }
+                
+                TextureTally tally;
+                tally.count = 1;
+                tally.fileBytes = texture.fileSize;
+                tally.vramBytes = VRAMSize(texture);
+                partial.total.Add(tally);
+                partial.formats[texture.format].Add(tally);
+                partial.resolutions[{ texture.width, texture.height }].Add(tally);
+                partial.largest.push_back({ row, tally.vramBytes });
+                
+                uint16_t depth = std::max<uint16_t>(texture.depth, 1);
+                if (!IsPowerOfTwo(texture.width) || !IsPowerOfTwo(texture.height) || !IsPowerOfTwo(depth)) {
+                    partial.nonPowerOfTwo++;
+                }
+                uint32_t fullCount = VTFFile::ComputeFullMipmapCount(texture.width, texture.height, depth);
+                if (texture.mipmapCount >= fullCount) {
+                    partial.fullMipChain++;
+                } else if (texture.mipmapCount <= 1) {
+                    partial.noMipChain++;
+                } else {
+                    partial.partialMipChain++;
+                }
+                partial.cubemaps += (texture.flags & TEXTUREFLAGS_ENVMAP) ? 1 : 0;
+                partial.animated += texture.frames > 1 ? 1 : 0;
+                partial.volumes += depth > 1 ? 1 : 0;
+            }
+            TrimLargest(partial.largest, largestCount);
+        });
+    
+    TextureStatistics statistics;
+    std::map<uint32_t, TextureTally> formats;
+    std::map<std::pair<uint16_t, uint16_t>, TextureTally> resolutions;
+    for (Partial& partial : partials) {
+        statistics.total.Add(partial.total);
+        statistics.unreadable += partial.unreadable;
+        statistics.nonPowerOfTwo += partial.nonPowerOfTwo;
+        statistics.fullMipChain += partial.fullMipChain;
+        statistics.partialMipChain += partial.partialMipChain;
+        statistics.noMipChain += partial.noMipChain;
+        statistics.cubemaps += partial.cubemaps;
+        statistics.animated += partial.animated;
+        statistics.volumes += partial.volumes;
+        for (const auto& format : partial.formats) {
+            formats[format.first].Add(format.second);
+        }
+        for (const auto& resolution : partial.resolutions) {
+            resolutions[resolution.first].Add(resolution.second);
+        }
+        statistics.largest.insert(statistics.largest.end(), partial.largest.begin(), partial.largest.end());
+    }
+    TrimLargest(statistics.largest, largestCount);
+    
+    for (const auto& format : formats) {
+        statistics.formats.push_back({ format.first, format.second });
+    }
+    for (const auto& resolution : resolutions) {
+        statistics.resolutions.push_back({ resolution.first.first, resolution.first.second, resolution.second });
+    }
+    std::stable_sort(statistics.formats.begin(), statistics.formats.end(),
+        [](const FormatStatistics& a, const FormatStatistics& b) { return a.tally.vramBytes > b.tally.vramBytes; });
+    std::stable_sort(statistics.resolutions.begin(), statistics.resolutions.end(),
+        [](const ResolutionStatistics& a, const ResolutionStatistics& b) { return a.tally.vramBytes > b.tally.vramBytes; });
+    return statistics;
+}
+
+} // namespace VTFLib
@@ -0,0 +1,76 @@
+#ifndef TEXTURESTATISTICS_H
+#define TEXTURESTATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VTFLib {
+
+class TextureMetadataIndex;
+struct TextureMetadata;
+
+// Index rows tallied per thread pool chunk
+const uint32_t STATISTICS_GRAIN = 2048;
+
+// Textures listed as the largest by default
+const size_t STATISTICS_LARGEST_COUNT = 100;
+
+// Texture totals of one group (a format, a resolution, ...)
+struct TextureTally {
+    uint64_t count = 0;
+    uint64_t fileBytes = 0;
+    uint64_t vramBytes = 0;
+    
+    void Add(const TextureTally& other) {
+        count += other.count;
+        fileBytes += other.fileBytes;
+        vramBytes += other.vramBytes;
+    }
+};
+
+struct FormatStatistics {
+    uint32_t format = 0;
+    TextureTally tally;
+};
+
+struct ResolutionStatistics {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    TextureTally tally;
+};
+
+struct LargestTexture {
+    size_t row = 0;  // in the index the statistics were computed from
+    uint64_t vramBytes = 0;
+};
+
+// Tree-wide breakdown of a metadata index. Everything comes from the header fields the
+// index already holds, so no texture is opened; rows are tallied in parallel chunks that
+// are merged at the end. VRAM is the exact size of every frame, face, slice and mip as
+// stored, which is what the engine uploads.
+struct TextureStatistics {
+    TextureTally total;
+    uint64_t unreadable = 0;
+    uint64_t nonPowerOfTwo = 0;
+    uint64_t fullMipChain = 0;     // mips down to 1x1
+    uint64_t partialMipChain = 0;  // some mips, but not all
+    uint64_t noMipChain = 0;       // a single level on a texture larger than 1x1
+    uint64_t cubemaps = 0;
+    uint64_t animated = 0;
+    uint64_t volumes = 0;
+    std::vector<FormatStatistics> formats;          // most VRAM first
+    std::vector<ResolutionStatistics> resolutions;  // most VRAM first
+    std::vector<LargestTexture> largest;            // most VRAM first
+    
+    // Statistics of every row, listing up to largestCount of the largest textures
+    static TextureStatistics Compute(const TextureMetadataIndex& index,
+                                     size_t largestCount = STATISTICS_LARGEST_COUNT);
+    
+    // VRAM of one texture, from its header fields
+    static uint64_t VRAMSize(const TextureMetadata& metadata);
+};
+
+} // namespace VTFLib
+
+#endif // TEXTURESTATISTICS_H
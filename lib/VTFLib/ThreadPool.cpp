@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace VTFLib {
+
+ThreadPool::ThreadPool(unsigned threadCount) : stopping_(false) {
+    workers_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, uint32_t grainSize,
+                             const std::function<void(uint32_t, uint32_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    
+    grainSize = std::max(1u, grainSize);
+    uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount == 1 || workers_.empty()) {
+        fn(0, count);
+        return;
+    }
+    
+    // Helpers may only get to run after the caller has finished every chunk, so the
+    // shared state outlives this call. They never touch fn once all chunks are claimed.
+    struct State {
+        std::atomic<uint32_t> next{0};
+        std::atomic<uint32_t> finished{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<State>();
+    const auto* body = &fn;
+    
+    auto work = [state, body, count, grainSize, chunkCount] {
+        for (;;) {
+            uint32_t chunk = state->next.fetch_add(1);
+            if (chunk >= chunkCount) {
+                return;
+            }
+            
+            uint32_t begin = chunk * grainSize;
+            (*body)(begin, std::min(count, begin + grainSize));
+            
+            if (state->finished.fetch_add(1) + 1 == chunkCount) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->done.notify_all();
+            }
+        }
+    };
+    
+    uint32_t helpers = std::min<uint32_t>(GetThreadCount(), chunkCount - 1);
+    for (uint32_t i = 0; i < helpers; ++i) {
+        Submit(work);
+    }
+    work();
+    
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state, chunkCount] { return state->finished.load() == chunkCount; });
+}
+
+} // namespace VTFLib
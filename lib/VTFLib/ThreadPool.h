@@ -0,0 +1,61 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VTFLib {
+
+// Progress of a long batch call (validating, hashing or checking a whole tree), read
+// from another thread while it runs. Calls add their item count to total up front and
+// count items into done as they finish. Setting cancel makes the call skip the items it
+// hasn't started and return early with partial results.
+struct BatchProgress {
+    std::atomic<uint64_t> done{ 0 };
+    std::atomic<uint64_t> total{ 0 };
+    std::atomic<bool> cancel{ false };
+    
+    bool IsCancelled() const { return cancel.load(std::memory_order_relaxed); }
+};
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // Process-wide pool sized to the hardware (the calling thread counts as one worker)
+    static ThreadPool& Shared();
+    
+    unsigned GetThreadCount() const { return static_cast<unsigned>(workers_.size()); }
+    
+    // Queue a task to run on a worker thread
+    void Submit(std::function<void()> task);
+    
+    // Run fn(begin, end) over [0, count) in chunks of grainSize, using the pool and the
+    // calling thread. Returns once every chunk has finished. Safe to call from a pool
+    // thread: the caller keeps taking chunks itself if no worker is free.
+    void ParallelFor(uint32_t count, uint32_t grainSize,
+                     const std::function<void(uint32_t, uint32_t)>& fn);
+    
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_;
+    
+    void WorkerLoop();
+};
+
+} // namespace VTFLib
+
+#endif // THREADPOOL_H
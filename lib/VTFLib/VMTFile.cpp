@@ -1,26 +1,105 @@
 #include "VMTFile.h"
 #include <fstream>
-#include <sstream>
-#include <cctype>
-#include <algorithm>
 
 namespace VTFLib {
 
-VMTNode* VMTNode::FindChild(const std::string& name) {
-    std::string lowerName = name;
-    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+namespace {
+
+// Blocks of the "patch" shader whose keys apply to the patched material
+const char* const PATCH_SHADER = "patch";
+const char* const PATCH_BLOCKS[] = { "insert", "replace" };
+
+inline char FoldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (FoldCase(a[i]) != FoldCase(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Index capacity for a block: a power of two at least twice the child count
+uint32_t IndexCapacity(uint32_t childCount) {
+    uint32_t capacity = 16;
+    while (capacity < childCount * 2) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Platform conditionals such as [$WIN32] that may follow a key or value
+inline bool IsConditional(std::string_view token) {
+    return token.size() >= 2 && token.front() == '[' && token.back() == ']';
+}
+
+} // namespace
+
+uint32_t VMTNode::HashName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(FoldCase(c));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+VMTNode* VMTNode::FindChild(std::string_view name) {
+    return const_cast<VMTNode*>(static_cast<const VMTNode*>(this)->FindChild(name, HashName(name)));
+}
+
+const VMTNode* VMTNode::FindChild(std::string_view name) const {
+    return FindChild(name, HashName(name));
+}
+
+const VMTNode* VMTNode::FindChild(std::string_view name, uint32_t hash) const {
+    if (index_) {
+        // Linear probing; children were inserted in file order, so the first match wins
+        for (uint32_t slot = hash & indexMask_; index_[slot]; slot = (slot + 1) & indexMask_) {
+            const VMTNode* child = index_[slot];
+            if (child->hash_ == hash && EqualsIgnoreCase(child->name_, name)) {
+                return child;
+            }
+        }
+        return nullptr;
+    }
     
-    for (auto& child : children_) {
-        std::string childName = child.GetName();
-        std::transform(childName.begin(), childName.end(), childName.begin(), ::tolower);
-        
-        if (childName == lowerName) {
-            return &child;
+    for (const VMTNode* child = firstChild_; child; child = child->next_) {
+        if (child->hash_ == hash && EqualsIgnoreCase(child->name_, name)) {
+            return child;
         }
     }
     return nullptr;
 }
 
+VMTNode* VMTNode::FindPath(std::string_view path) {
+    return const_cast<VMTNode*>(static_cast<const VMTNode*>(this)->FindPath(path));
+}
+
+const VMTNode* VMTNode::FindPath(std::string_view path) const {
+    const VMTNode* node = this;
+    while (node) {
+        size_t slash = path.find('/');
+        std::string_view name = path.substr(0, slash);
+        node = node->FindChild(name);
+        if (slash == std::string_view::npos) {
+            break;
+        }
+        path.remove_prefix(slash + 1);
+    }
+    return node;
+}
+
 VMTFile::VMTFile() {
 }
 
@@ -28,18 +107,55 @@ VMTFile::~VMTFile() {
 }
 
 bool VMTFile::Load(const std::string& filename) {
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         return false;
     }
     
-    std::stringstream buffer;
-    buffer << file.rdbuf();
+    // Read rather than mapped: a VMT is a few KB, and a mapping held by the selected
+    // material would block (Windows) or fault on (POSIX) an editor saving over it. The
+    // text goes straight into content_, which the nodes then point into.
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (size < 0) {
+        return false;
+    }
     
-    return Parse(buffer.str());
+    owner_.reset();
+    content_.resize(static_cast<size_t>(size));
+    file.read(&content_[0], size);
+    content_.resize(static_cast<size_t>(file.gcount()));
+    if (file.bad()) {
+        content_.clear();
+        return false;
+    }
+    return ParseContent(content_);
 }
 
 bool VMTFile::Parse(const std::string& content) {
+    owner_.reset();
+    content_ = content;
+    return ParseContent(content_);
+}
+
+bool VMTFile::Load(const uint8_t* data, size_t size, std::shared_ptr<const void> owner) {
+    if (!owner) {
+        owner_.reset();
+        content_.assign(reinterpret_cast<const char*>(data), size);
+        return ParseContent(content_);
+    }
+    
+    content_.clear();
+    owner_ = std::move(owner);
+    return ParseContent(std::string_view(reinterpret_cast<const char*>(data), size));
+}
+
+bool VMTFile::ParseContent(std::string_view content) {
+    nodes_.clear();
+    indexSlots_.reset();
+    root_ = VMTNode();
+    
     size_t pos = 0;
     SkipWhitespace(content, pos);
     
@@ -58,15 +174,58 @@ bool VMTFile::Parse(const std::string& content) {
     pos++;
     
     // Parse root node
-    root_.SetName(shader_);
+    root_.name_ = shader_;
+    root_.hash_ = VMTNode::HashName(shader_);
     ParseNode(content, pos, root_);
     
+    BuildIndexes();
     return true;
 }
 
-void VMTFile::SkipWhitespace(const std::string& content, size_t& pos) {
+void VMTFile::BuildIndexes() {
+    // One allocation holds the tables of every large block in the file
+    size_t totalSlots = 0;
+    auto countSlots = [&totalSlots](const VMTNode& node) {
+        if (node.childCount_ >= VMT_INDEX_MIN_CHILDREN) {
+            totalSlots += IndexCapacity(node.childCount_);
+        }
+    };
+    countSlots(root_);
+    for (const VMTNode& node : nodes_) {
+        countSlots(node);
+    }
+    if (totalSlots == 0) {
+        return;
+    }
+    
+    indexSlots_.reset(new VMTNode*[totalSlots]());
+    VMTNode** next = indexSlots_.get();
+    auto buildIndex = [&next](VMTNode& node) {
+        if (node.childCount_ < VMT_INDEX_MIN_CHILDREN) {
+            return;
+        }
+        uint32_t capacity = IndexCapacity(node.childCount_);
+        node.index_ = next;
+        node.indexMask_ = capacity - 1;
+        next += capacity;
+        
+        for (VMTNode* child = node.firstChild_; child; child = child->next_) {
+            uint32_t slot = child->hash_ & node.indexMask_;
+            while (node.index_[slot]) {
+                slot = (slot + 1) & node.indexMask_;
+            }
+            node.index_[slot] = child;
+        }
+    };
+    buildIndex(root_);
+    for (VMTNode& node : nodes_) {
+        buildIndex(node);
+    }
+}
+
+void VMTFile::SkipWhitespace(std::string_view content, size_t& pos) {
     while (pos < content.length()) {
-        if (std::isspace(content[pos])) {
+        if (IsSpace(content[pos])) {
             pos++;
         } else if (content[pos] == '/' && pos + 1 < content.length() && content[pos + 1] == '/') {
             // Skip single-line comment
@@ -79,49 +238,46 @@ void VMTFile::SkipWhitespace(const std::string& content, size_t& pos) {
     }
 }
 
-std::string VMTFile::ReadToken(const std::string& content, size_t& pos) {
+std::string_view VMTFile::ReadToken(std::string_view content, size_t& pos) {
     SkipWhitespace(content, pos);
     
     if (pos >= content.length()) {
-        return "";
+        return std::string_view();
     }
     
     if (content[pos] == '"') {
         return ReadQuotedString(content, pos);
     }
     
-    std::string token;
-    while (pos < content.length() && !std::isspace(content[pos]) && 
-           content[pos] != '{' && content[pos] != '}') {
-        token += content[pos++];
+    size_t start = pos;
+    while (pos < content.length() && !IsSpace(content[pos]) &&
+           content[pos] != '{' && content[pos] != '}' && content[pos] != '"') {
+        pos++;
     }
     
-    return token;
+    return content.substr(start, pos - start);
 }
 
-std::string VMTFile::ReadQuotedString(const std::string& content, size_t& pos) {
+std::string_view VMTFile::ReadQuotedString(std::string_view content, size_t& pos) {
     if (pos >= content.length() || content[pos] != '"') {
-        return "";
-    }
-    
-    pos++; // Skip opening quote
-    std::string str;
-    
-    while (pos < content.length() && content[pos] != '"') {
-        if (content[pos] == '\\' && pos + 1 < content.length()) {
-            pos++; // Skip escape character
-        }
-        str += content[pos++];
+        return std::string_view();
     }
     
-    if (pos < content.length()) {
-        pos++; // Skip closing quote
+    // Backslashes are literal, as in the engine's material KeyValues ("models\props\crate")
+    size_t start = ++pos;
+    size_t end = content.find('"', start);
+    if (end == std::string_view::npos) {
+        pos = content.length();
+        return content.substr(start);
     }
     
-    return str;
+    pos = end + 1; // Skip closing quote
+    return content.substr(start, end - start);
 }
 
-void VMTFile::ParseNode(const std::string& content, size_t& pos, VMTNode& node) {
+void VMTFile::ParseNode(std::string_view content, size_t& pos, VMTNode& node) {
+    VMTNode* last = nullptr;
+    
     while (pos < content.length()) {
         SkipWhitespace(content, pos);
         
@@ -135,35 +291,77 @@ void VMTFile::ParseNode(const std::string& content, size_t& pos, VMTNode& node)
         }
         
         // Read parameter name
-        std::string name = ReadToken(content, pos);
+        std::string_view name = ReadToken(content, pos);
         if (name.empty()) {
             break;
         }
+        if (IsConditional(name)) {
+            continue;
+        }
         
         SkipWhitespace(content, pos);
+        if (pos < content.length() && content[pos] == '[') {
+            ReadToken(content, pos);
+            SkipWhitespace(content, pos);
+        }
+        
+        VMTNode& child = nodes_.emplace_back(name);
         
         // Check if it's a nested node
         if (pos < content.length() && content[pos] == '{') {
             pos++;
-            VMTNode child(name);
             ParseNode(content, pos, child);
-            node.AddChild(child);
         } else {
             // Read parameter value
-            std::string value = ReadToken(content, pos);
-            VMTNode child(name);
-            child.SetValue(value);
-            node.AddChild(child);
+            child.value_ = ReadToken(content, pos);
         }
+        
+        if (last) {
+            last->next_ = &child;
+        } else {
+            node.firstChild_ = &child;
+        }
+        last = &child;
+        node.childCount_++;
     }
 }
 
 std::string VMTFile::GetBaseTexture() const {
-    VMTNode* baseTexNode = const_cast<VMTNode*>(&root_)->FindChild("$basetexture");
+    const VMTNode* baseTexNode = root_.FindChild("$basetexture");
     if (baseTexNode) {
-        return baseTexNode->GetValue();
+        return std::string(baseTexNode->GetValue());
     }
     return "";
 }
 
+std::vector<const VMTNode*> VMTFile::GetParameterBlocks() const {
+    std::vector<const VMTNode*> blocks{ &root_ };
+    if (EqualsIgnoreCase(shader_, PATCH_SHADER)) {
+        for (const char* blockName : PATCH_BLOCKS) {
+            if (const VMTNode* block = root_.FindChild(blockName)) {
+                blocks.push_back(block);
+            }
+        }
+    }
+    return blocks;
+}
+
+std::vector<const VMTNode*> VMTFile::GetTextureReferences() const {
+    std::vector<const VMTNode*> references;
+    for (const VMTNode* block : GetParameterBlocks()) {
+        for (const VMTNode& child : block->GetChildren()) {
+            if (!child.GetChildren().empty() || child.GetValue().empty()) {
+                continue;
+            }
+            for (const char* parameter : VMT_TEXTURE_PARAMETERS) {
+                if (EqualsIgnoreCase(child.GetName(), parameter)) {
+                    references.push_back(&child);
+                    break;
+                }
+            }
+        }
+    }
+    return references;
+}
+
 } // namespace VTFLib
@@ -1,31 +1,97 @@
 #ifndef VMTFILE_H
 #define VMTFILE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
-#include <map>
+#include <string_view>
 #include <vector>
 
 namespace VTFLib {
 
+// Blocks with at least this many children get a hashed index for FindChild
+const uint32_t VMT_INDEX_MIN_CHILDREN = 8;
+
+// Parameters whose values name textures
+const char* const VMT_TEXTURE_PARAMETERS[] = {
+    "$basetexture", "$basetexture2", "$bumpmap", "$bumpmap2", "$normalmap",
+    "$detail", "$detail2", "$envmap", "$envmapmask", "$selfillummask",
+    "$phongexponenttexture", "$lightwarptexture", "$blendmodulatetexture",
+    "$dudvmap", "$refracttexture", "$reflecttexture", "$texture2",
+    "$iris", "$corneatexture", "$ambientoccltexture", "$tintmasktexture",
+};
+
+// A key with either a value or a block of child keys. Names and values view the text
+// owned by the VMTFile that parsed them, and nodes live in that file's arena, so a node
+// is only valid as long as its file.
 class VMTNode {
 public:
-    VMTNode(const std::string& name = "") : name_(name) {}
+    class ChildIterator {
+    public:
+        explicit ChildIterator(const VMTNode* node) : node_(node) {}
+        const VMTNode& operator*() const { return *node_; }
+        const VMTNode* operator->() const { return node_; }
+        ChildIterator& operator++() { node_ = node_->next_; return *this; }
+        bool operator==(const ChildIterator& other) const { return node_ == other.node_; }
+        bool operator!=(const ChildIterator& other) const { return node_ != other.node_; }
+        
+    private:
+        const VMTNode* node_;
+    };
+    
+    // Range over a node's children, in file order
+    class Children {
+    public:
+        explicit Children(const VMTNode* first) : first_(first) {}
+        ChildIterator begin() const { return ChildIterator(first_); }
+        ChildIterator end() const { return ChildIterator(nullptr); }
+        bool empty() const { return first_ == nullptr; }
+        
+    private:
+        const VMTNode* first_;
+    };
     
-    void SetName(const std::string& name) { name_ = name; }
-    std::string GetName() const { return name_; }
+    explicit VMTNode(std::string_view name = std::string_view())
+        : name_(name), hash_(HashName(name)), childCount_(0), indexMask_(0),
+          firstChild_(nullptr), next_(nullptr), index_(nullptr) {}
     
-    void SetValue(const std::string& value) { value_ = value; }
-    std::string GetValue() const { return value_; }
+    VMTNode(const VMTNode&) = delete;
+    VMTNode& operator=(const VMTNode&) = delete;
+    VMTNode(VMTNode&&) = default;
+    VMTNode& operator=(VMTNode&&) = default;
     
-    void AddChild(const VMTNode& child) { children_.push_back(child); }
-    const std::vector<VMTNode>& GetChildren() const { return children_; }
+    std::string_view GetName() const { return name_; }
+    std::string_view GetValue() const { return value_; }
     
-    VMTNode* FindChild(const std::string& name);
+    Children GetChildren() const { return Children(firstChild_); }
+    uint32_t GetChildCount() const { return childCount_; }
+    
+    // Case-insensitive lookup of a direct child; the first match wins for repeated keys
+    VMTNode* FindChild(std::string_view name);
+    const VMTNode* FindChild(std::string_view name) const;
+    
+    // Case-insensitive lookup through nested blocks, e.g. "Proxies/AnimatedTexture/animatedtextureframerate"
+    VMTNode* FindPath(std::string_view path);
+    const VMTNode* FindPath(std::string_view path) const;
+    
+    // Case-folded FNV-1a hash of a key name, as stored for every node
+    static uint32_t HashName(std::string_view name);
     
 private:
-    std::string name_;
-    std::string value_;
-    std::vector<VMTNode> children_;
+    friend class VMTFile;
+    
+    std::string_view name_;
+    std::string_view value_;
+    uint32_t hash_;
+    uint32_t childCount_;
+    uint32_t indexMask_;    // slot count - 1 when index_ is set
+    VMTNode* firstChild_;
+    VMTNode* next_;
+    VMTNode** index_;       // open-addressed child table in the file's index storage
+    
+    const VMTNode* FindChild(std::string_view name, uint32_t hash) const;
 };
 
 class VMTFile {
@@ -33,23 +99,47 @@ public:
     VMTFile();
     ~VMTFile();
     
+    // Read a file into memory, so nothing stays open while the material is kept
     bool Load(const std::string& filename);
     bool Parse(const std::string& content);
     
+    // Parse a VMT in memory. With an owner the text is used in place and the owner is
+    // kept alive for as long as this file; without one it is copied.
+    bool Load(const uint8_t* data, size_t size, std::shared_ptr<const void> owner = nullptr);
+    
     VMTNode* GetRoot() { return &root_; }
     const VMTNode* GetRoot() const { return &root_; }
     
-    std::string GetShader() const { return shader_; }
+    std::string GetShader() const { return std::string(shader_); }
     std::string GetBaseTexture() const;
     
+    // Blocks whose keys are material parameters: the root, plus the insert and
+    // replace blocks of a patch material
+    std::vector<const VMTNode*> GetParameterBlocks() const;
+    
+    // Every parameter naming a texture, in file order (see VMT_TEXTURE_PARAMETERS)
+    std::vector<const VMTNode*> GetTextureReferences() const;
+    
 private:
     VMTNode root_;
-    std::string shader_;
+    std::string_view shader_;
+    
+    // The text every node views: a mapped file or other owned buffer, or a private copy
+    std::shared_ptr<const void> owner_;
+    std::string content_;
+    
+    // Node arena; a deque never moves its elements, so child links stay valid
+    std::deque<VMTNode> nodes_;
+    
+    // Slots of every child index, sized once the whole tree is parsed
+    std::unique_ptr<VMTNode*[]> indexSlots_;
     
-    void ParseNode(const std::string& content, size_t& pos, VMTNode& node);
-    void SkipWhitespace(const std::string& content, size_t& pos);
-    std::string ReadToken(const std::string& content, size_t& pos);
-    std::string ReadQuotedString(const std::string& content, size_t& pos);
+    void BuildIndexes();
+    bool ParseContent(std::string_view content);
+    void ParseNode(std::string_view content, size_t& pos, VMTNode& node);
+    void SkipWhitespace(std::string_view content, size_t& pos);
+    std::string_view ReadToken(std::string_view content, size_t& pos);
+    std::string_view ReadQuotedString(std::string_view content, size_t& pos);
 };
 
 } // namespace VTFLib
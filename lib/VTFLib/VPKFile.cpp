@@ -0,0 +1,296 @@
+#include "VPKFile.h"
+#include "MappedFile.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace VTFLib {
+
+namespace {
+
+const uint32_t VPK_V1_HEADER_SIZE = 12;
+const uint32_t VPK_V2_HEADER_SIZE = 28;
+const uint16_t VPK_ENTRY_TERMINATOR = 0xFFFF;
+const size_t VPK_ENTRY_SIZE = 18;
+
+inline uint16_t ReadU16(const uint8_t* p) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t ReadU32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Read a NUL-terminated string and step past it (false if it runs off the end)
+bool ReadString(const uint8_t*& cursor, const uint8_t* end, const char*& str, size_t& length) {
+    const void* terminator = memchr(cursor, 0, end - cursor);
+    if (!terminator) {
+        return false;
+    }
+    str = reinterpret_cast<const char*>(cursor);
+    length = static_cast<const uint8_t*>(terminator) - cursor;
+    cursor += length + 1;
+    return true;
+}
+
+inline char NormalizePathChar(char c) {
+    if (c == '\\') {
+        return '/';
+    }
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+void AppendNormalized(std::vector<char>& pool, const char* str, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        pool.push_back(NormalizePathChar(str[i]));
+    }
+}
+
+} // namespace
+
+VPKFile::VPKFile() : dataOffset_(0) {
+}
+
+VPKFile::~VPKFile() {
+}
+
+bool VPKFile::Load(const std::string& filename) {
+    entries_.clear();
+    pathPool_.clear();
+    archives_.clear();
+    
+    dirFile_ = MappedFile::Map(filename);
+    if (!dirFile_ || dirFile_->GetSize() < VPK_V1_HEADER_SIZE) {
+        return false;
+    }
+    
+    const uint8_t* data = dirFile_->GetData();
+    size_t size = dirFile_->GetSize();
+    
+    if (ReadU32(data) != VPK_SIGNATURE) {
+        return false;
+    }
+    
+    uint32_t version = ReadU32(data + 4);
+    uint32_t headerSize;
+    if (version == 1) {
+        headerSize = VPK_V1_HEADER_SIZE;
+    } else if (version == 2) {
+        headerSize = VPK_V2_HEADER_SIZE;
+    } else {
+        return false;
+    }
+    
+    uint32_t treeSize = ReadU32(data + 8);
+    if (headerSize > size || treeSize > size - headerSize) {
+        return false;
+    }
+    dataOffset_ = headerSize + treeSize;
+    
+    if (!ParseTree(data + headerSize, data + dataOffset_)) {
+        entries_.clear();
+        pathPool_.clear();
+        return false;
+    }
+    
+    // Sort once so lookups are a binary search over the compact index
+    const char* pool = pathPool_.data();
+    std::sort(entries_.begin(), entries_.end(), [pool](const VPKEntry& a, const VPKEntry& b) {
+        return strcmp(pool + a.pathOffset, pool + b.pathOffset) < 0;
+    });
+    
+    // "name_dir.vpk" keeps its data in "name_000.vpk", "name_001.vpk", ...
+    filename_ = filename;
+    archivePrefix_.clear();
+    const std::string dirSuffix = "_dir.vpk";
+    if (filename.size() > dirSuffix.size()) {
+        std::string tail = filename.substr(filename.size() - dirSuffix.size());
+        std::transform(tail.begin(), tail.end(), tail.begin(), NormalizePathChar);
+        if (tail == dirSuffix) {
+            archivePrefix_ = filename.substr(0, filename.size() - dirSuffix.size() + 1);
+        }
+    }
+    
+    return true;
+}
+
+std::shared_ptr<const VPKFile> VPKFile::Open(const std::string& filename) {
+    auto file = std::make_shared<VPKFile>();
+    if (!file->Load(filename)) {
+        return nullptr;
+    }
+    return file;
+}
+
+bool VPKFile::ParseTree(const uint8_t* tree, const uint8_t* end) {
+    const uint8_t* base = dirFile_->GetData();
+    const uint8_t* cursor = tree;
+    const char* extension;
+    const char* directory;
+    const char* name;
+    size_t extensionLength;
+    size_t directoryLength;
+    size_t nameLength;
+    
+    // Three levels of NUL-terminated strings, each list closed by an empty string:
+    // extension -> directory -> file name -> entry. " " stands for "none".
+    for (;;) {
+        if (!ReadString(cursor, end, extension, extensionLength)) {
+            return false;
+        }
+        if (extensionLength == 0) {
+            break;
+        }
+        
+        for (;;) {
+            if (!ReadString(cursor, end, directory, directoryLength)) {
+                return false;
+            }
+            if (directoryLength == 0) {
+                break;
+            }
+            
+            for (;;) {
+                if (!ReadString(cursor, end, name, nameLength)) {
+                    return false;
+                }
+                if (nameLength == 0) {
+                    break;
+                }
+                if (static_cast<size_t>(end - cursor) < VPK_ENTRY_SIZE) {
+                    return false;
+                }
+                
+                VPKEntry entry;
+                entry.crc = ReadU32(cursor);
+                entry.preloadBytes = ReadU16(cursor + 4);
+                entry.archiveIndex = ReadU16(cursor + 6);
+                entry.offset = ReadU32(cursor + 8);
+                entry.length = ReadU32(cursor + 12);
+                if (ReadU16(cursor + 16) != VPK_ENTRY_TERMINATOR) {
+                    return false;
+                }
+                cursor += VPK_ENTRY_SIZE;
+                
+                if (static_cast<size_t>(end - cursor) < entry.preloadBytes) {
+                    return false;
+                }
+                entry.preloadOffset = static_cast<uint32_t>(cursor - base);
+                cursor += entry.preloadBytes;
+                
+                entry.pathOffset = static_cast<uint32_t>(pathPool_.size());
+                if (!(directoryLength == 1 && directory[0] == ' ')) {
+                    AppendNormalized(pathPool_, directory, directoryLength);
+                    pathPool_.push_back('/');
+                }
+                AppendNormalized(pathPool_, name, nameLength);
+                if (!(extensionLength == 1 && extension[0] == ' ')) {
+                    pathPool_.push_back('.');
+                    AppendNormalized(pathPool_, extension, extensionLength);
+                }
+                pathPool_.push_back('\0');
+                
+                entries_.push_back(entry);
+            }
+        }
+    }
+    
+    pathPool_.shrink_to_fit();
+    entries_.shrink_to_fit();
+    return true;
+}
+
+const VPKEntry* VPKFile::FindEntry(const std::string& path) const {
+    std::string key(path.size(), '\0');
+    std::transform(path.begin(), path.end(), key.begin(), NormalizePathChar);
+    
+    const char* pool = pathPool_.data();
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), key,
+        [pool](const VPKEntry& entry, const std::string& value) {
+            return strcmp(pool + entry.pathOffset, value.c_str()) < 0;
+        });
+    
+    if (it == entries_.end() || key != pool + it->pathOffset) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+std::shared_ptr<const MappedFile> VPKFile::GetArchive(uint16_t index) const {
+    if (index == VPK_DIR_ARCHIVE_INDEX) {
+        return dirFile_;
+    }
+    if (archivePrefix_.empty()) {
+        return nullptr;
+    }
+    
+    std::lock_guard<std::mutex> lock(archivesMutex_);
+    if (index >= archives_.size()) {
+        archives_.resize(index + 1);
+    }
+    if (!archives_[index]) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "%03u.vpk", static_cast<unsigned>(index));
+        archives_[index] = MappedFile::Map(archivePrefix_ + suffix);
+    }
+    return archives_[index];
+}
+
+bool VPKFile::GetEntryData(const VPKEntry& entry, const uint8_t*& data, size_t& size,
+                           std::shared_ptr<const void>& owner) const {
+    const uint8_t* preload = dirFile_->GetData() + entry.preloadOffset;
+    
+    if (entry.length == 0) {
+        data = preload;
+        size = entry.preloadBytes;
+        owner = dirFile_;
+        return true;
+    }
+    
+    std::shared_ptr<const MappedFile> archive = GetArchive(entry.archiveIndex);
+    if (!archive) {
+        return false;
+    }
+    
+    // Data kept in the _dir file is addressed from the end of the tree
+    uint64_t offset = entry.offset;
+    if (entry.archiveIndex == VPK_DIR_ARCHIVE_INDEX) {
+        offset += dataOffset_;
+    }
+    if (offset + entry.length > archive->GetSize()) {
+        return false;
+    }
+    const uint8_t* archived = archive->GetData() + offset;
+    
+    if (entry.preloadBytes == 0) {
+        data = archived;
+        size = entry.length;
+        owner = archive;
+        return true;
+    }
+    
+    // Split between the directory and an archive: stitch the two halves together
+    auto joined = std::make_shared<std::vector<uint8_t>>(preload, preload + entry.preloadBytes);
+    joined->insert(joined->end(), archived, archived + entry.length);
+    data = joined->data();
+    size = joined->size();
+    owner = joined;
+    return true;
+}
+
+std::shared_ptr<const VTFFile> VPKFile::OpenVTF(const VPKEntry& entry) const {
+    const uint8_t* data;
+    size_t size;
+    std::shared_ptr<const void> owner;
+    if (!GetEntryData(entry, data, size, owner)) {
+        return nullptr;
+    }
+    return VTFFile::Open(data, size, std::move(owner));
+}
+
+} // namespace VTFLib
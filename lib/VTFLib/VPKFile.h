@@ -0,0 +1,78 @@
+#ifndef VPKFILE_H
+#define VPKFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace VTFLib {
+
+class MappedFile;
+class VTFFile;
+
+// VPK directory signature and the archive index of data stored in the _dir file itself
+const uint32_t VPK_SIGNATURE = 0x55AA1234;
+const uint16_t VPK_DIR_ARCHIVE_INDEX = 0x7FFF;
+
+// One file in a VPK. Kept small: a 40k-entry archive indexes in under a megabyte.
+struct VPKEntry {
+    uint32_t pathOffset;     // lowercase "dir/name.ext" in the path pool
+    uint32_t crc;
+    uint32_t preloadOffset;  // preload bytes, inside the _dir file
+    uint32_t offset;         // data offset within the archive
+    uint32_t length;         // data length, not counting preload bytes
+    uint16_t preloadBytes;
+    uint16_t archiveIndex;
+};
+
+// Valve Pak (VPK v1/v2) reader. The directory tree is parsed once into a path-sorted
+// index; the _dir file and the numbered data archives are memory-mapped, the latter
+// on first use. Thread-safe once loaded.
+class VPKFile {
+public:
+    VPKFile();
+    ~VPKFile();
+    
+    // Load the directory of "name_dir.vpk" (or a single-file "name.vpk")
+    bool Load(const std::string& filename);
+    
+    // Load a VPK into a new shareable, read-only object (nullptr on failure)
+    static std::shared_ptr<const VPKFile> Open(const std::string& filename);
+    
+    size_t GetEntryCount() const { return entries_.size(); }
+    const VPKEntry& GetEntry(size_t index) const { return entries_[index]; }
+    const char* GetEntryPath(const VPKEntry& entry) const { return pathPool_.data() + entry.pathOffset; }
+    
+    // Binary search for a path (case-insensitive, either slash); nullptr if absent
+    const VPKEntry* FindEntry(const std::string& path) const;
+    
+    // Contents of an entry. Points straight into the mapped archive, with owner keeping it
+    // mapped, unless the entry is split between preload bytes and an archive; those are copied.
+    bool GetEntryData(const VPKEntry& entry, const uint8_t*& data, size_t& size,
+                      std::shared_ptr<const void>& owner) const;
+    
+    // Load a VTF stored in the archive without extracting it (nullptr on failure)
+    std::shared_ptr<const VTFFile> OpenVTF(const VPKEntry& entry) const;
+    
+    const std::string& GetFilename() const { return filename_; }
+    
+private:
+    std::string filename_;
+    std::string archivePrefix_;  // "path/name_" for the name_NNN.vpk data archives
+    std::shared_ptr<const MappedFile> dirFile_;
+    uint32_t dataOffset_;        // start of the data stored in the _dir file
+    std::vector<VPKEntry> entries_;
+    std::vector<char> pathPool_;
+    
+    mutable std::mutex archivesMutex_;
+    mutable std::vector<std::shared_ptr<const MappedFile>> archives_;
+    
+    bool ParseTree(const uint8_t* tree, const uint8_t* end);
+    std::shared_ptr<const MappedFile> GetArchive(uint16_t index) const;
+};
+
+} // namespace VTFLib
+
+#endif // VPKFILE_H
@@ -0,0 +1,142 @@
+#include "VRAMBudget.h"
+#include "TextureMetadataIndex.h"
+#include "ThreadPool.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <map>
+#include <string_view>
+
+namespace VTFLib {
+
+namespace {
+
+uint64_t TextureSize(const TextureMetadata& metadata, VTFImageFormat format, uint32_t droppedMips) {
+    return VTFFile::ComputeTextureSize(
+        static_cast<uint16_t>(std::max(1, metadata.width >> droppedMips)),
+        static_cast<uint16_t>(std::max(1, metadata.height >> droppedMips)),
+        static_cast<uint16_t>(std::max(1, metadata.depth >> droppedMips)),
+        metadata.frames, GetFaceCount(metadata.flags), metadata.mipmapCount - droppedMips, format);
+}
+
+// Mips a scenario can drop from a texture: never its last level, and none from textures
+// the engine doesn't reduce either
+uint32_t DroppableMips(const TextureMetadata& metadata, uint32_t droppedMips) {
+    if (metadata.flags & (TEXTUREFLAGS_NOLOD | TEXTUREFLAGS_NOMIP) || metadata.mipmapCount <= 1) {
+        return 0;
+    }
+    return std::min<uint32_t>(droppedMips, metadata.mipmapCount - 1u);
+}
+
+// Format after the scenario's recompression; tiny textures stay as they are when DXT's
+// 4x4 blocks would make them larger
+VTFImageFormat ProjectedFormat(const TextureMetadata& metadata, const BudgetScenario& scenario) {
+    VTFImageFormat format = static_cast<VTFImageFormat>(metadata.format);
+    if (!scenario.compress) {
+        return format;
+    }
+    VTFImageFormat compressed = VRAMBudget::CompressedFormat(format, metadata.flags);
+    if (compressed == IMAGE_FORMAT_NONE || TextureSize(metadata, compressed, 0) >= TextureSize(metadata, format, 0)) {
+        return format;
+    }
+    return compressed;
+}
+
+std::string_view DirectoryOf(std::string_view path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+}
+
+} // namespace
+
+VTFImageFormat VRAMBudget::CompressedFormat(VTFImageFormat format, uint32_t flags) {
+    bool alpha = false;
+    switch (format) {
+    case IMAGE_FORMAT_RGBA8888:
+    case IMAGE_FORMAT_ABGR8888:
+    case IMAGE_FORMAT_ARGB8888:
+    case IMAGE_FORMAT_BGRA8888:
+    case IMAGE_FORMAT_BGRA4444:
+    case IMAGE_FORMAT_BGRA5551:
+    case IMAGE_FORMAT_IA88:
+    case IMAGE_FORMAT_A8:
+        alpha = true;
+        break;
+    case IMAGE_FORMAT_RGB888:
+    case IMAGE_FORMAT_BGR888:
+    case IMAGE_FORMAT_RGB888_BLUESCREEN:
+    case IMAGE_FORMAT_BGR888_BLUESCREEN:
+    case IMAGE_FORMAT_BGRX8888:
+    case IMAGE_FORMAT_RGB565:
+    case IMAGE_FORMAT_BGR565:
+    case IMAGE_FORMAT_BGRX5551:
+    case IMAGE_FORMAT_I8:
+        break;
+    default:
+        return IMAGE_FORMAT_NONE;
+    }
+    
+    // The alpha flags say whether the channel is actually used
+    if (alpha && !(flags & (TEXTUREFLAGS_ONEBITALPHA | TEXTUREFLAGS_EIGHTBITALPHA))) {
+        alpha = false;
+    }
+    if (alpha && !(flags & TEXTUREFLAGS_EIGHTBITALPHA)) {
+        return IMAGE_FORMAT_DXT1_ONEBITALPHA;
+    }
+    return alpha ? IMAGE_FORMAT_DXT5 : IMAGE_FORMAT_DXT1;
+}
+
+uint64_t VRAMBudget::ProjectedSize(const TextureMetadata& metadata, const BudgetScenario& scenario) {
+    return TextureSize(metadata, ProjectedFormat(metadata, scenario), DroppableMips(metadata, scenario.droppedMips));
+}
+
+std::vector<BudgetProjection> VRAMBudget::Project(const TextureMetadataIndex& index, const BudgetScenario& scenario) {
+    uint32_t rowCount = static_cast<uint32_t>(index.GetCount());
+    std::vector<std::map<std::string_view, BudgetProjection>> partials((rowCount + BUDGET_GRAIN - 1) / BUDGET_GRAIN);
+    
+    ThreadPool::Shared().ParallelFor(rowCount, BUDGET_GRAIN,
+        [&index, &partials, &scenario](uint32_t begin, uint32_t end) {
+            std::map<std::string_view, BudgetProjection>& directories = partials[begin / BUDGET_GRAIN];
+            for (uint32_t row = begin; row < end; ++row) {
+                TextureMetadata texture = index.GetMetadata(row);
+                if (!texture.IsValid()) {
+                    continue;
+                }
+                
+                // Compression first, then mips dropped from the recompressed texture
+                VTFImageFormat format = ProjectedFormat(texture, scenario);
+                uint64_t current = TextureSize(texture, static_cast<VTFImageFormat>(texture.format), 0);
+                uint64_t recompressed = TextureSize(texture, format, 0);
+                uint64_t projected = TextureSize(texture, format, DroppableMips(texture, scenario.droppedMips));
+                
+                BudgetProjection& directory = directories[DirectoryOf(index.GetPath(row))];
+                directory.count++;
+                directory.vramBytes += current;
+                directory.compressionSaving += current - recompressed;
+                directory.mipSaving += recompressed - projected;
+            }
+        });
+    
+    std::map<std::string_view, BudgetProjection> merged;
+    for (const auto& partial : partials) {
+        for (const auto& entry : partial) {
+            BudgetProjection& directory = merged[entry.first];
+            directory.count += entry.second.count;
+            directory.vramBytes += entry.second.vramBytes;
+            directory.compressionSaving += entry.second.compressionSaving;
+            directory.mipSaving += entry.second.mipSaving;
+        }
+    }
+    
+    std::vector<BudgetProjection> projections;
+    projections.reserve(merged.size());
+    for (auto& entry : merged) {
+        entry.second.directory = std::string(entry.first);
+        projections.push_back(std::move(entry.second));
+    }
+    std::stable_sort(projections.begin(), projections.end(), [](const BudgetProjection& a, const BudgetProjection& b) {
+        return a.compressionSaving + a.mipSaving > b.compressionSaving + b.mipSaving;
+    });
+    return projections;
+}
+
+} // namespace VTFLib
@@ -0,0 +1,53 @@
+#ifndef VRAMBUDGET_H
+#define VRAMBUDGET_H
+
+#include "VTFFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VTFLib {
+
+class TextureMetadataIndex;
+struct TextureMetadata;
+
+// Index rows projected per thread pool chunk
+const uint32_t BUDGET_GRAIN = 2048;
+
+// Changes whose effect on VRAM a projection estimates
+struct BudgetScenario {
+    bool compress = true;       // uncompressed colour formats to DXT1, or DXT5 with alpha
+    uint32_t droppedMips = 0;   // top mips removed from textures that allow LOD
+};
+
+// VRAM of the textures directly inside one directory, now and under a scenario
+struct BudgetProjection {
+    std::string directory;
+    uint64_t count = 0;
+    uint64_t vramBytes = 0;          // as stored now
+    uint64_t compressionSaving = 0;  // from recompressing
+    uint64_t mipSaving = 0;          // from dropping mips, on top of recompressing
+    
+    uint64_t ProjectedBytes() const { return vramBytes - compressionSaving - mipSaving; }
+};
+
+// What-if analysis of a texture tree against a VRAM budget. Sizes are exact, built on
+// VTFFile::ComputeTextureSize from the header fields of the metadata index, so nothing
+// is decoded and a whole game install projects in well under a second.
+class VRAMBudget {
+public:
+    // Per directory, largest total saving first
+    static std::vector<BudgetProjection> Project(const TextureMetadataIndex& index, const BudgetScenario& scenario);
+    
+    // The block format a texture would be recompressed to, or IMAGE_FORMAT_NONE if it is
+    // compressed already or holds data DXT would damage (HDR, bump, DuDv, palettes)
+    static VTFImageFormat CompressedFormat(VTFImageFormat format, uint32_t flags);
+    
+    // VRAM of one texture under a scenario
+    static uint64_t ProjectedSize(const TextureMetadata& metadata, const BudgetScenario& scenario);
+};
+
+} // namespace VTFLib
+
+#endif // VRAMBUDGET_H
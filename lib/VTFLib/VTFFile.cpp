@@ -1,11 +1,13 @@
 #include "VTFFile.h"
+#include "ThreadPool.h"
+#include "BufferPool.h"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
 
 namespace VTFLib {
 
-VTFFile::VTFFile() : loaded_(false) {
+VTFFile::VTFFile() : imageData_(nullptr), imageDataSize_(0), loaded_(false) {
     memset(&header_, 0, sizeof(VTFHeader));
 }
 
@@ -13,13 +15,34 @@ VTFFile::~VTFFile() {
 }
 
 bool VTFFile::Load(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         return false;
     }
     
+    std::streamoff fileSize = file.tellg();
+    if (fileSize <= 0) {
+        return false;
+    }
+    
+    // Read the whole file; the image data is then used in place
+    auto contents = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(fileSize));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(contents->data()), fileSize)) {
+        return false;
+    }
+    
+    return Load(contents->data(), contents->size(), contents);
+}
+
+bool VTFFile::Load(const uint8_t* data, size_t size, std::shared_ptr<const void> owner) {
+    loaded_ = false;
+    if (!data || size < sizeof(VTFHeader)) {
+        return false;
+    }
+    
     // Read header
-    file.read(reinterpret_cast<char*>(&header_), sizeof(VTFHeader));
+    memcpy(&header_, data, sizeof(VTFHeader));
     
     // Verify signature
     if (strncmp(header_.signature, VTF_SIGNATURE, 4) != 0) {
@@ -31,84 +54,185 @@ bool VTFFile::Load(const std::string& filename) {
         return false;
     }
     
-    // Calculate total image data size
-    uint32_t totalSize = 0;
-    for (uint32_t frame = 0; frame < header_.frames; ++frame) {
-        for (uint32_t mip = 0; mip < header_.mipmapCount; ++mip) {
-            uint16_t mipWidth = std::max(1, header_.width >> mip);
-            uint16_t mipHeight = std::max(1, header_.height >> mip);
-            totalSize += ComputeImageSize(mipWidth, mipHeight, 
-                static_cast<VTFImageFormat>(header_.highResImageFormat));
-        }
+    // Reject shapes the decoder can't walk; VTFValidator explains what is wrong
+    VTFImageFormat format = static_cast<VTFImageFormat>(header_.highResImageFormat);
+    if (header_.width == 0 || header_.height == 0 || header_.frames == 0 || GetImageFormatBPP(format) == 0 ||
+        header_.mipmapCount == 0 || header_.mipmapCount > ComputeFullMipmapCount(header_.width, header_.height, GetDepth())) {
+        return false;
     }
     
-    // Seek to image data (after header)
-    file.seekg(header_.headerSize);
+    // Calculate total image data size
+    uint64_t totalSize = ComputeTextureSize(header_.width, header_.height, GetDepth(), header_.frames,
+                                            GetStoredFaceCount(header_), header_.mipmapCount, format);
     
-    // Read low-res image if present
-    if (static_cast<VTFImageFormat>(header_.lowResImageFormat) != IMAGE_FORMAT_NONE) {
-        uint32_t lowResSize = ComputeImageSize(header_.lowResImageWidth, 
+    // 7.3+ locate the image data through the resource dictionary; before that it follows
+    // the header and the low-res image, if present
+    uint64_t offset = header_.headerSize;
+    if (header_.version[1] >= 3) {
+        if (!LocateResource(data, size, RESOURCE_HIGH_RES_IMAGE, offset)) {
+            return false;
+        }
+    } else if (static_cast<VTFImageFormat>(header_.lowResImageFormat) != IMAGE_FORMAT_NONE) {
+        offset += ComputeImageSize(header_.lowResImageWidth, 
             header_.lowResImageHeight, 
             static_cast<VTFImageFormat>(header_.lowResImageFormat));
-        file.seekg(lowResSize, std::ios::cur);
     }
     
-    // Read image data
-    imageData_.resize(totalSize);
-    file.read(reinterpret_cast<char*>(imageData_.data()), totalSize);
+    if (offset > size || totalSize > size - offset) {
+        return false;
+    }
+    
+    if (owner) {
+        imageData_ = data + offset;
+    } else {
+        auto copy = std::make_shared<std::vector<uint8_t>>(data + offset, data + offset + totalSize);
+        imageData_ = copy->data();
+        owner = copy;
+    }
+    dataOwner_ = std::move(owner);
+    imageDataSize_ = static_cast<size_t>(totalSize);
     
     loaded_ = true;
     return true;
 }
 
-uint32_t VTFFile::ComputeImageSize(uint16_t width, uint16_t height, VTFImageFormat format) const {
-    uint32_t bpp = GetImageFormatBPP(format);
+std::shared_ptr<const VTFFile> VTFFile::Open(const std::string& filename) {
+    auto file = std::make_shared<VTFFile>();
+    if (!file->Load(filename)) {
+        return nullptr;
+    }
+    return file;
+}
+
+std::shared_ptr<const VTFFile> VTFFile::Open(const uint8_t* data, size_t size,
+                                             std::shared_ptr<const void> owner) {
+    auto file = std::make_shared<VTFFile>();
+    if (!file->Load(data, size, std::move(owner))) {
+        return nullptr;
+    }
+    return file;
+}
+
+uint64_t VTFFile::ComputeImageSize(uint16_t width, uint16_t height, VTFImageFormat format) {
+    uint64_t bpp = GetImageFormatBPP(format);
     
+    // 64-bit throughout: a 65535 x 65535 header must not wrap to a small payload
     // DXT formats are block-compressed (4x4 blocks)
     if (format == IMAGE_FORMAT_DXT1 || format == IMAGE_FORMAT_DXT1_ONEBITALPHA) {
-        uint32_t blockWidth = (width + 3) / 4;
-        uint32_t blockHeight = (height + 3) / 4;
+        uint64_t blockWidth = (width + 3) / 4;
+        uint64_t blockHeight = (height + 3) / 4;
         return blockWidth * blockHeight * 8; // 8 bytes per block for DXT1
     } else if (format == IMAGE_FORMAT_DXT3 || format == IMAGE_FORMAT_DXT5) {
-        uint32_t blockWidth = (width + 3) / 4;
-        uint32_t blockHeight = (height + 3) / 4;
+        uint64_t blockWidth = (width + 3) / 4;
+        uint64_t blockHeight = (height + 3) / 4;
         return blockWidth * blockHeight * 16; // 16 bytes per block for DXT3/5
     }
     
-    return (width * height * bpp) / 8;
+    return (static_cast<uint64_t>(width) * height * bpp) / 8;
 }
 
-uint32_t VTFFile::ComputeMipmapOffset(uint32_t frame, uint32_t mipmap) const {
-    uint32_t offset = 0;
+uint64_t VTFFile::ComputeTextureSize(uint16_t width, uint16_t height, uint16_t depth, uint16_t frames,
+                                     uint32_t faces, uint32_t mipmapCount, VTFImageFormat format) {
+    uint64_t size = 0;
+    for (uint32_t m = 0; m < mipmapCount; ++m) {
+        uint16_t mipWidth = std::max(1, width >> m);
+        uint16_t mipHeight = std::max(1, height >> m);
+        uint16_t mipDepth = std::max(1, depth >> m);
+        size += ComputeImageSize(mipWidth, mipHeight, format) * mipDepth;
+    }
+    return size * std::max<uint16_t>(frames, 1) * std::max<uint32_t>(faces, 1);
+}
+
+uint64_t VTFFile::GetVRAMSize() const {
+    if (!loaded_) {
+        return 0;
+    }
+    return ComputeTextureSize(header_.width, header_.height, GetDepth(), header_.frames, GetFaceCount(header_.flags),
+                              header_.mipmapCount, static_cast<VTFImageFormat>(header_.highResImageFormat));
+}
+
+size_t VTFFile::ComputeMipmapOffset(uint32_t frame, uint32_t mipmap) const {
     VTFImageFormat format = static_cast<VTFImageFormat>(header_.highResImageFormat);
+    uint32_t faces = GetStoredFaceCount(header_);
+    
+    // VTF stores mipmaps from smallest to largest, each with every frame, then every face,
+    // then every depth slice; skip the smaller mips whole
+    uint64_t offset = ComputeTextureSize(header_.width, header_.height, GetDepth(), header_.frames, faces,
+                                         header_.mipmapCount, format) -
+                      ComputeTextureSize(header_.width, header_.height, GetDepth(), header_.frames, faces,
+                                         mipmap + 1, format);
     
-    // Add offsets for previous frames
-    for (uint32_t f = 0; f < frame; ++f) {
-        for (uint32_t m = 0; m < header_.mipmapCount; ++m) {
-            uint16_t mipWidth = std::max(1, header_.width >> m);
-            uint16_t mipHeight = std::max(1, header_.height >> m);
-            offset += ComputeImageSize(mipWidth, mipHeight, format);
+    // Then the earlier frames of this mip, landing on the frame's first face and slice
+    uint16_t mipWidth = std::max(1, header_.width >> mipmap);
+    uint16_t mipHeight = std::max(1, header_.height >> mipmap);
+    uint16_t mipDepth = std::max(1, GetDepth() >> mipmap);
+    offset += static_cast<uint64_t>(frame) * faces * mipDepth * ComputeImageSize(mipWidth, mipHeight, format);
+    
+    return static_cast<size_t>(offset);
+}
+
+uint32_t VTFFile::ComputeFullMipmapCount(uint16_t width, uint16_t height, uint16_t depth) {
+    uint32_t side = std::max({ width, height, depth });
+    uint32_t count = 1;
+    while (side > 1) {
+        side >>= 1;
+        count++;
+    }
+    return count;
+}
+
+bool VTFFile::LocateResource(const uint8_t* data, size_t size, uint32_t tag, uint64_t& value) {
+    if (size < VTF_RESOURCE_DICTIONARY_OFFSET) {
+        return false;
+    }
+    uint32_t count;
+    memcpy(&count, data + VTF_RESOURCE_COUNT_OFFSET, sizeof(count));
+    if (count > (size - VTF_RESOURCE_DICTIONARY_OFFSET) / sizeof(VTFResourceEntry)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        VTFResourceEntry entry;
+        memcpy(&entry, data + VTF_RESOURCE_DICTIONARY_OFFSET + i * sizeof(VTFResourceEntry), sizeof(entry));
+        if (GetResourceTag(entry) == tag) {
+            value = entry.data;
+            return true;
         }
     }
-    
-    // Add offsets for previous mipmaps in current frame
-    // VTF stores mipmaps from smallest to largest
-    for (uint32_t m = header_.mipmapCount - 1; m > mipmap; --m) {
-        uint16_t mipWidth = std::max(1, header_.width >> m);
-        uint16_t mipHeight = std::max(1, header_.height >> m);
-        offset += ComputeImageSize(mipWidth, mipHeight, format);
+    return false;
+}
+
+namespace {
+
+// Exact round(value * alpha / 255)
+inline uint8_t Premultiply(uint32_t value, uint32_t alpha) {
+    uint32_t x = value * alpha + 128;
+    return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+}
+
+inline void StorePixel(uint8_t* dst, uint8_t r, uint8_t g, uint8_t b, uint8_t a, VTFPixelLayout layout) {
+    if (layout == PIXEL_LAYOUT_RGBA8888) {
+        dst[0] = r;
+        dst[1] = g;
+        dst[2] = b;
+        dst[3] = a;
+    } else {
+        dst[0] = Premultiply(b, a);
+        dst[1] = Premultiply(g, a);
+        dst[2] = Premultiply(r, a);
+        dst[3] = a;
     }
-    
-    return offset;
 }
 
-void VTFFile::DecompressDXT1(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height) {
+} // namespace
+
+void VTFFile::DecompressDXT1(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height,
+                             VTFPixelLayout layout) const {
     uint32_t blockCountX = (width + 3) / 4;
     uint32_t blockCountY = (height + 3) / 4;
     
     for (uint32_t by = 0; by < blockCountY; ++by) {
         for (uint32_t bx = 0; bx < blockCountX; ++bx) {
-            const uint8_t* block = src + (by * blockCountX + bx) * 8;
+            const uint8_t* block = src + (static_cast<size_t>(by) * blockCountX + bx) * 8;
             
             // Read color endpoints
             uint16_t c0 = block[0] | (block[1] << 8);
@@ -150,6 +274,13 @@ void VTFFile::DecompressDXT1(const uint8_t* src, uint8_t* dst, uint16_t width, u
                 colors[3][3] = 0; // Transparent
             }
             
+            // Convert the palette to the output layout once so the pixel loop is a plain copy
+            if (layout != PIXEL_LAYOUT_RGBA8888) {
+                for (auto& color : colors) {
+                    StorePixel(color, color[0], color[1], color[2], color[3], layout);
+                }
+            }
+            
             // Decode pixels
             uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (block[7] << 24);
             
@@ -160,7 +291,7 @@ void VTFFile::DecompressDXT1(const uint8_t* src, uint8_t* dst, uint16_t width, u
                     
                     if (x < width && y < height) {
                         uint32_t index = (indices >> ((py * 4 + px) * 2)) & 0x3;
-                        uint32_t dstOffset = (y * width + x) * 4;
+                        size_t dstOffset = (static_cast<size_t>(y) * width + x) * 4;
                         
                         dst[dstOffset + 0] = colors[index][0];
                         dst[dstOffset + 1] = colors[index][1];
@@ -173,13 +304,14 @@ void VTFFile::DecompressDXT1(const uint8_t* src, uint8_t* dst, uint16_t width, u
     }
 }
 
-void VTFFile::DecompressDXT5(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height) {
+void VTFFile::DecompressDXT5(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height,
+                             VTFPixelLayout layout) const {
     uint32_t blockCountX = (width + 3) / 4;
     uint32_t blockCountY = (height + 3) / 4;
     
     for (uint32_t by = 0; by < blockCountY; ++by) {
         for (uint32_t bx = 0; bx < blockCountX; ++bx) {
-            const uint8_t* block = src + (by * blockCountX + bx) * 16;
+            const uint8_t* block = src + (static_cast<size_t>(by) * blockCountX + bx) * 16;
             
             // Alpha block
             uint8_t a0 = block[0];
@@ -242,96 +374,383 @@ void VTFFile::DecompressDXT5(const uint8_t* src, uint8_t* dst, uint16_t width, u
                         uint32_t pixelIndex = py * 4 + px;
                         uint32_t colorIndex = (colorIndices >> (pixelIndex * 2)) & 0x3;
                         uint32_t alphaIndex = (alphaBits >> (pixelIndex * 3)) & 0x7;
-                        uint32_t dstOffset = (y * width + x) * 4;
+                        size_t dstOffset = (static_cast<size_t>(y) * width + x) * 4;
                         
-                        dst[dstOffset + 0] = colors[colorIndex][0];
-                        dst[dstOffset + 1] = colors[colorIndex][1];
-                        dst[dstOffset + 2] = colors[colorIndex][2];
-                        dst[dstOffset + 3] = alphas[alphaIndex];
+                        StorePixel(dst + dstOffset, colors[colorIndex][0], colors[colorIndex][1],
+                                   colors[colorIndex][2], alphas[alphaIndex], layout);
+                    }
+                }
+            }
+        }
+    }
+}
+
+namespace {
+
+inline uint32_t PopCount32(uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_popcount(v));
+#else
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#endif
+}
+
+// Adds the sum of all 16 texels of a DXT colour block to sum[0..3].
+// The palette is weighted by how often each 2-bit index occurs, so no texel is decoded.
+void AccumulateColorBlock(const uint8_t* block, bool dxt1, uint32_t sum[4]) {
+    uint16_t c0 = block[0] | (block[1] << 8);
+    uint16_t c1 = block[2] | (block[3] << 8);
+    
+    uint32_t r0 = ((c0 >> 11) & 0x1F) << 3;
+    uint32_t g0 = ((c0 >> 5) & 0x3F) << 2;
+    uint32_t b0 = (c0 & 0x1F) << 3;
+    
+    uint32_t r1 = ((c1 >> 11) & 0x1F) << 3;
+    uint32_t g1 = ((c1 >> 5) & 0x3F) << 2;
+    uint32_t b1 = (c1 & 0x1F) << 3;
+    
+    // Count index occurrences: bit 0 and bit 1 of every 2-bit index
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+    uint32_t lo = indices & 0x55555555;
+    uint32_t hi = (indices >> 1) & 0x55555555;
+    uint32_t n1 = PopCount32(lo & ~hi);
+    uint32_t n2 = PopCount32(hi & ~lo);
+    uint32_t n3 = PopCount32(lo & hi);
+    uint32_t n0 = 16 - n1 - n2 - n3;
+    
+    if (!dxt1 || c0 > c1) {
+        // Four-colour mode: colours 2 and 3 are 1/3 and 2/3 of the way between the endpoints
+        uint32_t r2 = (2 * r0 + r1) / 3, g2 = (2 * g0 + g1) / 3, b2 = (2 * b0 + b1) / 3;
+        uint32_t r3 = (r0 + 2 * r1) / 3, g3 = (g0 + 2 * g1) / 3, b3 = (b0 + 2 * b1) / 3;
+        sum[0] += n0 * r0 + n1 * r1 + n2 * r2 + n3 * r3;
+        sum[1] += n0 * g0 + n1 * g1 + n2 * g2 + n3 * g3;
+        sum[2] += n0 * b0 + n1 * b1 + n2 * b2 + n3 * b3;
+        sum[3] += 16 * 255;
+    } else {
+        // Three-colour mode: colour 3 is transparent black
+        uint32_t r2 = (r0 + r1) / 2, g2 = (g0 + g1) / 2, b2 = (b0 + b1) / 2;
+        sum[0] += n0 * r0 + n1 * r1 + n2 * r2;
+        sum[1] += n0 * g0 + n1 * g1 + n2 * g2;
+        sum[2] += n0 * b0 + n1 * b1 + n2 * b2;
+        sum[3] += (16 - n3) * 255;
+    }
+}
+
+// Decodes the 16 alpha values of a DXT5 alpha block
+void DecodeAlphaBlock(const uint8_t* block, uint32_t alphas[16]) {
+    uint32_t a0 = block[0];
+    uint32_t a1 = block[1];
+    uint64_t alphaBits = 0;
+    for (int i = 0; i < 6; ++i) {
+        alphaBits |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+    }
+    
+    uint32_t palette[8];
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int i = 2; i < 8; ++i) {
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+    } else {
+        for (int i = 2; i < 6; ++i) {
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    
+    for (uint32_t i = 0; i < 16; ++i) {
+        alphas[i] = palette[(alphaBits >> (i * 3)) & 0x7];
+    }
+}
+
+// Adds the alpha-weighted colour (sum of colour * alpha) of a DXT5 block to sum[0..2]
+// and its alpha to sum[3]. Colour and alpha indices vary together, so unlike
+// AccumulateColorBlock this walks the texels, but still writes none of them.
+void AccumulatePremultipliedBlock(const uint8_t* block, uint32_t sum[4]) {
+    uint32_t alphas[16];
+    DecodeAlphaBlock(block, alphas);
+    
+    const uint8_t* colorBlock = block + 8;
+    uint16_t c0 = colorBlock[0] | (colorBlock[1] << 8);
+    uint16_t c1 = colorBlock[2] | (colorBlock[3] << 8);
+    uint32_t colors[4][3];
+    colors[0][0] = ((c0 >> 11) & 0x1F) << 3;
+    colors[0][1] = ((c0 >> 5) & 0x3F) << 2;
+    colors[0][2] = (c0 & 0x1F) << 3;
+    colors[1][0] = ((c1 >> 11) & 0x1F) << 3;
+    colors[1][1] = ((c1 >> 5) & 0x3F) << 2;
+    colors[1][2] = (c1 & 0x1F) << 3;
+    for (int c = 0; c < 3; ++c) {
+        colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+        colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+    }
+    
+    uint32_t indices = colorBlock[4] | (colorBlock[5] << 8) | (colorBlock[6] << 16) |
+                       (static_cast<uint32_t>(colorBlock[7]) << 24);
+    for (uint32_t i = 0; i < 16; ++i) {
+        const uint32_t* color = colors[(indices >> (i * 2)) & 0x3];
+        uint32_t alpha = alphas[i];
+        sum[0] += color[0] * alpha;
+        sum[1] += color[1] * alpha;
+        sum[2] += color[2] * alpha;
+        sum[3] += alpha;
+    }
+}
+
+} // namespace
+
+void VTFFile::ReduceDXT(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height,
+                        uint32_t reduction, VTFImageFormat format, VTFPixelLayout layout) const {
+    bool dxt1 = (format == IMAGE_FORMAT_DXT1 || format == IMAGE_FORMAT_DXT1_ONEBITALPHA);
+    uint32_t blockSize = dxt1 ? 8 : 16;
+    uint32_t blockCountX = (width + 3) / 4;
+    uint32_t blockCountY = (height + 3) / 4;
+    
+    // Each output pixel covers cell x cell blocks (1/4 -> 1, 1/8 -> 2, 1/16 -> 4)
+    uint32_t cell = 1u << (reduction - 2);
+    uint32_t outWidth = (blockCountX + cell - 1) / cell;
+    uint32_t outHeight = (blockCountY + cell - 1) / cell;
+    
+    for (uint32_t oy = 0; oy < outHeight; ++oy) {
+        for (uint32_t ox = 0; ox < outWidth; ++ox) {
+            // Colour is summed premultiplied (colour * alpha) so transparent texels, such
+            // as DXT1's black index 3, don't darken their neighbours
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            uint32_t texels = 0;
+            
+            uint32_t byEnd = std::min(blockCountY, (oy + 1) * cell);
+            uint32_t bxEnd = std::min(blockCountX, (ox + 1) * cell);
+            for (uint32_t by = oy * cell; by < byEnd; ++by) {
+                for (uint32_t bx = ox * cell; bx < bxEnd; ++bx) {
+                    const uint8_t* block = src + (static_cast<size_t>(by) * blockCountX + bx) * blockSize;
+                    
+                    if (dxt1) {
+                        // Alpha is 0 or 255, so the sum of the opaque texels is already
+                        // premultiplied; scale it to colour * alpha
+                        uint32_t colorSum[4] = { 0, 0, 0, 0 };
+                        AccumulateColorBlock(block, true, colorSum);
+                        sum[0] += colorSum[0] * 255;
+                        sum[1] += colorSum[1] * 255;
+                        sum[2] += colorSum[2] * 255;
+                        sum[3] += colorSum[3];
+                    } else {
+                        // DXT3/5: alpha block followed by a four-colour block; DXT3 is read
+                        // as DXT5, as the full decode does
+                        AccumulatePremultipliedBlock(block, sum);
                     }
+                    texels += 16;
+                }
+            }
+            
+            uint8_t* pixel = dst + (oy * outWidth + ox) * 4;
+            uint8_t alpha = static_cast<uint8_t>((sum[3] + texels / 2) / texels);
+            uint8_t color[3];
+            for (int c = 0; c < 3; ++c) {
+                if (layout == PIXEL_LAYOUT_RGBA8888) {
+                    // Straight colour: the alpha-weighted mean, sum(colour * alpha) / sum(alpha)
+                    color[c] = sum[3] ? static_cast<uint8_t>(std::min<uint32_t>(255, (sum[c] + sum[3] / 2) / sum[3])) : 0;
+                } else {
+                    uint32_t scale = texels * 255;
+                    color[c] = static_cast<uint8_t>((sum[c] + scale / 2) / scale);
                 }
             }
+            if (layout == PIXEL_LAYOUT_RGBA8888) {
+                pixel[0] = color[0];
+                pixel[1] = color[1];
+                pixel[2] = color[2];
+            } else {
+                pixel[0] = color[2];
+                pixel[1] = color[1];
+                pixel[2] = color[0];
+            }
+            pixel[3] = alpha;
         }
     }
 }
 
 void VTFFile::ConvertToRGBA8888(const uint8_t* src, uint8_t* dst, 
-                                uint16_t width, uint16_t height, VTFImageFormat format) {
-    uint32_t pixelCount = width * height;
+                                uint16_t width, uint16_t height, VTFImageFormat format,
+                                VTFPixelLayout layout) const {
+    size_t pixelCount = static_cast<size_t>(width) * height;
     
     switch (format) {
         case IMAGE_FORMAT_RGBA8888:
-            memcpy(dst, src, pixelCount * 4);
+            if (layout == PIXEL_LAYOUT_RGBA8888) {
+                memcpy(dst, src, pixelCount * 4);
+                break;
+            }
+            for (size_t i = 0; i < pixelCount; ++i) {
+                StorePixel(dst + i * 4, src[i * 4 + 0], src[i * 4 + 1], src[i * 4 + 2], src[i * 4 + 3], layout);
+            }
             break;
             
         case IMAGE_FORMAT_BGRA8888:
-            for (uint32_t i = 0; i < pixelCount; ++i) {
-                dst[i * 4 + 0] = src[i * 4 + 2]; // R
-                dst[i * 4 + 1] = src[i * 4 + 1]; // G
-                dst[i * 4 + 2] = src[i * 4 + 0]; // B
-                dst[i * 4 + 3] = src[i * 4 + 3]; // A
+            for (size_t i = 0; i < pixelCount; ++i) {
+                StorePixel(dst + i * 4, src[i * 4 + 2], src[i * 4 + 1], src[i * 4 + 0], src[i * 4 + 3], layout);
             }
             break;
             
         case IMAGE_FORMAT_RGB888:
-            for (uint32_t i = 0; i < pixelCount; ++i) {
-                dst[i * 4 + 0] = src[i * 3 + 0];
-                dst[i * 4 + 1] = src[i * 3 + 1];
-                dst[i * 4 + 2] = src[i * 3 + 2];
-                dst[i * 4 + 3] = 255;
+            for (size_t i = 0; i < pixelCount; ++i) {
+                StorePixel(dst + i * 4, src[i * 3 + 0], src[i * 3 + 1], src[i * 3 + 2], 255, layout);
             }
             break;
             
         case IMAGE_FORMAT_BGR888:
-            for (uint32_t i = 0; i < pixelCount; ++i) {
-                dst[i * 4 + 0] = src[i * 3 + 2];
-                dst[i * 4 + 1] = src[i * 3 + 1];
-                dst[i * 4 + 2] = src[i * 3 + 0];
-                dst[i * 4 + 3] = 255;
+            for (size_t i = 0; i < pixelCount; ++i) {
+                StorePixel(dst + i * 4, src[i * 3 + 2], src[i * 3 + 1], src[i * 3 + 0], 255, layout);
             }
             break;
             
         default:
             // For unsupported formats, fill with magenta
-            for (uint32_t i = 0; i < pixelCount; ++i) {
-                dst[i * 4 + 0] = 255;
-                dst[i * 4 + 1] = 0;
-                dst[i * 4 + 2] = 255;
-                dst[i * 4 + 3] = 255;
+            for (size_t i = 0; i < pixelCount; ++i) {
+                StorePixel(dst + i * 4, 255, 0, 255, 255, layout);
             }
             break;
     }
 }
 
-bool VTFFile::GetImageData(uint8_t* buffer, uint32_t frame, uint32_t mipmap) {
+bool VTFFile::GetImageData(uint8_t* buffer, uint32_t frame, uint32_t mipmap, VTFPixelLayout layout,
+                           const std::atomic<bool>* cancel) const {
     if (!loaded_ || frame >= header_.frames || mipmap >= header_.mipmapCount) {
         return false;
     }
     
     uint16_t mipWidth = std::max(1, header_.width >> mipmap);
     uint16_t mipHeight = std::max(1, header_.height >> mipmap);
-    uint32_t offset = ComputeMipmapOffset(frame, mipmap);
+    size_t offset = ComputeMipmapOffset(frame, mipmap);
     
     VTFImageFormat format = static_cast<VTFImageFormat>(header_.highResImageFormat);
-    const uint8_t* srcData = imageData_.data() + offset;
+    const uint8_t* srcData = imageData_ + offset;
     
-    // Decompress or convert based on format
-    if (format == IMAGE_FORMAT_DXT1 || format == IMAGE_FORMAT_DXT1_ONEBITALPHA) {
-        DecompressDXT1(srcData, buffer, mipWidth, mipHeight);
-    } else if (format == IMAGE_FORMAT_DXT5) {
-        DecompressDXT5(srcData, buffer, mipWidth, mipHeight);
-    } else if (format == IMAGE_FORMAT_DXT3) {
-        // DXT3 is similar to DXT5 but with different alpha encoding
-        // For simplicity, treat as DXT5
-        DecompressDXT5(srcData, buffer, mipWidth, mipHeight);
+    bool dxt = (format == IMAGE_FORMAT_DXT1 || format == IMAGE_FORMAT_DXT1_ONEBITALPHA ||
+                format == IMAGE_FORMAT_DXT3 || format == IMAGE_FORMAT_DXT5);
+    
+    // Byte stride of one band of 4 pixel rows (one block row for DXT formats)
+    size_t srcBandSize = dxt ? static_cast<size_t>(ComputeImageSize(mipWidth, 4, format))
+                             : static_cast<size_t>(mipWidth) * 4 * GetImageFormatBPP(format) / 8;
+    size_t dstBandSize = static_cast<size_t>(mipWidth) * 4 * 4;
+    
+    // Decode pixel rows [4 * bandBegin, 4 * bandEnd)
+    auto decodeBands = [&](uint32_t bandBegin, uint32_t bandEnd) {
+        const uint8_t* src = srcData + bandBegin * srcBandSize;
+        uint8_t* dst = buffer + bandBegin * dstBandSize;
+        uint16_t rows = static_cast<uint16_t>(std::min<uint32_t>(mipHeight, bandEnd * 4) - bandBegin * 4);
+        
+        // Decompress or convert based on format
+        if (format == IMAGE_FORMAT_DXT1 || format == IMAGE_FORMAT_DXT1_ONEBITALPHA) {
+            DecompressDXT1(src, dst, mipWidth, rows, layout);
+        } else if (format == IMAGE_FORMAT_DXT5) {
+            DecompressDXT5(src, dst, mipWidth, rows, layout);
+        } else if (format == IMAGE_FORMAT_DXT3) {
+            // DXT3 is similar to DXT5 but with different alpha encoding
+            // For simplicity, treat as DXT5
+            DecompressDXT5(src, dst, mipWidth, rows, layout);
+        } else {
+            ConvertToRGBA8888(src, dst, mipWidth, rows, format, layout);
+        }
+    };
+    
+    // Without a cancel flag there's nothing to check between bands
+    auto isCancelled = [cancel]() {
+        return cancel && cancel->load(std::memory_order_relaxed);
+    };
+    auto decodeChecked = [&](uint32_t bandBegin, uint32_t bandEnd) {
+        for (uint32_t band = bandBegin; band < bandEnd && !isCancelled(); band += CANCEL_CHECK_BANDS) {
+            decodeBands(band, std::min(bandEnd, band + CANCEL_CHECK_BANDS));
+        }
+    };
+    
+    uint32_t bandCount = (mipHeight + 3) / 4;
+    ThreadPool& pool = ThreadPool::Shared();
+    
+    // Small mips aren't worth the hand-off; large ones are split into a few bands per thread
+    if (static_cast<uint32_t>(mipWidth) * mipHeight < PARALLEL_DECODE_MIN_PIXELS || pool.GetThreadCount() == 0) {
+        decodeChecked(0, bandCount);
     } else {
-        ConvertToRGBA8888(srcData, buffer, mipWidth, mipHeight, format);
+        uint32_t grain = std::max(1u, bandCount / ((pool.GetThreadCount() + 1) * 4));
+        pool.ParallelFor(bandCount, grain, decodeChecked);
+    }
+    
+    return !isCancelled();
+}
+
+void VTFFile::GetReducedSize(uint32_t reduction, uint32_t mipmap, uint16_t& width, uint16_t& height) const {
+    uint32_t mipWidth = std::max(1, header_.width >> mipmap);
+    uint32_t mipHeight = std::max(1, header_.height >> mipmap);
+    uint32_t step = 1u << reduction;
+    width = static_cast<uint16_t>((mipWidth + step - 1) / step);
+    height = static_cast<uint16_t>((mipHeight + step - 1) / step);
+}
+
+bool VTFFile::GetImageDataReduced(uint8_t* buffer, uint32_t reduction, uint32_t frame, uint32_t mipmap,
+                                  VTFPixelLayout layout) const {
+    if (!loaded_ || frame >= header_.frames || mipmap >= header_.mipmapCount) {
+        return false;
+    }
+    if (reduction < 2 || reduction > 4) {
+        return false;
+    }
+    
+    uint16_t mipWidth = std::max(1, header_.width >> mipmap);
+    uint16_t mipHeight = std::max(1, header_.height >> mipmap);
+    size_t offset = ComputeMipmapOffset(frame, mipmap);
+    
+    VTFImageFormat format = static_cast<VTFImageFormat>(header_.highResImageFormat);
+    const uint8_t* srcData = imageData_ + offset;
+    
+    if (format == IMAGE_FORMAT_DXT1 || format == IMAGE_FORMAT_DXT1_ONEBITALPHA ||
+        format == IMAGE_FORMAT_DXT3 || format == IMAGE_FORMAT_DXT5) {
+        ReduceDXT(srcData, buffer, mipWidth, mipHeight, reduction, format, layout);
+        return true;
+    }
+    
+    // Uncompressed formats: convert, then box-filter into the output
+    BufferPool& pool = BufferPool::Shared();
+    uint8_t* full = static_cast<uint8_t*>(pool.Acquire(static_cast<size_t>(mipWidth) * mipHeight * 4));
+    if (!full) {
+        return false;
+    }
+    ConvertToRGBA8888(srcData, full, mipWidth, mipHeight, format);
+    
+    uint16_t outWidth, outHeight;
+    GetReducedSize(reduction, mipmap, outWidth, outHeight);
+    uint32_t step = 1u << reduction;
+    
+    for (uint32_t oy = 0; oy < outHeight; ++oy) {
+        for (uint32_t ox = 0; ox < outWidth; ++ox) {
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            uint32_t yEnd = std::min<uint32_t>(mipHeight, (oy + 1) * step);
+            uint32_t xEnd = std::min<uint32_t>(mipWidth, (ox + 1) * step);
+            for (uint32_t y = oy * step; y < yEnd; ++y) {
+                const uint8_t* row = full + static_cast<size_t>(y) * mipWidth * 4;
+                for (uint32_t x = ox * step; x < xEnd; ++x) {
+                    sum[0] += row[x * 4 + 0];
+                    sum[1] += row[x * 4 + 1];
+                    sum[2] += row[x * 4 + 2];
+                    sum[3] += row[x * 4 + 3];
+                }
+            }
+            
+            uint32_t count = (yEnd - oy * step) * (xEnd - ox * step);
+            uint8_t rgba[4];
+            for (int c = 0; c < 4; ++c) {
+                rgba[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+            }
+            StorePixel(buffer + (oy * outWidth + ox) * 4, rgba[0], rgba[1], rgba[2], rgba[3], layout);
+        }
     }
     
+    pool.Release(full);
     return true;
 }
 
-uint32_t VTFFile::GetImageDataSize(uint32_t mipmap) const {
+size_t VTFFile::GetImageDataSize(uint32_t mipmap) const {
     if (mipmap >= header_.mipmapCount) {
         return 0;
     }
@@ -340,7 +759,7 @@ uint32_t VTFFile::GetImageDataSize(uint32_t mipmap) const {
     uint16_t mipHeight = std::max(1, header_.height >> mipmap);
     
     // Always return RGBA8888 size
-    return mipWidth * mipHeight * 4;
+    return static_cast<size_t>(mipWidth) * mipHeight * 4;
 }
 
 } // namespace VTFLib
@@ -4,10 +4,22 @@
 #include "VTFFormat.h"
 #include <string>
 #include <vector>
+#include <memory>
+#include <atomic>
 #include <cstdint>
 
 namespace VTFLib {
 
+// Mips with fewer pixels than this are decoded on the calling thread only
+const uint32_t PARALLEL_DECODE_MIN_PIXELS = 512 * 512;
+
+// Bands of 4 pixel rows decoded between checks of a cancel flag
+const uint32_t CANCEL_CHECK_BANDS = 16;
+
+// Thread safety: Load() must not race with any other call on the same object. Once
+// loaded, every const member is safe to call from any number of threads at once; the
+// decode functions only read the file and write to the caller's buffer. Open() hands
+// out the loaded file as a shared immutable object for that purpose.
 class VTFFile {
 public:
     VTFFile();
@@ -16,35 +28,83 @@ public:
     // Load VTF file from disk
     bool Load(const std::string& filename);
     
+    // Load a VTF from memory. With an owner the image data is used in place and the
+    // owner is kept alive for as long as this file; without one it is copied.
+    bool Load(const uint8_t* data, size_t size, std::shared_ptr<const void> owner = nullptr);
+    
+    // Load a VTF file into a new shareable, read-only object (nullptr on failure)
+    static std::shared_ptr<const VTFFile> Open(const std::string& filename);
+    static std::shared_ptr<const VTFFile> Open(const uint8_t* data, size_t size,
+                                               std::shared_ptr<const void> owner = nullptr);
+    
     // Get header information
     uint16_t GetWidth() const { return header_.width; }
     uint16_t GetHeight() const { return header_.height; }
-    uint16_t GetDepth() const { return header_.depth; }
+    uint16_t GetDepth() const { return header_.version[1] >= 2 ? header_.depth : 1; }  // depth arrived in 7.2
     uint16_t GetFrameCount() const { return header_.frames; }
     uint8_t GetMipmapCount() const { return header_.mipmapCount; }
     VTFImageFormat GetFormat() const { return static_cast<VTFImageFormat>(header_.highResImageFormat); }
     uint32_t GetFlags() const { return header_.flags; }
     
-    // Get image data (returns RGBA8888 format)
-    bool GetImageData(uint8_t* buffer, uint32_t frame = 0, uint32_t mipmap = 0);
+    // Get image data (RGBA8888 by default, or premultiplied BGRA for display).
+    // Setting *cancel stops the decode between bands and makes it return false.
+    bool GetImageData(uint8_t* buffer, uint32_t frame = 0, uint32_t mipmap = 0,
+                      VTFPixelLayout layout = PIXEL_LAYOUT_RGBA8888,
+                      const std::atomic<bool>* cancel = nullptr) const;
+    
+    // Get image data downscaled by 2^reduction (2 = 1/4, 3 = 1/8, 4 = 1/16).
+    // DXT blocks are averaged, premultiplied, straight from their palettes without a full decode.
+    bool GetImageDataReduced(uint8_t* buffer, uint32_t reduction, uint32_t frame = 0, uint32_t mipmap = 0,
+                             VTFPixelLayout layout = PIXEL_LAYOUT_RGBA8888) const;
+    
+    // Dimensions of the output written by GetImageDataReduced
+    void GetReducedSize(uint32_t reduction, uint32_t mipmap, uint16_t& width, uint16_t& height) const;
     
     // Get raw image data size for a specific mipmap level
-    uint32_t GetImageDataSize(uint32_t mipmap = 0) const;
+    size_t GetImageDataSize(uint32_t mipmap = 0) const;
+    
+    // Exact VRAM the texture takes: every frame, face, slice and mip of the high-res image
+    uint64_t GetVRAMSize() const;
+    
+    // Bytes of one image (a single frame, face and slice) of the given size and format
+    static uint64_t ComputeImageSize(uint16_t width, uint16_t height, VTFImageFormat format);
+    
+    // Bytes of a whole texture: every frame, face and depth slice of the first mipmapCount
+    // mips, with volume textures halving their depth per mip like width and height
+    static uint64_t ComputeTextureSize(uint16_t width, uint16_t height, uint16_t depth, uint16_t frames,
+                                       uint32_t faces, uint32_t mipmapCount, VTFImageFormat format);
+    
+    // Mips in a full chain down to 1x1x1
+    static uint32_t ComputeFullMipmapCount(uint16_t width, uint16_t height, uint16_t depth = 1);
+    
+    // Data field of the first 7.3+ resource with the given tag: its offset, or its value
+    // for resources without a data chunk (false if absent or the dictionary is truncated)
+    static bool LocateResource(const uint8_t* data, size_t size, uint32_t tag, uint64_t& value);
+    
+    // The high-res image data as stored: every frame and mipmap, still compressed
+    const uint8_t* GetRawImageData() const { return imageData_; }
+    size_t GetRawImageDataSize() const { return imageDataSize_; }
     
     // Check if file is loaded
     bool IsLoaded() const { return loaded_; }
     
 private:
     VTFHeader header_;
-    std::vector<uint8_t> imageData_;
+    const uint8_t* imageData_;               // high-res image data, inside dataOwner_
+    size_t imageDataSize_;
+    std::shared_ptr<const void> dataOwner_;  // file contents or a mapped archive
     bool loaded_;
     
     // Helper functions
-    uint32_t ComputeImageSize(uint16_t width, uint16_t height, VTFImageFormat format) const;
-    uint32_t ComputeMipmapOffset(uint32_t frame, uint32_t mipmap) const;
-    void DecompressDXT1(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height);
-    void DecompressDXT5(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height);
-    void ConvertToRGBA8888(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height, VTFImageFormat format);
+    size_t ComputeMipmapOffset(uint32_t frame, uint32_t mipmap) const;
+    void DecompressDXT1(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height,
+                        VTFPixelLayout layout) const;
+    void DecompressDXT5(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height,
+                        VTFPixelLayout layout) const;
+    void ReduceDXT(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height,
+                   uint32_t reduction, VTFImageFormat format, VTFPixelLayout layout) const;
+    void ConvertToRGBA8888(const uint8_t* src, uint8_t* dst, uint16_t width, uint16_t height,
+                           VTFImageFormat format, VTFPixelLayout layout = PIXEL_LAYOUT_RGBA8888) const;
 };
 
 } // namespace VTFLib
@@ -43,6 +43,13 @@ enum VTFImageFormat {
     IMAGE_FORMAT_UVLX8888
 };
 
+// Pixel layouts the decoder can write
+enum VTFPixelLayout {
+    PIXEL_LAYOUT_RGBA8888,                  // R, G, B, A bytes with straight alpha (export)
+    PIXEL_LAYOUT_BGRA8888_PREMULTIPLIED     // B, G, R, A bytes with premultiplied alpha; this is
+                                            // QImage::Format_ARGB32_Premultiplied on little-endian hosts
+};
+
 // VTF Flags
 enum VTFFlags {
     TEXTUREFLAGS_POINTSAMPLE = 0x00000001,
@@ -96,8 +103,33 @@ struct VTFHeader {
     uint16_t depth;
 };
 
+// Version 7.3+ headers end in a resource count and a dictionary of resource entries
+const uint32_t VTF_RESOURCE_COUNT_OFFSET = 68;
+const uint32_t VTF_RESOURCE_DICTIONARY_OFFSET = 80;
+
+struct VTFResourceEntry {
+    uint8_t tag[3];
+    uint8_t flags;
+    uint32_t data;  // offset of the resource in the file, or its value with RESOURCE_FLAG_NO_DATA_CHUNK
+};
+
 #pragma pack(pop)
 
+const uint8_t RESOURCE_FLAG_NO_DATA_CHUNK = 0x02;
+
+// Resource tags, the three tag bytes read little-endian
+const uint32_t RESOURCE_LOW_RES_IMAGE = 0x000001;
+const uint32_t RESOURCE_HIGH_RES_IMAGE = 0x000030;
+const uint32_t RESOURCE_SHEET = 0x000010;
+const uint32_t RESOURCE_CRC = 'C' | ('R' << 8) | ('C' << 16);
+const uint32_t RESOURCE_LOD = 'L' | ('O' << 8) | ('D' << 16);
+const uint32_t RESOURCE_TEXTURE_SETTINGS = 'T' | ('S' << 8) | ('O' << 16);
+const uint32_t RESOURCE_KEY_VALUES = 'K' | ('V' << 8) | ('D' << 16);
+
+inline uint32_t GetResourceTag(const VTFResourceEntry& entry) {
+    return entry.tag[0] | (entry.tag[1] << 8) | (entry.tag[2] << 16);
+}
+
 // Helper functions
 inline int GetImageFormatBPP(VTFImageFormat format) {
     switch (format) {
@@ -140,6 +172,21 @@ inline int GetImageFormatBPP(VTFImageFormat format) {
     }
 }
 
+// Cube faces a texture with these flags holds. Pre-7.5 envmaps may also store a spheremap
+// face, but the engine never uploads it.
+inline uint32_t GetFaceCount(uint32_t flags) {
+    return (flags & TEXTUREFLAGS_ENVMAP) ? 6 : 1;
+}
+
+// Faces stored per frame and mip. Envmaps before 7.5 carry a spheremap after the six cube
+// faces unless firstFrame is 0xFFFF.
+inline uint32_t GetStoredFaceCount(const VTFHeader& header) {
+    if (!(header.flags & TEXTUREFLAGS_ENVMAP)) {
+        return 1;
+    }
+    return header.version[1] < 5 && header.firstFrame != 0xFFFF ? 7 : 6;
+}
+
 inline const char* GetImageFormatName(VTFImageFormat format) {
     switch (format) {
         case IMAGE_FORMAT_RGBA8888: return "RGBA8888";
@@ -0,0 +1,322 @@
+#include "VTFValidator.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "VPKFile.h"
+#include "VTFFile.h"
+#include "ZipFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+namespace VTFLib {
+
+namespace {
+
+// Header size each minor version writes; 7.2 pads its extra depth field out to 80 bytes
+uint32_t MinimumHeaderSize(uint32_t minorVersion) {
+    return minorVersion >= 2 ? VTF_RESOURCE_DICTIONARY_OFFSET : 64;
+}
+
+// Printable tags as text ("KVD"), the image resources by name
+std::string TagName(uint32_t tag) {
+    if (tag == RESOURCE_HIGH_RES_IMAGE) {
+        return "high-res image";
+    } else if (tag == RESOURCE_LOW_RES_IMAGE) {
+        return "low-res image";
+    } else if (tag == RESOURCE_SHEET) {
+        return "sheet";
+    }
+    char name[16];
+    unsigned char c0 = tag & 0xFF, c1 = (tag >> 8) & 0xFF, c2 = (tag >> 16) & 0xFF;
+    if (isprint(c0) && isprint(c1) && isprint(c2)) {
+        snprintf(name, sizeof(name), "'%c%c%c'", c0, c1, c2);
+    } else {
+        snprintf(name, sizeof(name), "0x%06X", static_cast<unsigned>(tag));
+    }
+    return name;
+}
+
+std::string Bytes(uint64_t count) {
+    return std::to_string(count) + (count == 1 ? " byte" : " bytes");
+}
+
+void AddIssue(std::vector<ValidationIssue>& issues, ValidationSeverity severity, std::string message) {
+    issues.push_back({ severity, std::move(message) });
+}
+
+// Resources of a 7.3+ file: each inside the file, the high-res image big enough for the
+// header's shape. Returns the end of the last resource.
+uint64_t ValidateResources(const uint8_t* data, size_t size, const VTFHeader& header, uint64_t payloadSize,
+                           uint64_t lowResSize, std::vector<ValidationIssue>& issues) {
+    uint32_t count;
+    memcpy(&count, data + VTF_RESOURCE_COUNT_OFFSET, sizeof(count));
+    uint64_t dictionaryEnd = VTF_RESOURCE_DICTIONARY_OFFSET + static_cast<uint64_t>(count) * sizeof(VTFResourceEntry);
+    if (dictionaryEnd > size) {
+        AddIssue(issues, VALIDATION_ERROR, "the dictionary of " + std::to_string(count) + " resources runs past the end of the file");
+        return size;
+    }
+    if (dictionaryEnd > header.headerSize) {
+        AddIssue(issues, VALIDATION_ERROR, "the dictionary of " + std::to_string(count) + " resources doesn't fit the " +
+                 Bytes(header.headerSize) + " header");
+    }
+    
+    std::set<uint32_t> seen;
+    uint64_t end = dictionaryEnd;
+    bool highRes = false;
+    for (uint32_t i = 0; i < count; ++i) {
+        VTFResourceEntry entry;
+        memcpy(&entry, data + VTF_RESOURCE_DICTIONARY_OFFSET + i * sizeof(VTFResourceEntry), sizeof(entry));
+        uint32_t tag = GetResourceTag(entry);
+        std::string name = TagName(tag);
+        if (!seen.insert(tag).second) {
+            AddIssue(issues, VALIDATION_WARNING, "duplicate " + name + " resource; only the first is used");
+            continue;
+        }
+        if (entry.flags & RESOURCE_FLAG_NO_DATA_CHUNK) {
+            continue;  // the value is the resource (CRC, LOD, TSO)
+        }
+        
+        // The images have a size known from the header; other chunks start with their length
+        uint64_t offset = entry.data;
+        uint64_t length;
+        if (tag == RESOURCE_HIGH_RES_IMAGE) {
+            highRes = true;
+            length = payloadSize;
+        } else if (tag == RESOURCE_LOW_RES_IMAGE) {
+            length = lowResSize;
+        } else if (offset + sizeof(uint32_t) <= size) {
+            uint32_t chunkSize;
+            memcpy(&chunkSize, data + offset, sizeof(chunkSize));
+            length = sizeof(uint32_t) + static_cast<uint64_t>(chunkSize);
+        } else {
+            AddIssue(issues, VALIDATION_ERROR, name + " resource at offset " + std::to_string(offset) + " is past the end of the file");
+            continue;
+        }
+        
+        if (offset < dictionaryEnd) {
+            AddIssue(issues, VALIDATION_ERROR, name + " resource at offset " + std::to_string(offset) + " overlaps the header");
+        } else if (offset + length > size) {
+            AddIssue(issues, VALIDATION_ERROR, "truncated: " + name + " resource needs " + Bytes(length) + " at offset " +
+                     std::to_string(offset) + ", the file has " + Bytes(offset < size ? size - offset : 0) + " left");
+        }
+        end = std::max(end, offset + length);
+    }
+    
+    if (!highRes) {
+        AddIssue(issues, VALIDATION_ERROR, "no high-res image resource");
+    }
+    return end;
+}
+
+template <typename Archive, typename Entry>
+ValidationReport ValidateEntry(const Archive& archive, const Entry& entry, bool checkCRC) {
+    ValidationReport report;
+    const char* path = archive.GetEntryPath(entry);
+    report.path = archive.GetFilename() + "/" + path;
+    
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> owner;
+    if (!archive.GetEntryData(entry, data, size, owner)) {
+        AddIssue(report.issues, VALIDATION_ERROR, "entry data can't be read (missing or truncated archive)");
+        return report;
+    }
+    
+    if (checkCRC) {
+        uint32_t crc = CRC32(data, size);
+        if (crc != entry.crc) {
+            char message[96];
+            snprintf(message, sizeof(message), "CRC-32 is %08X, the archive directory records %08X",
+                     static_cast<unsigned>(crc), static_cast<unsigned>(entry.crc));
+            AddIssue(report.issues, VALIDATION_ERROR, message);
+        }
+    }
+    
+    size_t length = strlen(path);
+    if (length >= 4 && strcmp(path + length - 4, ".vtf") == 0) {
+        std::vector<ValidationIssue> issues = VTFValidator::Validate(data, size);
+        report.issues.insert(report.issues.end(), issues.begin(), issues.end());
+    }
+    return report;
+}
+
+// Keep the reports that found something, in order
+std::vector<ValidationReport> WithIssues(std::vector<ValidationReport>& reports) {
+    std::vector<ValidationReport> found;
+    for (ValidationReport& report : reports) {
+        if (!report.issues.empty()) {
+            found.push_back(std::move(report));
+        }
+    }
+    return found;
+}
+
+} // namespace
+
+bool ValidationReport::HasErrors() const {
+    return std::any_of(issues.begin(), issues.end(),
+                       [](const ValidationIssue& issue) { return issue.severity == VALIDATION_ERROR; });
+}
+
+std::vector<ValidationIssue> VTFValidator::Validate(const uint8_t* data, size_t size) {
+    std::vector<ValidationIssue> issues;
+    if (size < sizeof(VTFHeader)) {
+        AddIssue(issues, VALIDATION_ERROR, "the file is " + Bytes(size) + ", too short for a VTF header");
+        return issues;
+    }
+    
+    VTFHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.signature, VTF_SIGNATURE, 4) != 0) {
+        AddIssue(issues, VALIDATION_ERROR, "not a VTF (bad signature)");
+        return issues;
+    }
+    if (header.version[0] != 7 || header.version[1] > 5) {
+        AddIssue(issues, VALIDATION_ERROR, "unsupported version " + std::to_string(header.version[0]) + "." +
+                 std::to_string(header.version[1]));
+        return issues;
+    }
+    std::string version = "7." + std::to_string(header.version[1]);
+    
+    // Header fields; the rest can't be checked while these are wrong
+    uint32_t minimumHeaderSize = MinimumHeaderSize(header.version[1]);
+    if (header.headerSize < minimumHeaderSize) {
+        AddIssue(issues, VALIDATION_ERROR, "header size " + std::to_string(header.headerSize) + " is less than the " +
+                 Bytes(minimumHeaderSize) + " of a " + version + " header");
+    } else if (header.headerSize > size) {
+        AddIssue(issues, VALIDATION_ERROR, "header size " + std::to_string(header.headerSize) + " is past the end of the file");
+    }
+    if (header.width == 0 || header.height == 0) {
+        AddIssue(issues, VALIDATION_ERROR, "zero size (" + std::to_string(header.width) + " x " + std::to_string(header.height) + ")");
+    }
+    if (header.frames == 0) {
+        AddIssue(issues, VALIDATION_ERROR, "zero frames");
+    }
+    VTFImageFormat format = static_cast<VTFImageFormat>(header.highResImageFormat);
+    if (GetImageFormatBPP(format) == 0) {
+        AddIssue(issues, VALIDATION_ERROR, "unknown high-res format " + std::to_string(header.highResImageFormat));
+    }
+    VTFImageFormat lowResFormat = static_cast<VTFImageFormat>(header.lowResImageFormat);
+    if (lowResFormat != IMAGE_FORMAT_NONE && GetImageFormatBPP(lowResFormat) == 0) {
+        AddIssue(issues, VALIDATION_ERROR, "unknown low-res format " + std::to_string(header.lowResImageFormat));
+    }
+    if (!issues.empty()) {
+        return issues;
+    }
+    
+    uint16_t depth = header.version[1] >= 2 && header.depth > 1 ? header.depth : 1;
+    uint32_t fullMipmapCount = VTFFile::ComputeFullMipmapCount(header.width, header.height, depth);
+    if (header.mipmapCount == 0 || header.mipmapCount > fullMipmapCount) {
+        AddIssue(issues, VALIDATION_ERROR, std::to_string(header.mipmapCount) + " mipmaps, but a " + std::to_string(header.width) +
+                 " x " + std::to_string(header.height) + " texture has 1 to " + std::to_string(fullMipmapCount));
+        return issues;
+    }
+    if ((header.flags & TEXTUREFLAGS_ENVMAP) && header.width != header.height) {
+        AddIssue(issues, VALIDATION_ERROR, "cubemap faces aren't square (" + std::to_string(header.width) + " x " +
+                 std::to_string(header.height) + ")");
+    }
+    
+    // Payload length, against the resource dictionary from 7.3 and the fixed layout before
+    uint64_t payloadSize = VTFFile::ComputeTextureSize(header.width, header.height, depth, header.frames,
+                                                       GetStoredFaceCount(header), header.mipmapCount, format);
+    uint64_t lowResSize = lowResFormat == IMAGE_FORMAT_NONE ? 0 :
+        VTFFile::ComputeImageSize(header.lowResImageWidth, header.lowResImageHeight, lowResFormat);
+    uint64_t end;
+    if (header.version[1] >= 3) {
+        end = ValidateResources(data, size, header, payloadSize, lowResSize, issues);
+    } else {
+        uint64_t offset = header.headerSize + lowResSize;
+        end = offset + payloadSize;
+        if (end > size) {
+            AddIssue(issues, VALIDATION_ERROR, "truncated: the image data needs " + Bytes(payloadSize) + " at offset " +
+                     std::to_string(offset) + ", the file has " + Bytes(offset < size ? size - offset : 0) + " left");
+        }
+    }
+    if (end < size) {
+        AddIssue(issues, VALIDATION_WARNING, Bytes(size - end) + " of trailing data after the image");
+    }
+    return issues;
+}
+
+std::vector<ValidationReport> VTFValidator::ValidateFiles(const std::vector<std::string>& filenames,
+                                                          BatchProgress* progress) {
+    std::vector<ValidationReport> reports(filenames.size());
+    if (progress) {
+        progress->total += filenames.size();
+    }
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(filenames.size()), VALIDATION_GRAIN,
+        [&filenames, &reports, progress](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end && !(progress && progress->IsCancelled()); ++i) {
+                ValidationReport& report = reports[i];
+                report.path = filenames[i];
+                std::shared_ptr<const MappedFile> mapping = MappedFile::Map(filenames[i]);
+                if (!mapping) {
+                    AddIssue(report.issues, VALIDATION_ERROR, "can't be read, or is empty");
+                    continue;
+                }
+                report.issues = Validate(mapping->GetData(), mapping->GetSize());
+            }
+            if (progress) {
+                progress->done += end - begin;
+            }
+        });
+    return WithIssues(reports);
+}
+
+std::vector<ValidationReport> VTFValidator::ValidateVPK(const VPKFile& vpk, BatchProgress* progress) {
+    std::vector<ValidationReport> reports(vpk.GetEntryCount());
+    if (progress) {
+        progress->total += reports.size();
+    }
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(reports.size()), VALIDATION_GRAIN,
+        [&vpk, &reports, progress](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end && !(progress && progress->IsCancelled()); ++i) {
+                // Some packers leave the CRC zero rather than computing it
+                const VPKEntry& entry = vpk.GetEntry(i);
+                reports[i] = ValidateEntry(vpk, entry, entry.crc != 0);
+            }
+            if (progress) {
+                progress->done += end - begin;
+            }
+        });
+    return WithIssues(reports);
+}
+
+std::vector<ValidationReport> VTFValidator::ValidateZip(const ZipFile& zip, BatchProgress* progress) {
+    std::vector<ValidationReport> reports(zip.GetEntryCount());
+    if (progress) {
+        progress->total += reports.size();
+    }
+    ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(reports.size()), VALIDATION_GRAIN,
+        [&zip, &reports, progress](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end && !(progress && progress->IsCancelled()); ++i) {
+                reports[i] = ValidateEntry(zip, zip.GetEntry(i), true);
+            }
+            if (progress) {
+                progress->done += end - begin;
+            }
+        });
+    return WithIssues(reports);
+}
+
+std::vector<ValidationReport> VTFValidator::ValidateArchive(const std::string& filename, BatchProgress* progress) {
+    std::string extension = filename.size() >= 4 ? filename.substr(filename.size() - 4) : std::string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == ".vpk") {
+        if (std::shared_ptr<const VPKFile> vpk = VPKFile::Open(filename)) {
+            return ValidateVPK(*vpk, progress);
+        }
+    } else if (std::shared_ptr<const ZipFile> zip = ZipFile::Open(filename)) {
+        return ValidateZip(*zip, progress);
+    }
+    
+    ValidationReport report;
+    report.path = filename;
+    AddIssue(report.issues, VALIDATION_ERROR, "the archive directory can't be read");
+    return { report };
+}
+
+} // namespace VTFLib
@@ -0,0 +1,65 @@
+#ifndef VTFVALIDATOR_H
+#define VTFVALIDATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VTFLib {
+
+class VPKFile;
+class ZipFile;
+struct BatchProgress;
+
+// Files or archive entries checked per thread pool chunk
+const uint32_t VALIDATION_GRAIN = 16;
+
+enum ValidationSeverity {
+    VALIDATION_WARNING,  // loads, but not as its author meant (trailing bytes, duplicate resources)
+    VALIDATION_ERROR     // won't load, or would decode garbage
+};
+
+struct ValidationIssue {
+    ValidationSeverity severity;
+    std::string message;
+};
+
+// Everything wrong with one file or archive entry
+struct ValidationReport {
+    std::string path;  // on disk, or "<archive>/<entry>" like TextureSource's virtual paths
+    std::vector<ValidationIssue> issues;
+    
+    bool HasErrors() const;
+};
+
+// Structural checks of VTF files without decoding them: header size and fields, mip count
+// against the dimensions, payload length and, for 7.3+, that every resource lies inside
+// the file. Archive entries are also checked against the CRC-32 their directory records,
+// computed with the hardware CRC32. Files are memory-mapped and checked in parallel, so
+// a tree is validated at the speed its pages can be read.
+//
+// The CRC resource of a 7.3+ VTF holds the CRC of the image vtex compiled it from, which
+// the VTF doesn't contain, so it can't be verified and is left alone.
+class VTFValidator {
+public:
+    // Problems with one VTF in memory; empty when it is sound
+    static std::vector<ValidationIssue> Validate(const uint8_t* data, size_t size);
+    
+    // Files on disk. Reports only the files with issues, in input order. Progress counts
+    // files, or archive entries below.
+    static std::vector<ValidationReport> ValidateFiles(const std::vector<std::string>& filenames,
+                                                       BatchProgress* progress = nullptr);
+    
+    // Every entry of an archive against its CRC, and every VTF in it against the checks above
+    static std::vector<ValidationReport> ValidateVPK(const VPKFile& vpk, BatchProgress* progress = nullptr);
+    static std::vector<ValidationReport> ValidateZip(const ZipFile& zip, BatchProgress* progress = nullptr);
+    
+    // Open a .vpk, .zip or .bsp and validate it; a report for the archive itself if it won't open
+    static std::vector<ValidationReport> ValidateArchive(const std::string& filename,
+                                                         BatchProgress* progress = nullptr);
+};
+
+} // namespace VTFLib
+
+#endif // VTFVALIDATOR_H
@@ -0,0 +1,259 @@
+#include "ZipFile.h"
+#include "BufferPool.h"
+#include "Inflate.h"
+#include "MappedFile.h"
+#include "VTFFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace VTFLib {
+
+namespace {
+
+const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+const size_t ZIP_CENTRAL_HEADER_SIZE = 46;
+const size_t ZIP_END_OF_DIRECTORY_SIZE = 22;
+const size_t ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+const uint16_t ZIP_FLAG_ENCRYPTED = 0x0001;
+
+const char BSP_SIGNATURE[4] = { 'V', 'B', 'S', 'P' };
+const size_t BSP_LUMP_TABLE_OFFSET = 8;
+const size_t BSP_LUMP_SIZE = 16;
+const uint32_t BSP_LUMP_COUNT = 64;
+const size_t BSP_HEADER_SIZE = BSP_LUMP_TABLE_OFFSET + BSP_LUMP_COUNT * BSP_LUMP_SIZE + 4;
+const uint32_t BSP_VERSION_L4D2 = 21;
+
+inline uint16_t ReadU16(const uint8_t* p) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t ReadU32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline char NormalizePathChar(char c) {
+    if (c == '\\') {
+        return '/';
+    }
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+void ReleasePooled(const void* buffer) {
+    BufferPool::Shared().Release(const_cast<void*>(buffer));
+}
+
+} // namespace
+
+ZipFile::ZipFile() : zipData_(nullptr), zipSize_(0) {
+}
+
+ZipFile::~ZipFile() {
+}
+
+bool ZipFile::Load(const std::string& filename) {
+    entries_.clear();
+    pathPool_.clear();
+    
+    file_ = MappedFile::Map(filename);
+    if (!file_) {
+        return false;
+    }
+    
+    zipData_ = file_->GetData();
+    zipSize_ = file_->GetSize();
+    
+    // A map: the zip is the pakfile lump, with offsets relative to the lump
+    if (zipSize_ >= BSP_LUMP_TABLE_OFFSET + BSP_LUMP_COUNT * BSP_LUMP_SIZE &&
+        memcmp(zipData_, BSP_SIGNATURE, sizeof(BSP_SIGNATURE)) == 0) {
+        const uint8_t* lumps = zipData_ + BSP_LUMP_TABLE_OFFSET;
+        const uint8_t* lump = lumps + BSP_PAKFILE_LUMP * BSP_LUMP_SIZE;
+        
+        // Lumps are {offset, length, version, fourCC}, except that L4D2's v21 maps
+        // store {version, offset, length, fourCC}. CS:GO is also v21 with the usual
+        // order, so tell them apart by the entity lump: its data always follows the
+        // header, while a lump version is a small number.
+        size_t fieldOffset = 0;
+        if (ReadU32(zipData_ + 4) == BSP_VERSION_L4D2 && ReadU32(lumps) < BSP_HEADER_SIZE) {
+            fieldOffset = 4;
+        }
+        uint32_t lumpOffset = ReadU32(lump + fieldOffset);
+        uint32_t lumpSize = ReadU32(lump + fieldOffset + 4);
+        if (lumpOffset > zipSize_ || lumpSize > zipSize_ - lumpOffset) {
+            return false;
+        }
+        zipData_ += lumpOffset;
+        zipSize_ = lumpSize;
+    }
+    
+    if (!ParseCentralDirectory()) {
+        entries_.clear();
+        pathPool_.clear();
+        return false;
+    }
+    
+    const char* pool = pathPool_.data();
+    std::sort(entries_.begin(), entries_.end(), [pool](const ZipEntry& a, const ZipEntry& b) {
+        return strcmp(pool + a.pathOffset, pool + b.pathOffset) < 0;
+    });
+    
+    filename_ = filename;
+    return true;
+}
+
+std::shared_ptr<const ZipFile> ZipFile::Open(const std::string& filename) {
+    auto file = std::make_shared<ZipFile>();
+    if (!file->Load(filename)) {
+        return nullptr;
+    }
+    return file;
+}
+
+bool ZipFile::ParseCentralDirectory() {
+    if (zipSize_ < ZIP_END_OF_DIRECTORY_SIZE) {
+        return false;
+    }
+    
+    // The end record sits at the very end, before a comment of up to 64 KB
+    size_t searchEnd = zipSize_ - ZIP_END_OF_DIRECTORY_SIZE;
+    size_t searchBegin = searchEnd > ZIP_MAX_COMMENT_SIZE ? searchEnd - ZIP_MAX_COMMENT_SIZE : 0;
+    const uint8_t* end = nullptr;
+    for (size_t pos = searchEnd + 1; pos-- > searchBegin;) {
+        if (ReadU32(zipData_ + pos) == ZIP_END_OF_DIRECTORY_SIGNATURE) {
+            end = zipData_ + pos;
+            break;
+        }
+    }
+    if (!end) {
+        return false;
+    }
+    
+    uint16_t entryCount = ReadU16(end + 10);
+    uint32_t directorySize = ReadU32(end + 12);
+    uint32_t directoryOffset = ReadU32(end + 16);
+    if (directoryOffset > zipSize_ || directorySize > zipSize_ - directoryOffset) {
+        return false;
+    }
+    
+    const uint8_t* cursor = zipData_ + directoryOffset;
+    const uint8_t* directoryEnd = cursor + directorySize;
+    entries_.reserve(entryCount);
+    
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        if (static_cast<size_t>(directoryEnd - cursor) < ZIP_CENTRAL_HEADER_SIZE ||
+            ReadU32(cursor) != ZIP_CENTRAL_HEADER_SIGNATURE) {
+            return false;
+        }
+        
+        uint16_t flags = ReadU16(cursor + 8);
+        uint16_t nameLength = ReadU16(cursor + 28);
+        uint16_t extraLength = ReadU16(cursor + 30);
+        uint16_t commentLength = ReadU16(cursor + 32);
+        size_t recordSize = ZIP_CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        if (static_cast<size_t>(directoryEnd - cursor) < recordSize) {
+            return false;
+        }
+        
+        ZipEntry entry;
+        entry.method = ReadU16(cursor + 10);
+        entry.crc = ReadU32(cursor + 16);
+        entry.compressedSize = ReadU32(cursor + 20);
+        entry.uncompressedSize = ReadU32(cursor + 24);
+        entry.localHeaderOffset = ReadU32(cursor + 42);
+        const char* name = reinterpret_cast<const char*>(cursor + ZIP_CENTRAL_HEADER_SIZE);
+        cursor += recordSize;
+        
+        // Directories, encrypted entries and methods we can't decode (e.g. LZMA) are left out
+        bool directory = nameLength == 0 || name[nameLength - 1] == '/' || name[nameLength - 1] == '\\';
+        bool readable = entry.method == ZIP_METHOD_STORED || entry.method == ZIP_METHOD_DEFLATED;
+        if (directory || !readable || (flags & ZIP_FLAG_ENCRYPTED)) {
+            continue;
+        }
+        
+        entry.pathOffset = static_cast<uint32_t>(pathPool_.size());
+        for (uint16_t c = 0; c < nameLength; ++c) {
+            pathPool_.push_back(NormalizePathChar(name[c]));
+        }
+        pathPool_.push_back('\0');
+        entries_.push_back(entry);
+    }
+    
+    pathPool_.shrink_to_fit();
+    entries_.shrink_to_fit();
+    return true;
+}
+
+const ZipEntry* ZipFile::FindEntry(const std::string& path) const {
+    std::string key(path.size(), '\0');
+    std::transform(path.begin(), path.end(), key.begin(), NormalizePathChar);
+    
+    const char* pool = pathPool_.data();
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), key,
+        [pool](const ZipEntry& entry, const std::string& value) {
+            return strcmp(pool + entry.pathOffset, value.c_str()) < 0;
+        });
+    
+    if (it == entries_.end() || key != pool + it->pathOffset) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+bool ZipFile::GetEntryData(const ZipEntry& entry, const uint8_t*& data, size_t& size,
+                           std::shared_ptr<const void>& owner) const {
+    // The local header repeats the name and has its own extra field; skip both
+    uint64_t headerOffset = entry.localHeaderOffset;
+    if (headerOffset + ZIP_LOCAL_HEADER_SIZE > zipSize_) {
+        return false;
+    }
+    const uint8_t* header = zipData_ + headerOffset;
+    if (ReadU32(header) != ZIP_LOCAL_HEADER_SIGNATURE) {
+        return false;
+    }
+    
+    uint64_t dataOffset = headerOffset + ZIP_LOCAL_HEADER_SIZE + ReadU16(header + 26) + ReadU16(header + 28);
+    if (dataOffset + entry.compressedSize > zipSize_) {
+        return false;
+    }
+    const uint8_t* compressed = zipData_ + dataOffset;
+    
+    if (entry.method == ZIP_METHOD_STORED) {
+        if (entry.compressedSize != entry.uncompressedSize) {
+            return false;
+        }
+        data = compressed;
+        size = entry.uncompressedSize;
+        owner = file_;
+        return true;
+    }
+    
+    void* buffer = BufferPool::Shared().Acquire(std::max<size_t>(entry.uncompressedSize, 1));
+    if (!buffer) {
+        return false;
+    }
+    std::shared_ptr<const void> inflated(buffer, ReleasePooled);
+    
+    if (!Inflate(compressed, entry.compressedSize, static_cast<uint8_t*>(buffer), entry.uncompressedSize)) {
+        return false;
+    }
+    
+    data = static_cast<const uint8_t*>(buffer);
+    size = entry.uncompressedSize;
+    owner = std::move(inflated);
+    return true;
+}
+
+std::shared_ptr<const VTFFile> ZipFile::OpenVTF(const ZipEntry& entry) const {
+    const uint8_t* data;
+    size_t size;
+    std::shared_ptr<const void> owner;
+    if (!GetEntryData(entry, data, size, owner)) {
+        return nullptr;
+    }
+    return VTFFile::Open(data, size, std::move(owner));
+}
+
+} // namespace VTFLib
@@ -0,0 +1,76 @@
+#ifndef ZIPFILE_H
+#define ZIPFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace VTFLib {
+
+class MappedFile;
+class VTFFile;
+
+// Zip record signatures and the compression methods we can read
+const uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034B50;
+const uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014B50;
+const uint32_t ZIP_END_OF_DIRECTORY_SIGNATURE = 0x06054B50;
+const uint16_t ZIP_METHOD_STORED = 0;
+const uint16_t ZIP_METHOD_DEFLATED = 8;
+
+// BSP maps carry their embedded files as a zip in this lump
+const uint32_t BSP_PAKFILE_LUMP = 40;
+
+struct ZipEntry {
+    uint32_t pathOffset;         // lowercase "dir/name.ext" in the path pool
+    uint32_t crc;
+    uint32_t localHeaderOffset;  // from the start of the zip
+    uint32_t compressedSize;
+    uint32_t uncompressedSize;
+    uint16_t method;
+};
+
+// Reader for zip archives and BSP pakfiles, working on a memory-mapped view. The central
+// directory is parsed once into a path-sorted index; stored entries are read in place
+// and deflated ones are inflated into pooled buffers. Thread-safe once loaded.
+class ZipFile {
+public:
+    ZipFile();
+    ~ZipFile();
+    
+    // Load a .zip, or the pakfile lump of a .bsp
+    bool Load(const std::string& filename);
+    
+    // Load a zip into a new shareable, read-only object (nullptr on failure)
+    static std::shared_ptr<const ZipFile> Open(const std::string& filename);
+    
+    size_t GetEntryCount() const { return entries_.size(); }
+    const ZipEntry& GetEntry(size_t index) const { return entries_[index]; }
+    const char* GetEntryPath(const ZipEntry& entry) const { return pathPool_.data() + entry.pathOffset; }
+    
+    // Binary search for a path (case-insensitive, either slash); nullptr if absent
+    const ZipEntry* FindEntry(const std::string& path) const;
+    
+    // Contents of an entry; owner keeps the mapping or the inflated buffer alive
+    bool GetEntryData(const ZipEntry& entry, const uint8_t*& data, size_t& size,
+                      std::shared_ptr<const void>& owner) const;
+    
+    // Load a VTF stored in the archive without extracting it (nullptr on failure)
+    std::shared_ptr<const VTFFile> OpenVTF(const ZipEntry& entry) const;
+    
+    const std::string& GetFilename() const { return filename_; }
+    
+private:
+    std::string filename_;
+    std::shared_ptr<const MappedFile> file_;
+    const uint8_t* zipData_;  // the zip inside file_ (all of it, or a BSP lump)
+    size_t zipSize_;
+    std::vector<ZipEntry> entries_;
+    std::vector<char> pathPool_;
+    
+    bool ParseCentralDirectory();
+};
+
+} // namespace VTFLib
+
+#endif // ZIPFILE_H
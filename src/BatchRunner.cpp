@@ -0,0 +1,68 @@
+#include "BatchRunner.h"
+#include "ThreadPool.h"
+#include <QElapsedTimer>
+#include <QTimer>
+
+BatchRunner::BatchRunner(QObject* parent)
+    : QObject(parent), progressTimer_(new QTimer(this)), generation_(0), running_(false) {
+    // The work itself spreads over VTFLib's pool; this thread only drives it
+    pool_.setMaxThreadCount(1);
+    progressTimer_->setInterval(BATCH_PROGRESS_INTERVAL_MS);
+    connect(progressTimer_, &QTimer::timeout, this, &BatchRunner::reportProgress);
+}
+
+BatchRunner::~BatchRunner() {
+    cancel();
+    pool_.waitForDone();
+}
+
+void BatchRunner::run(const QString& label, std::function<void(VTFLib::BatchProgress&)> work,
+                      std::function<void(qint64 elapsedMs)> finished) {
+    cancel();
+    
+    quint64 generation = ++generation_;
+    auto progress = std::make_shared<VTFLib::BatchProgress>();
+    progress_ = progress;
+    label_ = label;
+    running_ = true;
+    progressTimer_->start();
+    reportProgress();
+    
+    pool_.start([this, generation, progress, work, finished]() {
+        QElapsedTimer timer;
+        timer.start();
+        work(*progress);
+        qint64 elapsed = timer.elapsed();
+        
+        // Anything delivered after a newer run or cancel() is dropped here
+        QMetaObject::invokeMethod(this, [this, generation, elapsed, finished]() {
+            if (generation == generation_) {
+                stop();
+                finished(elapsed);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void BatchRunner::cancel() {
+    generation_++;
+    if (progress_) {
+        progress_->cancel.store(true);
+    }
+    if (running_) {
+        stop();
+    }
+}
+
+void BatchRunner::reportProgress() {
+    if (progress_) {
+        emit progress(label_, progress_->done.load(), progress_->total.load());
+    }
+}
+
+void BatchRunner::stop() {
+    running_ = false;
+    progressTimer_->stop();
+    progress_.reset();
+    emit stopped();
+}
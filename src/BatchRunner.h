@@ -0,0 +1,56 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+#include <memory>
+
+class QTimer;
+
+namespace VTFLib {
+    struct BatchProgress;
+}
+
+// How often the progress of a running batch is read and reported
+const int BATCH_PROGRESS_INTERVAL_MS = 100;
+
+// Runs one whole-tree check (duplicates, validation, mip chains) at a time on a worker
+// thread, so a run over a full game install never blocks the UI. The work reports into a
+// VTFLib::BatchProgress, which is polled and re-emitted as progress(). Starting another
+// batch or cancel() stops the one in flight; its result is never delivered.
+class BatchRunner : public QObject {
+    Q_OBJECT
+    
+public:
+    explicit BatchRunner(QObject* parent = nullptr);
+    ~BatchRunner() override;
+    
+    // work runs on the worker thread; finished runs on the UI thread afterwards, with the
+    // time work took, unless the batch was cancelled or superseded first
+    void run(const QString& label, std::function<void(VTFLib::BatchProgress&)> work,
+             std::function<void(qint64 elapsedMs)> finished);
+    void cancel();
+    
+    bool isRunning() const { return running_; }
+    
+signals:
+    void progress(const QString& label, quint64 done, quint64 total);
+    
+    // The batch in flight completed or was cancelled
+    void stopped();
+    
+private:
+    QThreadPool pool_;
+    QTimer* progressTimer_;
+    quint64 generation_;
+    bool running_;
+    QString label_;
+    std::shared_ptr<VTFLib::BatchProgress> progress_;
+    
+    void reportProgress();
+    void stop();
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,380 @@
+#include "CompareView.h"
+#include "ThreadPool.h"
+#include <QPainter>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QFont>
+#include <QFontMetrics>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Zoom limits; a 4096 texture still fits a small pane at the low end
+const double COMPARE_MIN_SCALE = 0.01;
+const double COMPARE_MAX_SCALE = 32.0;
+
+// Gap between the two panes of the side-by-side view
+const int COMPARE_PANE_GAP = 2;
+
+QString formatPSNR(double psnr) {
+    return std::isinf(psnr) ? QString("∞") : QString("%1 dB").arg(psnr, 0, 'f', 1);
+}
+
+} // namespace
+
+CompareView::CompareView(QWidget* parent)
+    : QWidget(parent), mode_(SideBySide), scale_(1.0), fitToWindowMode_(true),
+      swipePosition_(0.5), panning_(false), swiping_(false) {
+    setBackgroundRole(QPalette::Dark);
+    setAutoFillBackground(true);
+}
+
+void CompareView::setImages(const QImage& a, const QString& labelA, const QImage& b, const QString& labelB) {
+    imageA_ = a.convertToFormat(QImage::Format_RGBA8888);
+    imageB_ = b.size() == a.size() ? b : b.scaled(a.size(), Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    imageB_ = imageB_.convertToFormat(QImage::Format_RGBA8888);
+    pixmapA_ = QPixmap::fromImage(imageA_.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    pixmapB_ = QPixmap::fromImage(imageB_.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    labelA_ = labelA;
+    labelB_ = labelB;
+    tiles_.clear();
+    swipePosition_ = 0.5;
+    fitToWindow();
+}
+
+void CompareView::clear() {
+    imageA_ = QImage();
+    imageB_ = QImage();
+    pixmapA_ = QPixmap();
+    pixmapB_ = QPixmap();
+    tiles_.clear();
+    update();
+}
+
+void CompareView::setMode(Mode mode) {
+    mode_ = mode;
+    setCursor(mode_ == Swipe ? Qt::SplitHCursor : Qt::ArrowCursor);
+    
+    // Pane size changes between one and two panes
+    if (fitToWindowMode_) {
+        fitToWindow();
+    } else {
+        update();
+    }
+}
+
+void CompareView::scaleBy(double factor) {
+    setScaleAt(scale_ * factor, paneRect(0).center());
+}
+
+void CompareView::resetZoom() {
+    setScaleAt(1.0, paneRect(0).center());
+}
+
+void CompareView::fitToWindow() {
+    if (imageA_.isNull()) {
+        return;
+    }
+    
+    QSize pane = paneRect(0).size();
+    scale_ = std::min(static_cast<double>(pane.width()) / imageA_.width(),
+                      static_cast<double>(pane.height()) / imageA_.height());
+    scale_ = qBound(COMPARE_MIN_SCALE, scale_, COMPARE_MAX_SCALE);
+    center_ = QPointF(imageA_.width() / 2.0, imageA_.height() / 2.0);
+    fitToWindowMode_ = true;
+    update();
+    emit zoomChanged(scale_, fitToWindowMode_);
+}
+
+QRect CompareView::paneRect(int pane) const {
+    if (mode_ != SideBySide) {
+        return rect();
+    }
+    int paneWidth = std::max(1, (width() - COMPARE_PANE_GAP) / 2);
+    return QRect(pane * (paneWidth + COMPARE_PANE_GAP), 0, paneWidth, height());
+}
+
+QRect CompareView::visibleImageRect() const {
+    // Every pane shows the same region, so one rect covers both sides
+    QSizeF pane = paneRect(0).size();
+    QRectF visible(center_.x() - pane.width() / (2.0 * scale_), center_.y() - pane.height() / (2.0 * scale_),
+                   pane.width() / scale_, pane.height() / scale_);
+    return visible.toAlignedRect().intersected(imageA_.rect());
+}
+
+QRectF CompareView::mapToPane(const QRectF& imageRect) const {
+    QSizeF pane = paneRect(0).size();
+    return QRectF((imageRect.x() - center_.x()) * scale_ + pane.width() / 2.0,
+                  (imageRect.y() - center_.y()) * scale_ + pane.height() / 2.0,
+                  imageRect.width() * scale_, imageRect.height() * scale_);
+}
+
+void CompareView::setScaleAt(double scale, const QPoint& pos) {
+    if (imageA_.isNull()) {
+        return;
+    }
+    
+    // Keep the image point under pos where it is, in whichever pane pos falls
+    QRect pane = paneRect(mode_ == SideBySide && pos.x() >= paneRect(1).left() ? 1 : 0);
+    QPointF offset = QPointF(pos - pane.topLeft()) - QPointF(pane.width() / 2.0, pane.height() / 2.0);
+    QPointF anchor = center_ + offset / scale_;
+    scale_ = qBound(COMPARE_MIN_SCALE, scale, COMPARE_MAX_SCALE);
+    center_ = anchor - offset / scale_;
+    fitToWindowMode_ = false;
+    clampCenter();
+    update();
+    emit zoomChanged(scale_, fitToWindowMode_);
+}
+
+void CompareView::clampCenter() {
+    center_.setX(qBound(0.0, center_.x(), static_cast<double>(imageA_.width())));
+    center_.setY(qBound(0.0, center_.y(), static_cast<double>(imageA_.height())));
+}
+
+void CompareView::setSwipePosition(int x) {
+    swipePosition_ = qBound(0.0, static_cast<double>(x) / std::max(1, width()), 1.0);
+    update();
+}
+
+void CompareView::ensureTiles(const QRect& imageRect) {
+    if (imageRect.isEmpty()) {
+        return;
+    }
+    
+    std::vector<QPoint> missing;
+    for (int row = imageRect.top() / COMPARE_TILE_SIZE; row <= imageRect.bottom() / COMPARE_TILE_SIZE; ++row) {
+        for (int column = imageRect.left() / COMPARE_TILE_SIZE; column <= imageRect.right() / COMPARE_TILE_SIZE; ++column) {
+            if (!tiles_.contains(tileKey(column, row))) {
+                missing.push_back(QPoint(column, row));
+            }
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+    
+    // Metrics and the difference image in parallel; pixmaps can only be made here
+    std::vector<QImage> differences(missing.size());
+    std::vector<VTFLib::ImageDifference> statistics(missing.size());
+    VTFLib::ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(missing.size()), 1,
+        [this, &missing, &differences, &statistics](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                QRect tile = QRect(missing[i] * COMPARE_TILE_SIZE, QSize(COMPARE_TILE_SIZE, COMPARE_TILE_SIZE)).intersected(imageA_.rect());
+                const uint8_t* a = imageA_.constScanLine(tile.y()) + tile.x() * 4;
+                const uint8_t* b = imageB_.constScanLine(tile.y()) + tile.x() * 4;
+                statistics[i] = VTFLib::ImageMetrics::Compare(a, imageA_.bytesPerLine(), b, imageB_.bytesPerLine(),
+                                                              tile.width(), tile.height());
+                differences[i] = QImage(tile.size(), QImage::Format_RGBA8888);
+                VTFLib::ImageMetrics::AbsoluteDifference(a, imageA_.bytesPerLine(), b, imageB_.bytesPerLine(),
+                                                         tile.width(), tile.height(), differences[i].bits(),
+                                                         differences[i].bytesPerLine(), COMPARE_DIFFERENCE_GAIN);
+            }
+        });
+    
+    for (size_t i = 0; i < missing.size(); ++i) {
+        Tile& tile = tiles_[tileKey(missing[i].x(), missing[i].y())];
+        tile.difference = QPixmap::fromImage(differences[i]);
+        tile.statistics = statistics[i];
+    }
+}
+
+VTFLib::ImageDifference CompareView::visibleDifference(const QRect& imageRect) const {
+    VTFLib::ImageDifference difference;
+    if (imageRect.isEmpty()) {
+        return difference;
+    }
+    for (int row = imageRect.top() / COMPARE_TILE_SIZE; row <= imageRect.bottom() / COMPARE_TILE_SIZE; ++row) {
+        for (int column = imageRect.left() / COMPARE_TILE_SIZE; column <= imageRect.right() / COMPARE_TILE_SIZE; ++column) {
+            difference.Add(tiles_.value(tileKey(column, row)).statistics);
+        }
+    }
+    return difference;
+}
+
+void CompareView::paintEvent(QPaintEvent* event) {
+    QWidget::paintEvent(event);
+    if (imageA_.isNull()) {
+        return;
+    }
+    
+    QRect visible = visibleImageRect();
+    if (visible.isEmpty()) {
+        return;
+    }
+    ensureTiles(visible);
+    QRectF source(visible);
+    QRectF target = mapToPane(source);
+    
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, scale_ < 1.0);
+    
+    if (mode_ == SideBySide) {
+        for (int pane = 0; pane < 2; ++pane) {
+            QRect area = paneRect(pane);
+            painter.save();
+            painter.setClipRect(area);
+            painter.translate(area.topLeft());
+            painter.drawPixmap(target, pane == 0 ? pixmapA_ : pixmapB_, source);
+            painter.restore();
+            drawLabel(painter, pane == 0 ? labelA_ : labelB_, area, Qt::AlignLeft);
+        }
+    } else if (mode_ == Swipe) {
+        int divider = qRound(swipePosition_ * width());
+        painter.drawPixmap(target, pixmapB_, source);
+        painter.save();
+        painter.setClipRect(QRect(0, 0, divider, height()));
+        painter.drawPixmap(target, pixmapA_, source);
+        painter.restore();
+        painter.setPen(QPen(palette().highlight().color(), 2));
+        painter.drawLine(divider, 0, divider, height());
+        drawLabel(painter, labelA_, rect(), Qt::AlignLeft);
+        drawLabel(painter, labelB_, rect(), Qt::AlignRight);
+    } else {
+        // Whole tiles, straight from the cache
+        for (int row = visible.top() / COMPARE_TILE_SIZE; row <= visible.bottom() / COMPARE_TILE_SIZE; ++row) {
+            for (int column = visible.left() / COMPARE_TILE_SIZE; column <= visible.right() / COMPARE_TILE_SIZE; ++column) {
+                const QPixmap& tile = tiles_[tileKey(column, row)].difference;
+                QRectF tileRect(column * COMPARE_TILE_SIZE, row * COMPARE_TILE_SIZE, tile.width(), tile.height());
+                painter.drawPixmap(mapToPane(tileRect), tile, QRectF(tile.rect()));
+            }
+        }
+        drawLabel(painter, QString("|%1 − %2| ×%3").arg(labelA_, labelB_).arg(COMPARE_DIFFERENCE_GAIN), rect(), Qt::AlignLeft);
+    }
+    
+    drawStatistics(painter, visible);
+}
+
+void CompareView::drawLabel(QPainter& painter, const QString& text, const QRect& pane, Qt::Alignment alignment) const {
+    QFontMetrics metrics(font());
+    QRect box = metrics.boundingRect(text).adjusted(-6, -3, 6, 3);
+    box.moveTop(pane.top() + 6);
+    if (alignment & Qt::AlignRight) {
+        box.moveRight(pane.right() - 6);
+    } else {
+        box.moveLeft(pane.left() + 6);
+    }
+    painter.fillRect(box, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    painter.drawText(box, Qt::AlignCenter, text);
+}
+
+void CompareView::drawStatistics(QPainter& painter, const QRect& imageRect) const {
+    VTFLib::ImageDifference difference = visibleDifference(imageRect);
+    if (difference.pixels == 0) {
+        return;
+    }
+    
+    // Whole tiles are counted, so the numbers stay put while panning inside them
+    QStringList lines;
+    lines << QString("Visible tiles: %1 px, RGB PSNR %2").arg(difference.pixels).arg(formatPSNR(difference.CombinedPSNR()));
+    const char* channels = "RGBA";
+    for (uint32_t c = 0; c < 4; ++c) {
+        lines << QString("%1  mean %2  max %3  PSNR %4")
+            .arg(QChar(channels[c]))
+            .arg(difference.MeanAbsoluteError(c), 0, 'f', 2)
+            .arg(static_cast<int>(difference.maxError[c]), 3)
+            .arg(formatPSNR(difference.PSNR(c)));
+    }
+    
+    QFont font("monospace");
+    font.setStyleHint(QFont::TypeWriter);
+    QFontMetrics metrics(font);
+    int textWidth = 0;
+    for (const QString& line : lines) {
+        textWidth = std::max(textWidth, metrics.horizontalAdvance(line));
+    }
+    QRect box(6, height() - 6 - lines.size() * metrics.height() - 8, textWidth + 12, lines.size() * metrics.height() + 8);
+    painter.fillRect(box, QColor(0, 0, 0, 160));
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    painter.drawText(box.adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop, lines.join('\n'));
+}
+
+void CompareView::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    if (fitToWindowMode_) {
+        fitToWindow();
+    }
+}
+
+void CompareView::wheelEvent(QWheelEvent* event) {
+    if (imageA_.isNull()) {
+        QWidget::wheelEvent(event);
+        return;
+    }
+    
+    int delta = event->angleDelta().y();
+    if (delta > 0) {
+        setScaleAt(scale_ * 1.15, event->position().toPoint());
+    } else if (delta < 0) {
+        setScaleAt(scale_ / 1.15, event->position().toPoint());
+    }
+    
+    event->accept();
+}
+
+void CompareView::mouseDoubleClickEvent(QMouseEvent* event) {
+    if (imageA_.isNull()) {
+        QWidget::mouseDoubleClickEvent(event);
+        return;
+    }
+    
+    if (fitToWindowMode_) {
+        setScaleAt(1.0, event->pos());
+    } else {
+        fitToWindow();
+    }
+    event->accept();
+}
+
+void CompareView::mousePressEvent(QMouseEvent* event) {
+    if (imageA_.isNull()) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    
+    // The left button drags the divider in swipe mode; the middle button always pans
+    if (event->button() == Qt::LeftButton && mode_ == Swipe) {
+        swiping_ = true;
+        setSwipePosition(event->pos().x());
+        event->accept();
+    } else if (event->button() == Qt::LeftButton || event->button() == Qt::MiddleButton) {
+        panning_ = true;
+        lastMousePos_ = event->pos();
+        setCursor(Qt::ClosedHandCursor);
+        event->accept();
+    } else {
+        QWidget::mousePressEvent(event);
+    }
+}
+
+void CompareView::mouseMoveEvent(QMouseEvent* event) {
+    if (swiping_) {
+        setSwipePosition(event->pos().x());
+        event->accept();
+    } else if (panning_) {
+        QPoint delta = event->pos() - lastMousePos_;
+        lastMousePos_ = event->pos();
+        center_ -= QPointF(delta) / scale_;
+        clampCenter();
+        update();
+        event->accept();
+    } else {
+        QWidget::mouseMoveEvent(event);
+    }
+}
+
+void CompareView::mouseReleaseEvent(QMouseEvent* event) {
+    if (swiping_ || panning_) {
+        swiping_ = false;
+        panning_ = false;
+        setCursor(mode_ == Swipe ? Qt::SplitHCursor : Qt::ArrowCursor);
+        event->accept();
+    } else {
+        QWidget::mouseReleaseEvent(event);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef COMPAREVIEW_H
+#define COMPAREVIEW_H
+
+#include "ImageMetrics.h"
+#include <QWidget>
+#include <QImage>
+#include <QPixmap>
+#include <QHash>
+#include <QPoint>
+#include <QPointF>
+
+// Side of the square tiles the difference image and its statistics are computed in
+const int COMPARE_TILE_SIZE = 256;
+
+// Multiplier applied to |A - B| so small errors are visible
+const int COMPARE_DIFFERENCE_GAIN = 4;
+
+// Two images under one zoom and pan, shown side by side, as a swipe, or as their
+// difference. Differences are only computed for the tiles that have been on screen,
+// so a fully zoomed-in 4096x4096 pair costs a handful of tiles per frame.
+class CompareView : public QWidget {
+    Q_OBJECT
+    
+public:
+    enum Mode {
+        SideBySide,
+        Swipe,
+        Difference
+    };
+    
+    explicit CompareView(QWidget* parent = nullptr);
+    
+    // b is resized to a's size (nearest neighbour) when they differ, e.g. two mips
+    void setImages(const QImage& a, const QString& labelA, const QImage& b, const QString& labelB);
+    void clear();
+    bool hasImages() const { return !imageA_.isNull(); }
+    
+    void setMode(Mode mode);
+    Mode mode() const { return mode_; }
+    
+    double getScale() const { return scale_; }
+    bool isFitToWindow() const { return fitToWindowMode_; }
+    void scaleBy(double factor);
+    void resetZoom();
+    void fitToWindow();
+    
+signals:
+    void zoomChanged(double factor, bool fitMode);
+    
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    
+private:
+    struct Tile {
+        QPixmap difference;
+        VTFLib::ImageDifference statistics;
+    };
+    
+    QImage imageA_;     // straight RGBA8888, for the metrics
+    QImage imageB_;
+    QPixmap pixmapA_;   // display copies
+    QPixmap pixmapB_;
+    QString labelA_;
+    QString labelB_;
+    QHash<quint64, Tile> tiles_;  // difference tiles computed so far, by tileKey()
+    Mode mode_;
+    double scale_;
+    bool fitToWindowMode_;
+    QPointF center_;         // image point shown at the centre of each pane
+    double swipePosition_;   // divider, as a fraction of the pane width
+    bool panning_;
+    bool swiping_;
+    QPoint lastMousePos_;
+    
+    static quint64 tileKey(int column, int row) { return (static_cast<quint64>(row) << 32) | static_cast<quint32>(column); }
+    
+    QRect paneRect(int pane) const;
+    QRect visibleImageRect() const;
+    QRectF mapToPane(const QRectF& imageRect) const;
+    void setScaleAt(double scale, const QPoint& pos);
+    void clampCenter();
+    void setSwipePosition(int x);
+    void ensureTiles(const QRect& imageRect);
+    VTFLib::ImageDifference visibleDifference(const QRect& imageRect) const;
+    void drawLabel(QPainter& painter, const QString& text, const QRect& pane, Qt::Alignment alignment) const;
+    void drawStatistics(QPainter& painter, const QRect& imageRect) const;
+};
+
+#endif // COMPAREVIEW_H
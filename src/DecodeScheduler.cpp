@@ -0,0 +1,146 @@
+#include "DecodeScheduler.h"
+#include "VTFReader.h"
+#include "VTFFile.h"
+#include "TextureSource.h"
+#include <QVector>
+#include <algorithm>
+
+// Mips up to this size make the first, immediately shown stage
+const int PROGRESSIVE_PREVIEW_SIZE = 128;
+
+DecodeScheduler::DecodeScheduler(QObject* parent)
+    : QObject(parent), generation_(0), cancelFlag_(std::make_shared<std::atomic<bool>>(false)) {
+}
+
+DecodeScheduler::~DecodeScheduler() {
+    cancel();
+    pool_.waitForDone();
+}
+
+void DecodeScheduler::requestFile(const QString& filename) {
+    schedule(filename, nullptr, 0);
+}
+
+void DecodeScheduler::requestMipmap(std::shared_ptr<const VTFLib::VTFFile> file, int mipLevel) {
+    if (file) {
+        schedule(QString(), std::move(file), mipLevel);
+    }
+}
+
+void DecodeScheduler::cancel() {
+    // Anything already queued for delivery is dropped by the generation check
+    generation_++;
+    cancelFlag_->store(true, std::memory_order_relaxed);
+}
+
+void DecodeScheduler::schedule(const QString& filename, std::shared_ptr<const VTFLib::VTFFile> file,
+                               int mipLevel) {
+    cancel();
+    cancelFlag_ = std::make_shared<std::atomic<bool>>(false);
+    
+    quint64 generation = generation_;
+    std::shared_ptr<std::atomic<bool>> cancelled = cancelFlag_;
+    
+    pool_.start([this, filename, file, mipLevel, generation, cancelled]() {
+        // Superseded before it even started
+        if (cancelled->load(std::memory_order_relaxed)) {
+            return;
+        }
+        
+        std::shared_ptr<const VTFLib::VTFFile> loaded = file;
+        if (!loaded) {
+            loaded = TextureSource::shared().openTexture(filename);
+            deliver(generation, [this, filename, loaded]() {
+                emit fileLoaded(filename, loaded);
+            });
+            if (!loaded) {
+                return;
+            }
+        }
+        
+        decodeProgressive(loaded, mipLevel, generation, *cancelled);
+    });
+}
+
+void DecodeScheduler::decodeProgressive(std::shared_ptr<const VTFLib::VTFFile> file, int mipLevel,
+                                        quint64 generation, const std::atomic<bool>& cancelled) {
+    VTFReader reader(file);
+    int fullWidth = std::max(1, reader.getWidth() >> mipLevel);
+    int fullHeight = std::max(1, reader.getHeight() >> mipLevel);
+    int largestSide = std::max(fullWidth, fullHeight);
+    
+    // Small textures are cheap enough to show in one go
+    if (largestSide <= PROGRESSIVE_PREVIEW_SIZE * 2) {
+        QImage image = reader.getDisplayImage(0, mipLevel, &cancelled);
+        if (!image.isNull()) {
+            deliver(generation, [this, image]() {
+                emit previewReady(image, image.size());
+            });
+        }
+        return;
+    }
+    
+    // Start from the largest mip that still fits the preview size
+    int previewLevel = mipLevel;
+    while (previewLevel < reader.getMipmapCount() - 1 &&
+           (largestSide >> (previewLevel - mipLevel)) > PROGRESSIVE_PREVIEW_SIZE) {
+        previewLevel++;
+    }
+    
+    QImage preview;
+    if (previewLevel == mipLevel) {
+        // No smaller mips stored; average the level itself down instead
+        int reduction = 2;
+        while (reduction < 4 && (largestSide >> reduction) > PROGRESSIVE_PREVIEW_SIZE) {
+            reduction++;
+        }
+        preview = reader.getReducedImage(reduction, 0, mipLevel);
+    } else {
+        preview = reader.getDisplayImage(0, previewLevel, &cancelled);
+    }
+    
+    if (!preview.isNull()) {
+        QSize fullSize(fullWidth, fullHeight);
+        deliver(generation, [this, preview, fullSize]() {
+            emit previewReady(preview, fullSize);
+        });
+    }
+    
+    // Sharpen two mips (16x the pixels) at a time, ending on the requested level
+    QVector<int> levels;
+    for (int level = previewLevel - 2; level > mipLevel; level -= 2) {
+        levels.append(level);
+    }
+    levels.append(mipLevel);
+    
+    for (int level : levels) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        QImage image = reader.getDisplayImage(0, level, &cancelled);
+        if (image.isNull()) {
+            return;
+        }
+        
+        // Without a preview the first finished level stands in for it
+        if (preview.isNull()) {
+            preview = image;
+            QSize fullSize(fullWidth, fullHeight);
+            deliver(generation, [this, image, fullSize]() {
+                emit previewReady(image, fullSize);
+            });
+        } else {
+            deliver(generation, [this, image]() {
+                emit imageRefined(image);
+            });
+        }
+    }
+}
+
+void DecodeScheduler::deliver(quint64 generation, std::function<void()> emitter) {
+    QMetaObject::invokeMethod(this, [this, generation, emitter]() {
+        if (generation == generation_) {
+            emitter();
+        }
+    }, Qt::QueuedConnection);
+}
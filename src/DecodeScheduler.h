@@ -0,0 +1,55 @@
+#ifndef DECODESCHEDULER_H
+#define DECODESCHEDULER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace VTFLib {
+    class VTFFile;
+}
+
+// Latest-wins background loader for the texture on screen. Every request supersedes the
+// ones before it: stale jobs are cancelled before they start or between decode bands, and
+// their results are never delivered. Signals are emitted on the scheduler's own thread.
+class DecodeScheduler : public QObject {
+    Q_OBJECT
+    
+public:
+    explicit DecodeScheduler(QObject* parent = nullptr);
+    ~DecodeScheduler() override;
+    
+    // Load a VTF from disk, then decode its top mip progressively
+    void requestFile(const QString& filename);
+    
+    // Decode another mip of an already loaded file progressively
+    void requestMipmap(std::shared_ptr<const VTFLib::VTFFile> file, int mipLevel);
+    
+    // Drop whatever is in flight
+    void cancel();
+    
+signals:
+    // file is null if the load failed
+    void fileLoaded(const QString& filename, std::shared_ptr<const VTFLib::VTFFile> file);
+    
+    // A low-resolution stand-in laid out at fullSize, followed by sharper versions
+    void previewReady(const QImage& image, const QSize& fullSize);
+    void imageRefined(const QImage& image);
+    
+private:
+    QThreadPool pool_;
+    quint64 generation_;
+    std::shared_ptr<std::atomic<bool>> cancelFlag_;
+    
+    void schedule(const QString& filename, std::shared_ptr<const VTFLib::VTFFile> file, int mipLevel);
+    void decodeProgressive(std::shared_ptr<const VTFLib::VTFFile> file, int mipLevel,
+                           quint64 generation, const std::atomic<bool>& cancelled);
+    void deliver(quint64 generation, std::function<void()> emitter);
+};
+
+#endif // DECODESCHEDULER_H
@@ -0,0 +1,171 @@
+#include "DirectoryScanner.h"
+#include "DirectoryWalker.h"
+#include "GameIndex.h"
+#include "MaterialDatabase.h"
+#include "TextureMetadataIndex.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+
+DirectoryScanner::DirectoryScanner(QObject* parent)
+    : QObject(parent), generation_(0), gameGeneration_(0), metadataGeneration_(0), scanning_(false), recursive_(false) {
+    // The walker and the material parser spread their work over VTFLib's own pool; these
+    // threads only drive a directory scan and a game index, which may overlap
+    pool_.setMaxThreadCount(2);
+}
+
+DirectoryScanner::~DirectoryScanner() {
+    cancel();
+    pool_.waitForDone();
+}
+
+void DirectoryScanner::scan(const QString& root, const QStringList& suffixes, bool recursive) {
+    cancel();
+    
+    quint64 generation = ++generation_;
+    quint64 metadataGeneration = ++metadataGeneration_;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    cancelled_ = cancelled;
+    scanning_ = true;
+    root_ = root;
+    recursive_ = recursive;
+    
+    std::string rootPath = QDir::cleanPath(root).toStdString();
+    std::string cacheFile = directoryCacheFile(root, recursive);
+    std::vector<std::string> suffixList;
+    for (const QString& suffix : suffixes) {
+        suffixList.push_back(suffix.toStdString());
+    }
+    
+    pool_.start([this, generation, metadataGeneration, cancelled, rootPath, cacheFile, suffixList, recursive]() {
+        QElapsedTimer timer;
+        timer.start();
+        
+        // The first file goes out at once; after that, batches fill up or time out
+        QStringList batch;
+        std::vector<std::string> textures;
+        const std::vector<std::string> textureSuffix = { ".vtf" };
+        qint64 lastDelivery = -SCAN_BATCH_INTERVAL_MS;
+        auto flush = [this, generation, &batch, &timer, &lastDelivery]() {
+            if (batch.isEmpty()) {
+                return;
+            }
+            deliver(&generation_, generation, [this, files = batch]() { emit filesFound(files); });
+            batch.clear();
+            lastDelivery = timer.elapsed();
+        };
+        
+        size_t count = VTFLib::DirectoryWalker::Walk(rootPath, suffixList, recursive,
+            [&batch, &textures, &textureSuffix, &timer, &lastDelivery, &flush](std::vector<std::string>& files) {
+                for (const std::string& file : files) {
+                    batch.append(QString::fromStdString(file));
+                    if (VTFLib::DirectoryWalker::MatchesSuffix(file, textureSuffix)) {
+                        textures.push_back(file);
+                    }
+                }
+                if (batch.size() >= SCAN_BATCH_SIZE || timer.elapsed() - lastDelivery >= SCAN_BATCH_INTERVAL_MS) {
+                    flush();
+                }
+            }, cancelled.get());
+        flush();
+        
+        qint64 elapsed = timer.elapsed();
+        deliver(&generation_, generation, [this, count, elapsed]() {
+            scanning_ = false;
+            emit finished(static_cast<int>(count), elapsed);
+        });
+        
+        if (cancelled->load()) {
+            return;
+        }
+        
+        // Only textures added or changed since the last scan have their header read
+        auto metadata = std::make_shared<VTFLib::TextureMetadataIndex>();
+        metadata->Load(cacheFile);
+        metadata->Refresh(textures);
+        metadata->Save(cacheFile);
+        deliver(&metadataGeneration_, metadataGeneration, [this, metadata]() {
+            emit metadataReady(metadata);
+        });
+    });
+}
+
+void DirectoryScanner::refreshMetadata(const QStringList& textures) {
+    if (root_.isEmpty()) {
+        return;
+    }
+    
+    quint64 generation = ++metadataGeneration_;
+    std::string cacheFile = directoryCacheFile(root_, recursive_);
+    std::vector<std::string> textureList;
+    textureList.reserve(textures.size());
+    for (const QString& texture : textures) {
+        textureList.push_back(texture.toStdString());
+    }
+    
+    pool_.start([this, generation, cacheFile, textureList]() {
+        // The last scan or refresh saved the index; unchanged rows are kept from it
+        auto metadata = std::make_shared<VTFLib::TextureMetadataIndex>();
+        metadata->Load(cacheFile);
+        metadata->Refresh(textureList);
+        metadata->Save(cacheFile);
+        deliver(&metadataGeneration_, generation, [this, metadata]() {
+            emit metadataReady(metadata);
+        });
+    });
+}
+
+void DirectoryScanner::indexGame(std::shared_ptr<VTFLib::GameIndex> game, const QString& cacheKey) {
+    quint64 generation = ++gameGeneration_;
+    std::string cacheFile = metadataCacheFile(cacheKey).toStdString();
+    
+    pool_.start([this, generation, game, cacheFile]() {
+        QElapsedTimer timer;
+        timer.start();
+        game->IndexFiles();
+        std::shared_ptr<const VTFLib::MaterialDatabase> materials = VTFLib::MaterialDatabase::Open(*game);
+        
+        // Only VPKs and loose files changed since the last session have their headers read
+        auto metadata = std::make_shared<VTFLib::TextureMetadataIndex>();
+        metadata->Load(cacheFile);
+        metadata->Refresh(*game);
+        metadata->Save(cacheFile);
+        
+        qint64 elapsed = timer.elapsed();
+        std::shared_ptr<const VTFLib::GameIndex> index = game;
+        deliver(&gameGeneration_, generation, [this, index, materials, metadata, elapsed]() {
+            emit gameIndexed(index, materials, metadata, elapsed);
+        });
+    });
+}
+
+QString DirectoryScanner::metadataCacheFile(const QString& key) {
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/metadata";
+    QDir().mkpath(directory);
+    QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return directory + "/" + QString::fromLatin1(hash) + ".vtmi";
+}
+
+std::string DirectoryScanner::directoryCacheFile(const QString& root, bool recursive) {
+    return metadataCacheFile(QString("%1|%2").arg(QDir::cleanPath(root)).arg(recursive)).toStdString();
+}
+
+void DirectoryScanner::cancel() {
+    // Batches already queued for delivery are dropped by the generation check
+    generation_++;
+    metadataGeneration_++;
+    scanning_ = false;
+    if (cancelled_) {
+        cancelled_->store(true);
+        cancelled_.reset();
+    }
+}
+
+void DirectoryScanner::deliver(const quint64* counter, quint64 generation, std::function<void()> handler) {
+    QMetaObject::invokeMethod(this, [counter, generation, handler]() {
+        if (generation == *counter) {
+            handler();
+        }
+    }, Qt::QueuedConnection);
+}
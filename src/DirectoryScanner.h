@@ -0,0 +1,88 @@
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace VTFLib {
+    class GameIndex;
+    class MaterialDatabase;
+    class TextureMetadataIndex;
+}
+
+// Files delivered to the UI thread at a time during a scan
+const int SCAN_BATCH_SIZE = 256;
+
+// Longest a found file waits before its batch is delivered anyway
+const int SCAN_BATCH_INTERVAL_MS = 50;
+
+// Longest the UI thread spends loading found files before returning to the event loop
+const int SCAN_LOAD_SLICE_MS = 30;
+
+// Finds the files of a directory tree in the background with VTFLib's parallel walker
+// and streams them to the UI thread in batches, so loading can start on the first
+// directories while the rest of the tree is still being listed. Once the walk is done,
+// the tree's saved texture metadata index is refreshed against the textures found and
+// saved again. Starting a new scan cancels the one in flight; nothing from it is
+// delivered afterwards. Game installs are indexed the same way, independently of scans.
+class DirectoryScanner : public QObject {
+    Q_OBJECT
+    
+public:
+    explicit DirectoryScanner(QObject* parent = nullptr);
+    ~DirectoryScanner() override;
+    
+    // Scan root for files whose names end with one of suffixes (e.g. ".vtf", "_dir.vpk")
+    void scan(const QString& root, const QStringList& suffixes, bool recursive);
+    void cancel();
+    
+    // Bring the metadata of the tree scanned last up to date after some of its files
+    // changed, given every texture it now holds, and deliver it through metadataReady.
+    // Only the headers of textures whose stamp changed are read; a newer scan or refresh wins.
+    void refreshMetadata(const QStringList& textures);
+    
+    // Walk the search paths of a game install (see GameIndex::LoadSearchPaths), parse
+    // every material and refresh its cached texture metadata. game must not be touched
+    // until gameIndexed hands it back. Indexing another install drops the result of the
+    // previous one.
+    void indexGame(std::shared_ptr<VTFLib::GameIndex> game, const QString& cacheKey);
+    
+    bool isScanning() const { return scanning_; }
+    
+    // Where the metadata index of a directory or game install is cached
+    static QString metadataCacheFile(const QString& key);
+    
+signals:
+    void filesFound(const QStringList& files);
+    void finished(int fileCount, qint64 elapsedMs);
+    
+    // The loose textures of the tree; only textures that changed since the last scan were read
+    void metadataReady(std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata);
+    
+    // The install indexed last, with its materials (nullptr if none parsed) and texture metadata
+    void gameIndexed(std::shared_ptr<const VTFLib::GameIndex> game,
+                     std::shared_ptr<const VTFLib::MaterialDatabase> materials,
+                     std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata, qint64 elapsedMs);
+    
+private:
+    QThreadPool pool_;
+    quint64 generation_;
+    quint64 gameGeneration_;
+    quint64 metadataGeneration_;
+    bool scanning_;
+    QString root_;      // of the last scan, which names its metadata cache
+    bool recursive_;
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+    
+    static std::string directoryCacheFile(const QString& root, bool recursive);
+    
+    // Run handler on the UI thread unless *counter has moved past generation by then
+    void deliver(const quint64* counter, quint64 generation, std::function<void()> handler);
+};
+
+#endif // DIRECTORYSCANNER_H
@@ -0,0 +1,201 @@
+#include "DirectoryWatcher.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <algorithm>
+#include <memory>
+
+// Quiet period after the last notification before the touched directories are rescanned
+const int WATCH_COALESCE_MS = 300;
+
+// Files watched individually; directories don't count against it
+const int WATCH_FILE_LIMIT = 4096;
+
+DirectoryWatcher::DirectoryWatcher(QObject* parent)
+    : QObject(parent), watcher_(new QFileSystemWatcher(this)), flushTimer_(new QTimer(this)),
+      generation_(0), recursive_(false) {
+    pool_.setMaxThreadCount(1);
+    flushTimer_->setSingleShot(true);
+    flushTimer_->setInterval(WATCH_COALESCE_MS);
+    
+    connect(watcher_, &QFileSystemWatcher::directoryChanged, this, &DirectoryWatcher::onPathChanged);
+    connect(watcher_, &QFileSystemWatcher::fileChanged, this, &DirectoryWatcher::onPathChanged);
+    connect(flushTimer_, &QTimer::timeout, this, &DirectoryWatcher::flush);
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    generation_++;
+    pool_.waitForDone();
+}
+
+void DirectoryWatcher::watch(const QString& root, const QStringList& nameFilters, bool recursive) {
+    stop();
+    nameFilters_ = nameFilters;
+    recursive_ = recursive;
+    
+    // Listing every directory stats every file, which takes long enough on a network
+    // mount to freeze the window; the UI thread only installs the result
+    quint64 generation = generation_;
+    QString rootPath = QDir(root).absolutePath();
+    pool_.start([this, generation, rootPath, nameFilters, recursive]() {
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshotTree(rootPath, nameFilters, recursive, *snapshot);
+        QMetaObject::invokeMethod(this, [this, generation, snapshot]() {
+            if (generation == generation_) {
+                install(*snapshot, nullptr);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void DirectoryWatcher::stop() {
+    generation_++;
+    flushTimer_->stop();
+    QStringList paths = watcher_->files() + watcher_->directories();
+    if (!paths.isEmpty()) {
+        watcher_->removePaths(paths);
+    }
+    directories_.clear();
+    watchedFiles_.clear();
+    dirtyDirectories_.clear();
+}
+
+void DirectoryWatcher::onPathChanged(const QString& path) {
+    // A changed file is picked up by rescanning the directory holding it
+    dirtyDirectories_.insert(directories_.contains(path) ? path : QFileInfo(path).absolutePath());
+    flushTimer_->start();
+}
+
+void DirectoryWatcher::flush() {
+    QStringList added;
+    QStringList modified;
+    QStringList removed;
+    
+    QSet<QString> dirty;
+    dirty.swap(dirtyDirectories_);
+    for (const QString& directory : dirty) {
+        if (!directories_.contains(directory)) {
+            continue;  // already dropped along with a removed parent
+        }
+        if (QFileInfo(directory).isDir()) {
+            rescanDirectory(directory, added, modified, removed);
+        } else {
+            removeDirectory(directory, removed);
+        }
+    }
+    
+    if (added.isEmpty() && modified.isEmpty() && removed.isEmpty()) {
+        return;
+    }
+    std::sort(added.begin(), added.end());
+    std::sort(modified.begin(), modified.end());
+    std::sort(removed.begin(), removed.end());
+    emit filesChanged(added, modified, removed);
+}
+
+void DirectoryWatcher::snapshotTree(const QString& directory, const QStringList& nameFilters, bool recursive,
+                                    Snapshot& snapshot) {
+    QHash<QString, FileState>& files = snapshot[directory];
+    QDir dir(directory);
+    for (const QFileInfo& fileInfo : dir.entryInfoList(nameFilters, QDir::Files)) {
+        files.insert(fileInfo.absoluteFilePath(), FileState{ fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch() });
+    }
+    
+    // Linked directories aren't followed, as in DirectoryWalker, so a cycle can't recurse
+    if (recursive) {
+        for (const QFileInfo& subdirectory : dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            snapshotTree(subdirectory.absoluteFilePath(), nameFilters, recursive, snapshot);
+        }
+    }
+}
+
+void DirectoryWatcher::install(const Snapshot& snapshot, QStringList* added) {
+    watcher_->addPaths(snapshot.keys());
+    for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); ++it) {
+        directories_.insert(it.key(), it.value());
+        for (auto file = it->constBegin(); file != it->constEnd(); ++file) {
+            watchFile(file.key());
+            if (added) {
+                added->append(file.key());
+            }
+        }
+    }
+}
+
+void DirectoryWatcher::addDirectory(const QString& directory, QStringList* added) {
+    Snapshot snapshot;
+    snapshotTree(directory, nameFilters_, recursive_, snapshot);
+    install(snapshot, added);
+}
+
+void DirectoryWatcher::removeDirectory(const QString& directory, QStringList& removed) {
+    QString prefix = directory + "/";
+    for (auto it = directories_.begin(); it != directories_.end();) {
+        if (it.key() != directory && !it.key().startsWith(prefix)) {
+            ++it;
+            continue;
+        }
+        for (auto file = it->constBegin(); file != it->constEnd(); ++file) {
+            removed.append(file.key());
+            if (watchedFiles_.remove(file.key())) {
+                watcher_->removePath(file.key());
+            }
+        }
+        watcher_->removePath(it.key());
+        it = directories_.erase(it);
+    }
+}
+
+void DirectoryWatcher::rescanDirectory(const QString& directory, QStringList& added,
+                                       QStringList& modified, QStringList& removed) {
+    QHash<QString, FileState>& files = directories_[directory];
+    QHash<QString, FileState> previous;
+    previous.swap(files);
+    
+    QDir dir(directory);
+    for (const QFileInfo& fileInfo : dir.entryInfoList(nameFilters_, QDir::Files)) {
+        QString path = fileInfo.absoluteFilePath();
+        FileState state{ fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch() };
+        files.insert(path, state);
+        
+        auto old = previous.constFind(path);
+        if (old == previous.constEnd()) {
+            added.append(path);
+            watchFile(path);
+        } else if (old->size != state.size || old->modified != state.modified) {
+            modified.append(path);
+            
+            // A save that replaced the file leaves the old watch behind; renew it
+            if (watchedFiles_.contains(path)) {
+                watcher_->removePath(path);
+                watcher_->addPath(path);
+            }
+        }
+    }
+    
+    for (auto old = previous.constBegin(); old != previous.constEnd(); ++old) {
+        if (!files.contains(old.key())) {
+            removed.append(old.key());
+            if (watchedFiles_.remove(old.key())) {
+                watcher_->removePath(old.key());
+            }
+        }
+    }
+    
+    // New subdirectories bring all of their files with them
+    if (recursive_) {
+        for (const QFileInfo& subdirectory : dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            if (!directories_.contains(subdirectory.absoluteFilePath())) {
+                addDirectory(subdirectory.absoluteFilePath(), &added);
+            }
+        }
+    }
+}
+
+void DirectoryWatcher::watchFile(const QString& path) {
+    if (watchedFiles_.size() < WATCH_FILE_LIMIT && !watchedFiles_.contains(path) && watcher_->addPath(path)) {
+        watchedFiles_.insert(path);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef DIRECTORYWATCHER_H
+#define DIRECTORYWATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Watches the open directory tree and reports what changed in it. Notifications are
+// coalesced: every directory touched within a short window is rescanned once and
+// compared against its last snapshot, so a burst of saves becomes a single delta.
+// Directories are always watched; files are watched individually only up to a budget,
+// to stay inside the system's watch limit. Past it, in-place edits go unnoticed, but
+// saves that replace the file (as most editors do) still register through the directory.
+// The first snapshot of the tree is taken in the background; changes start being reported
+// once it is in place.
+class DirectoryWatcher : public QObject {
+    Q_OBJECT
+    
+public:
+    explicit DirectoryWatcher(QObject* parent = nullptr);
+    ~DirectoryWatcher() override;
+    
+    // Start watching root (and its subdirectories) for files matching nameFilters
+    void watch(const QString& root, const QStringList& nameFilters, bool recursive);
+    void stop();
+    
+signals:
+    void filesChanged(const QStringList& added, const QStringList& modified, const QStringList& removed);
+    
+private slots:
+    void onPathChanged(const QString& path);
+    void flush();
+    
+private:
+    struct FileState {
+        qint64 size;
+        qint64 modified;  // msecs since epoch
+    };
+    
+    typedef QHash<QString, QHash<QString, FileState>> Snapshot;  // directory -> file -> state
+    
+    QFileSystemWatcher* watcher_;
+    QTimer* flushTimer_;
+    QThreadPool pool_;
+    quint64 generation_;  // bumped by stop(), so a stale background snapshot is dropped
+    QStringList nameFilters_;
+    bool recursive_;
+    Snapshot directories_;
+    QSet<QString> watchedFiles_;
+    QSet<QString> dirtyDirectories_;
+    
+    // Lists a directory and, if recursive, its subdirectories without following links;
+    // safe to call from any thread
+    static void snapshotTree(const QString& directory, const QStringList& nameFilters, bool recursive,
+                             Snapshot& snapshot);
+    void install(const Snapshot& snapshot, QStringList* added);
+    void addDirectory(const QString& directory, QStringList* added);
+    void removeDirectory(const QString& directory, QStringList& removed);
+    void rescanDirectory(const QString& directory, QStringList& added,
+                         QStringList& modified, QStringList& removed);
+    void watchFile(const QString& path);
+};
+
+#endif // DIRECTORYWATCHER_H
@@ -45,6 +45,12 @@ GalleryView::GalleryView(QWidget* parent) : QWidget(parent) {
     viewToggleButton_->setMaximumWidth(30);
     topLayout->addWidget(viewToggleButton_);
     
+    clearGroupsButton_ = new QPushButton("✕");
+    clearGroupsButton_->setToolTip("Show all textures again");
+    clearGroupsButton_->setMaximumWidth(30);
+    clearGroupsButton_->setVisible(false);
+    topLayout->addWidget(clearGroupsButton_);
+    
     countLabel_ = new QLabel("0");
     countLabel_->setMinimumWidth(30);
     countLabel_->setAlignment(Qt::AlignCenter);
@@ -85,6 +91,8 @@ GalleryView::GalleryView(QWidget* parent) : QWidget(parent) {
             this, &GalleryView::sortItems);
     connect(viewToggleButton_, &QPushButton::clicked,
             this, &GalleryView::toggleViewMode);
+    connect(clearGroupsButton_, &QPushButton::clicked,
+            this, &GalleryView::clearGroups);
     connect(dimFilterCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &GalleryView::filterByDimension);
     
@@ -92,12 +100,12 @@ GalleryView::GalleryView(QWidget* parent) : QWidget(parent) {
     searchEdit_->installEventFilter(this);
 }
 
-void GalleryView::addTexture(const QString& filename, const QImage& thumbnail) {
+void GalleryView::addTexture(const QString& filename, const QImage& thumbnail, qint64 fileSize) {
     QFileInfo fileInfo(filename);
     QString displayName = fileInfo.fileName();
     
-    // Build detailed tooltip with file information
-    qint64 size = fileInfo.size();
+    // Build detailed tooltip with file information (archived textures pass their size in)
+    qint64 size = fileSize >= 0 ? fileSize : fileInfo.size();
     QString sizeStr;
     if (size < 1024) {
         sizeStr = QString("%1 B").arg(size);
@@ -117,7 +125,8 @@ void GalleryView::addTexture(const QString& filename, const QImage& thumbnail) {
     listWidget_->addItem(item);
     
     itemToFilename_[item] = filename;
-    itemToFileSize_[item] = fileInfo.size();
+    filenameToItem_.insert(filename, item);
+    itemToFileSize_[item] = size;
     itemToModDate_[item] = fileInfo.lastModified();
     
     // Hide placeholder when items exist
@@ -128,8 +137,31 @@ void GalleryView::addTexture(const QString& filename, const QImage& thumbnail) {
     countLabel_->setText(QString("%1").arg(listWidget_->count()));
 }
 
+void GalleryView::removeTexture(const QString& filename) {
+    QListWidgetItem* item = filenameToItem_.take(filename);
+    if (!item) {
+        return;
+    }
+    
+    itemToFilename_.remove(item);
+    itemToFileSize_.remove(item);
+    itemToDimensions_.remove(item);
+    itemToModDate_.remove(item);
+    groupedItems_.removeOne(item);
+    delete listWidget_->takeItem(listWidget_->row(item));
+    
+    if (listWidget_->count() == 0) {
+        placeholderLabel_->setVisible(true);
+        listWidget_->setVisible(false);
+    }
+    countLabel_->setText(QString("%1").arg(listWidget_->count()));
+}
+
 void GalleryView::clear() {
+    groupedItems_.clear();
+    clearGroupsButton_->setVisible(false);
     itemToFilename_.clear();
+    filenameToItem_.clear();
     itemToFileSize_.clear();
     itemToDimensions_.clear();
     itemToModDate_.clear();
@@ -160,6 +192,10 @@ int GalleryView::getVisibleCount() const {
     return count;
 }
 
+int GalleryView::getCount() const {
+    return listWidget_->count();
+}
+
 void GalleryView::onItemSelectionChanged() {
     QString filename = getCurrentFilename();
     if (!filename.isEmpty()) {
@@ -258,6 +294,9 @@ void GalleryView::toggleViewMode() {
 }
 
 void GalleryView::sortItems(int sortIndex) {
+    // Sorting recreates every item, which ends any grouped view; plain names first
+    ungroupItems();
+    
     listWidget_->setSortingEnabled(false);
     
     // Collect all items with their data
@@ -331,6 +370,7 @@ void GalleryView::sortItems(int sortIndex) {
     
     // Rebuild the list
     itemToFilename_.clear();
+    filenameToItem_.clear();
     itemToFileSize_.clear();
     itemToDimensions_.clear();
     itemToModDate_.clear();
@@ -341,6 +381,7 @@ void GalleryView::sortItems(int sortIndex) {
         item->setToolTip(data.tooltip);
         listWidget_->addItem(item);
         itemToFilename_[item] = data.filename;
+        filenameToItem_.insert(data.filename, item);
         itemToFileSize_[item] = data.fileSize;
         itemToDimensions_[item] = data.dimensions;
         itemToModDate_[item] = data.modDate;
@@ -377,11 +418,16 @@ void GalleryView::selectRandom() {
 }
 
 void GalleryView::setTextureDimensions(const QString& filename, int width, int height) {
-    for (auto it = itemToFilename_.begin(); it != itemToFilename_.end(); ++it) {
-        if (it.value() == filename) {
-            itemToDimensions_[it.key()] = static_cast<qint64>(width) * height;
-            return;
-        }
+    QListWidgetItem* item = filenameToItem_.value(filename);
+    if (item) {
+        itemToDimensions_[item] = static_cast<qint64>(width) * height;
+    }
+}
+
+void GalleryView::setThumbnail(const QString& filename, const QImage& thumbnail) {
+    QListWidgetItem* item = filenameToItem_.value(filename);
+    if (item) {
+        item->setIcon(QIcon(QPixmap::fromImage(thumbnail)));
     }
 }
 
@@ -418,3 +464,57 @@ void GalleryView::filterByDimension(int index) {
     }
     emit visibleCountChanged(vis);
 }
+
+void GalleryView::showGroups(const QList<QStringList>& groups, const QStringList& labels) {
+    clearGroups();
+    
+    // Grouped items move to the front in group order; everything after them is hidden
+    int row = 0;
+    for (int group = 0; group < groups.size(); ++group) {
+        QBrush background = (group % 2) ? QBrush(QColor(100, 140, 220, 50)) : QBrush();
+        for (const QString& filename : groups[group]) {
+            QListWidgetItem* item = filenameToItem_.value(filename);
+            if (!item) {
+                continue;
+            }
+            listWidget_->takeItem(listWidget_->row(item));
+            listWidget_->insertItem(row++, item);
+            item->setText(QString("%1\n%2").arg(QFileInfo(filename).fileName(), labels.value(group)));
+            item->setBackground(background);
+            item->setHidden(false);
+            groupedItems_.append(item);
+        }
+    }
+    for (int i = row; i < listWidget_->count(); ++i) {
+        listWidget_->item(i)->setHidden(true);
+    }
+    
+    clearGroupsButton_->setVisible(true);
+    listWidget_->scrollToTop();
+    countLabel_->setText(QString("%1/%2").arg(row).arg(listWidget_->count()));
+    emit visibleCountChanged(row);
+}
+
+void GalleryView::clearGroups() {
+    if (clearGroupsButton_->isHidden()) {
+        return;
+    }
+    
+    // Restores the names, the order and the search filter
+    sortItems(sortCombo_->currentIndex());
+}
+
+void GalleryView::ungroupItems() {
+    for (QListWidgetItem* item : groupedItems_) {
+        item->setText(QFileInfo(itemToFilename_.value(item)).fileName());
+        item->setBackground(QBrush());
+    }
+    groupedItems_.clear();
+    clearGroupsButton_->setVisible(false);
+}
+
+void GalleryView::addContextAction(QAction* action) {
+    // Right-clicking selects the item first, so actions apply to the current texture
+    listWidget_->setContextMenuPolicy(Qt::ActionsContextMenu);
+    listWidget_->addAction(action);
+}
@@ -3,6 +3,7 @@
 
 #include <QListWidget>
 #include <QMap>
+#include <QHash>
 #include <QLineEdit>
 #include <QVBoxLayout>
 #include <QComboBox>
@@ -17,10 +18,12 @@ class GalleryView : public QWidget {
 public:
     explicit GalleryView(QWidget* parent = nullptr);
     
-    void addTexture(const QString& filename, const QImage& thumbnail);
+    void addTexture(const QString& filename, const QImage& thumbnail, qint64 fileSize = -1);
+    void removeTexture(const QString& filename);
     void clear();
     QString getCurrentFilename() const;
     int getVisibleCount() const;
+    int getCount() const;
     void setThumbnailSize(int size);
     void selectNext();
     void selectPrevious();
@@ -31,6 +34,15 @@ public:
     void toggleViewMode();
     void selectRandom();
     void setTextureDimensions(const QString& filename, int width, int height);
+    void setThumbnail(const QString& filename, const QImage& thumbnail);
+    
+    // Show only the files of each group, group after group, each item tagged with its
+    // group's label; clearGroups() brings back the whole gallery in its sort order
+    void showGroups(const QList<QStringList>& groups, const QStringList& labels);
+    void clearGroups();
+    
+    // Offer an action in the right-click menu of the thumbnails
+    void addContextAction(QAction* action);
     
 signals:
     void textureSelected(const QString& filename);
@@ -50,13 +62,18 @@ private:
     QComboBox* sortCombo_;
     QComboBox* dimFilterCombo_;
     QPushButton* viewToggleButton_;
+    QPushButton* clearGroupsButton_;
     QMap<QListWidgetItem*, QString> itemToFilename_;
+    QHash<QString, QListWidgetItem*> filenameToItem_;
     QMap<QListWidgetItem*, qint64> itemToFileSize_;
     QMap<QListWidgetItem*, qint64> itemToDimensions_;  // stores width*height
     QMap<QListWidgetItem*, QDateTime> itemToModDate_;
+    QList<QListWidgetItem*> groupedItems_;  // items relabelled by showGroups
     QLabel* placeholderLabel_;
     QLabel* countLabel_;
     
+    void ungroupItems();
+    
 protected:
     bool eventFilter(QObject* obj, QEvent* event) override;
 };
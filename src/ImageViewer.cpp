@@ -21,13 +21,24 @@ ImageViewer::ImageViewer(QWidget* parent)
     scrollArea_->setWidget(imageLabel_);
     scrollArea_->setWidgetResizable(false);
     
+    compareView_ = new CompareView;
+    compareView_->hide();
+    connect(compareView_, &CompareView::zoomChanged, this, &ImageViewer::zoomChanged);
+    
     QVBoxLayout* layout = new QVBoxLayout(this);
     layout->setContentsMargins(0, 0, 0, 0);
     layout->addWidget(scrollArea_);
+    layout->addWidget(compareView_);
 }
 
 void ImageViewer::setImage(const QImage& image) {
+    setPreviewImage(image, image.size());
+}
+
+void ImageViewer::setPreviewImage(const QImage& image, const QSize& fullSize) {
+    stopComparing();
     currentImage_ = image;
+    logicalSize_ = fullSize;
     scaleFactor_ = 1.0;
     fitToWindowMode_ = false;
     rotation_ = 0;
@@ -35,19 +46,55 @@ void ImageViewer::setImage(const QImage& image) {
     emit zoomChanged(scaleFactor_, fitToWindowMode_);
 }
 
+void ImageViewer::refineImage(const QImage& image) {
+    if (currentImage_.isNull() || image.isNull()) {
+        return;
+    }
+    
+    // Keep zoom, rotation and scroll position; only the pixels get sharper
+    currentImage_ = image;
+    updateImage();
+}
+
 void ImageViewer::clear() {
+    stopComparing();
     currentImage_ = QImage();
+    logicalSize_ = QSize();
     imageLabel_->clear();
     rotation_ = 0;
 }
 
+void ImageViewer::compareImages(const QImage& a, const QString& labelA, const QImage& b, const QString& labelB) {
+    scrollArea_->hide();
+    compareView_->show();
+    compareView_->setImages(a, labelA, b, labelB);
+}
+
+void ImageViewer::setCompareMode(CompareView::Mode mode) {
+    compareView_->setMode(mode);
+}
+
+void ImageViewer::stopComparing() {
+    if (!isComparing()) {
+        return;
+    }
+    compareView_->clear();
+    compareView_->hide();
+    scrollArea_->show();
+    emit zoomChanged(scaleFactor_, fitToWindowMode_);
+}
+
 QImage ImageViewer::getRotatedImage() const {
-    if (rotation_ == 0) {
-        return currentImage_;
+    return applyRotation(currentImage_);
+}
+
+QImage ImageViewer::applyRotation(const QImage& image) const {
+    if (rotation_ == 0 || image.isNull()) {
+        return image;
     }
     QTransform transform;
     transform.rotate(rotation_);
-    return currentImage_.transformed(transform, Qt::SmoothTransformation);
+    return image.transformed(transform, Qt::SmoothTransformation);
 }
 
 void ImageViewer::updateImage() {
@@ -57,6 +104,12 @@ void ImageViewer::updateImage() {
     
     QImage displayImage = getRotatedImage();
     
+    // Lay out at the full texture size even while a smaller preview mip is shown
+    QSize fullSize = logicalSize_.isValid() ? logicalSize_ : currentImage_.size();
+    if (rotation_ == 90 || rotation_ == 270) {
+        fullSize.transpose();
+    }
+    
     if (fitToWindowMode_) {
         QSize availableSize = scrollArea_->viewport()->size();
         QPixmap pixmap = QPixmap::fromImage(displayImage);
@@ -65,7 +118,7 @@ void ImageViewer::updateImage() {
         imageLabel_->adjustSize();
     } else {
         QPixmap pixmap = QPixmap::fromImage(displayImage);
-        QSize scaledSize = pixmap.size() * scaleFactor_;
+        QSize scaledSize = fullSize * scaleFactor_;
         imageLabel_->setPixmap(pixmap.scaled(scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
         imageLabel_->adjustSize();
     }
@@ -80,14 +133,26 @@ void ImageViewer::scaleImage(double factor) {
 }
 
 void ImageViewer::zoomIn() {
+    if (isComparing()) {
+        compareView_->scaleBy(1.25);
+        return;
+    }
     scaleImage(1.25);
 }
 
 void ImageViewer::zoomOut() {
+    if (isComparing()) {
+        compareView_->scaleBy(0.8);
+        return;
+    }
     scaleImage(0.8);
 }
 
 void ImageViewer::resetZoom() {
+    if (isComparing()) {
+        compareView_->resetZoom();
+        return;
+    }
     scaleFactor_ = 1.0;
     fitToWindowMode_ = false;
     updateImage();
@@ -95,6 +160,10 @@ void ImageViewer::resetZoom() {
 }
 
 void ImageViewer::fitToWindow() {
+    if (isComparing()) {
+        compareView_->fitToWindow();
+        return;
+    }
     fitToWindowMode_ = true;
     updateImage();
     emit zoomChanged(scaleFactor_, fitToWindowMode_);
@@ -1,6 +1,7 @@
 #ifndef IMAGEVIEWER_H
 #define IMAGEVIEWER_H
 
+#include "CompareView.h"
 #include <QWidget>
 #include <QScrollArea>
 #include <QLabel>
@@ -14,10 +15,22 @@ public:
     explicit ImageViewer(QWidget* parent = nullptr);
     
     void setImage(const QImage& image);
+    
+    // Show a low-resolution stand-in laid out at fullSize, then swap in sharper
+    // versions with refineImage() without disturbing zoom, rotation or scrolling
+    void setPreviewImage(const QImage& image, const QSize& fullSize);
+    void refineImage(const QImage& image);
     void clear();
     double getScaleFactor() const { return scaleFactor_; }
     bool isFitToWindow() const { return fitToWindowMode_; }
     
+    // Swap the single image for A and B under one zoom and pan. Zoom slots drive the
+    // comparison until stopComparing() or the next setPreviewImage() or clear().
+    void compareImages(const QImage& a, const QString& labelA, const QImage& b, const QString& labelB);
+    void setCompareMode(CompareView::Mode mode);
+    void stopComparing();
+    bool isComparing() const { return !compareView_->isHidden(); }
+    
 public slots:
     void zoomIn();
     void zoomOut();
@@ -33,7 +46,9 @@ signals:
 private:
     QScrollArea* scrollArea_;
     QLabel* imageLabel_;
+    CompareView* compareView_;
     QImage currentImage_;
+    QSize logicalSize_;
     double scaleFactor_;
     bool fitToWindowMode_;
     bool checkerboardEnabled_;
@@ -46,6 +61,7 @@ private:
 
 public:
     QImage getRotatedImage() const;
+    QImage applyRotation(const QImage& image) const;
     
 protected:
     void resizeEvent(QResizeEvent* event) override;
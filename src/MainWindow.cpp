@@ -3,8 +3,25 @@
 #include "ImageViewer.h"
 #include "PropertiesPanel.h"
 #include "ExportDialog.h"
+#include "StatsDialog.h"
 #include "VTFReader.h"
 #include "VMTParser.h"
+#include "DecodeScheduler.h"
+#include "MaterialThumbnailer.h"
+#include "DirectoryWatcher.h"
+#include "DirectoryScanner.h"
+#include "BatchRunner.h"
+#include "TextureSource.h"
+#include "GameIndex.h"
+#include "MaterialDatabase.h"
+#include "TextureReferenceIndex.h"
+#include "TextureMetadataIndex.h"
+#include "DuplicateFinder.h"
+#include "SimilarityIndex.h"
+#include "TextureStatistics.h"
+#include "VTFValidator.h"
+#include "MipChainChecker.h"
+#include "ThreadPool.h"
 
 #include <QMenuBar>
 #include <QToolBar>
@@ -13,9 +30,10 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QProgressDialog>
+#include <QProgressBar>
+#include <QToolButton>
 #include <QDir>
 #include <QFileInfo>
-#include <QDirIterator>
 #include <QApplication>
 #include <QScreen>
 #include <QStyle>
@@ -30,13 +48,22 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QElapsedTimer>
+#include <QTimer>
+#include <QSignalBlocker>
+#include <QInputDialog>
+#include <QSet>
+#include <QActionGroup>
+#include <algorithm>
 #include <cmath>
 
 MainWindow::MainWindow(QWidget* parent) 
     : QMainWindow(parent), currentVTF_(nullptr), currentVMT_(nullptr), 
       checkerboardEnabled_(false), recursiveScan_(false), thumbnailSize_(128),
       lastExportPath_(QString()), autoFitOnSelect_(false),
-      currentMipLevel_(0) {
+      currentMipLevel_(0), scanQueueScheduled_(false), scanTextureCount_(0), fitOnPreview_(false),
+      directoryMaterialsStale_(false),
+      textureReferences_(std::make_unique<VTFLib::TextureReferenceIndex>()),
+      similarityIndex_(std::make_unique<VTFLib::SimilarityIndex>()) {
     
     // Enable drag and drop
     setAcceptDrops(true);
@@ -59,6 +86,12 @@ MainWindow::MainWindow(QWidget* parent)
     
     galleryView_ = new GalleryView;
     imageViewer_ = new ImageViewer;
+    decodeScheduler_ = new DecodeScheduler(this);
+    materialThumbnailer_ = new MaterialThumbnailer(this);
+    directoryWatcher_ = new DirectoryWatcher(this);
+    directoryScanner_ = new DirectoryScanner(this);
+    batchRunner_ = new BatchRunner(this);
+    materialPlaceholder_ = style()->standardIcon(QStyle::SP_FileIcon).pixmap(128, 128).toImage();
     
     mainSplitter_->addWidget(galleryView_);
     mainSplitter_->addWidget(imageViewer_);
@@ -80,6 +113,29 @@ MainWindow::MainWindow(QWidget* parent)
     connect(galleryView_, &GalleryView::textureDoubleClicked,
             this, &MainWindow::onTextureDoubleClicked);
     
+    // Background loads and progressive decodes for the texture on screen
+    connect(decodeScheduler_, &DecodeScheduler::fileLoaded,
+            this, &MainWindow::onTextureFileLoaded);
+    connect(decodeScheduler_, &DecodeScheduler::previewReady,
+            this, &MainWindow::onPreviewReady);
+    connect(decodeScheduler_, &DecodeScheduler::imageRefined,
+            imageViewer_, &ImageViewer::refineImage);
+    connect(materialThumbnailer_, &MaterialThumbnailer::thumbnailReady, this,
+            [this](const QString& material, const QImage& thumbnail, int width, int height) {
+                galleryView_->setThumbnail(material, thumbnail);
+                galleryView_->setTextureDimensions(material, width, height);
+            });
+    connect(directoryWatcher_, &DirectoryWatcher::filesChanged, this, &MainWindow::applyDirectoryChanges);
+    connect(directoryScanner_, &DirectoryScanner::filesFound, this, &MainWindow::onScanFilesFound);
+    connect(directoryScanner_, &DirectoryScanner::finished, this, &MainWindow::onScanFinished);
+    connect(directoryScanner_, &DirectoryScanner::metadataReady, this, &MainWindow::onMetadataReady);
+    connect(directoryScanner_, &DirectoryScanner::gameIndexed, this, &MainWindow::onGameIndexed);
+    connect(batchRunner_, &BatchRunner::progress, this, &MainWindow::onBatchProgress);
+    connect(batchRunner_, &BatchRunner::stopped, this, [this]() {
+        batchProgressBar_->hide();
+        batchCancelButton_->hide();
+    });
+    
     // Connect zoom display
     connect(imageViewer_, &ImageViewer::zoomChanged,
             this, &MainWindow::updateZoomDisplay);
@@ -100,6 +156,11 @@ void MainWindow::createActions() {
     openDirAction_->setStatusTip("Open a directory containing VTF/VMT files");
     connect(openDirAction_, &QAction::triggered, this, &MainWindow::openDirectory);
     
+    openGameInstallAction_ = new QAction("Open &Game Install...", this);
+    openGameInstallAction_->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_G));
+    openGameInstallAction_->setStatusTip("Index a game's gameinfo.txt search paths to resolve material textures");
+    connect(openGameInstallAction_, &QAction::triggered, this, &MainWindow::openGameInstall);
+    
     exportCurrentAction_ = new QAction("&Export Current...", this);
     exportCurrentAction_->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_E));
     exportCurrentAction_->setStatusTip("Export the currently selected texture");
@@ -256,6 +317,63 @@ void MainWindow::createActions() {
     directoryStatsAction_->setStatusTip("Show statistics about the loaded directory");
     connect(directoryStatsAction_, &QAction::triggered, this, &MainWindow::showDirectoryStats);
     
+    findMaterialsAction_ = new QAction("Find &Materials...", this);
+    findMaterialsAction_->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_M));
+    findMaterialsAction_->setStatusTip("List the shaders in use, or the materials using a shader or parameter");
+    connect(findMaterialsAction_, &QAction::triggered, this, &MainWindow::findMaterials);
+    
+    textureReferenceReportAction_ = new QAction("Texture &Reference Report...", this);
+    textureReferenceReportAction_->setStatusTip("List materials with missing textures and textures no material uses");
+    connect(textureReferenceReportAction_, &QAction::triggered, this, &MainWindow::showTextureReferenceReport);
+    
+    findDuplicatesAction_ = new QAction("Find &Duplicates", this);
+    findDuplicatesAction_->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_U));
+    findDuplicatesAction_->setStatusTip("Group textures whose image data is identical");
+    connect(findDuplicatesAction_, &QAction::triggered, this, &MainWindow::findDuplicates);
+    
+    findSimilarAction_ = new QAction("Find S&imilar", this);
+    findSimilarAction_->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_I));
+    findSimilarAction_->setStatusTip("Show the textures that look most like the selected one");
+    connect(findSimilarAction_, &QAction::triggered, this, &MainWindow::findSimilar);
+    
+    validateTexturesAction_ = new QAction("&Validate Textures...", this);
+    validateTexturesAction_->setStatusTip("Check textures and archive entries for truncation, bad headers and CRC mismatches");
+    connect(validateTexturesAction_, &QAction::triggered, this, &MainWindow::validateTextures);
+    
+    checkMipChainsAction_ = new QAction("Check &Mip Chains", this);
+    checkMipChainsAction_->setStatusTip("Show the textures whose mips don't look like a downsample of the mip above");
+    connect(checkMipChainsAction_, &QAction::triggered, this, &MainWindow::checkMipChains);
+    
+    compareWithFileAction_ = new QAction("Compare &With...", this);
+    compareWithFileAction_->setStatusTip("Compare the current texture with another VTF under one zoom and pan");
+    connect(compareWithFileAction_, &QAction::triggered, this, &MainWindow::compareWithFile);
+    
+    compareWithNextMipAction_ = new QAction("Compare With &Next Mip", this);
+    compareWithNextMipAction_->setStatusTip("Compare the current mip with the one below it, scaled up");
+    connect(compareWithNextMipAction_, &QAction::triggered, this, &MainWindow::compareWithNextMip);
+    
+    // The mode is kept between comparisons
+    compareSideBySideAction_ = new QAction("&Side by Side", this);
+    compareSideBySideAction_->setStatusTip("Show both images next to each other");
+    compareSideBySideAction_->setData(CompareView::SideBySide);
+    compareSwipeAction_ = new QAction("S&wipe", this);
+    compareSwipeAction_->setStatusTip("Show one image on each side of a divider dragged with the left mouse button");
+    compareSwipeAction_->setData(CompareView::Swipe);
+    compareDifferenceAction_ = new QAction("&Difference", this);
+    compareDifferenceAction_->setStatusTip("Show the amplified per-channel difference of the two images");
+    compareDifferenceAction_->setData(CompareView::Difference);
+    compareModeGroup_ = new QActionGroup(this);
+    for (QAction* action : {compareSideBySideAction_, compareSwipeAction_, compareDifferenceAction_}) {
+        action->setCheckable(true);
+        compareModeGroup_->addAction(action);
+    }
+    compareSideBySideAction_->setChecked(true);
+    connect(compareModeGroup_, &QActionGroup::triggered, this, &MainWindow::setCompareMode);
+    
+    stopComparingAction_ = new QAction("Sto&p Comparing", this);
+    stopComparingAction_->setStatusTip("Go back to the single texture view (Esc)");
+    connect(stopComparingAction_, &QAction::triggered, this, &MainWindow::stopComparing);
+    
     saveCurrentViewAction_ = new QAction("&Save Current View...", this);
     saveCurrentViewAction_->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_S));
     saveCurrentViewAction_->setStatusTip("Save the current view (with rotation) as PNG");
@@ -275,6 +393,7 @@ void MainWindow::createActions() {
 void MainWindow::createMenus() {
     QMenu* fileMenu = menuBar()->addMenu("&File");
     fileMenu->addAction(openDirAction_);
+    fileMenu->addAction(openGameInstallAction_);
     fileMenu->addAction(reopenLastDirAction_);
     fileMenu->addAction(reloadAction_);
     fileMenu->addAction(reloadCurrentTextureAction_);
@@ -292,8 +411,16 @@ void MainWindow::createMenus() {
     fileMenu->addAction(closeCurrentAction_);
     fileMenu->addSeparator();
     fileMenu->addAction(directoryStatsAction_);
+    fileMenu->addAction(findMaterialsAction_);
+    fileMenu->addAction(textureReferenceReportAction_);
+    fileMenu->addAction(findDuplicatesAction_);
+    fileMenu->addAction(findSimilarAction_);
+    fileMenu->addAction(validateTexturesAction_);
+    fileMenu->addAction(checkMipChainsAction_);
     fileMenu->addAction(exitAction_);
     
+    galleryView_->addContextAction(findSimilarAction_);
+    
     QMenu* editMenu = menuBar()->addMenu("&Edit");
     editMenu->addAction(copyToClipboardAction_);
     editMenu->addAction(copyFilePathAction_);
@@ -316,6 +443,14 @@ void MainWindow::createMenus() {
     viewMenu->addAction(rotateCWAction_);
     viewMenu->addAction(rotateCCWAction_);
     viewMenu->addSeparator();
+    QMenu* compareMenu = viewMenu->addMenu("Co&mpare");
+    compareMenu->addAction(compareWithFileAction_);
+    compareMenu->addAction(compareWithNextMipAction_);
+    compareMenu->addSeparator();
+    compareMenu->addActions(compareModeGroup_->actions());
+    compareMenu->addSeparator();
+    compareMenu->addAction(stopComparingAction_);
+    viewMenu->addSeparator();
     viewMenu->addAction(nextTextureAction_);
     viewMenu->addAction(prevTextureAction_);
     viewMenu->addAction(firstTextureAction_);
@@ -370,12 +505,12 @@ void MainWindow::createToolBar() {
     connect(mipmapSpinBox_, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int level) {
         currentMipLevel_ = level;
         QString currentFile = galleryView_->getCurrentFilename();
-        if (!currentFile.isEmpty() && currentVTF_) {
-            QImage image = currentVTF_->getImage(level);
-            if (!image.isNull()) {
-                imageViewer_->setImage(image);
-                statusBar()->showMessage(QString("🔎 Mip level %1 (%2×%3)").arg(level).arg(image.width()).arg(image.height()), 2000);
-            }
+        if (!currentFile.isEmpty() && currentVTF_ && currentVTF_->isLoaded()) {
+            decodeScheduler_->requestMipmap(currentVTF_->getFile(), level);
+            statusBar()->showMessage(QString("🔎 Mip level %1 (%2×%3)")
+                .arg(level)
+                .arg(std::max(1, currentVTF_->getWidth() >> level))
+                .arg(std::max(1, currentVTF_->getHeight() >> level)), 2000);
         }
     });
     toolBar->addWidget(mipmapSpinBox_);
@@ -412,11 +547,24 @@ void MainWindow::createStatusBar() {
     alphaLabel_->setFrameStyle(QFrame::StyledPanel | QFrame::Sunken);
     statusBar()->addPermanentWidget(alphaLabel_);
     
+    batchProgressBar_ = new QProgressBar;
+    batchProgressBar_->setMaximumWidth(160);
+    batchProgressBar_->hide();
+    statusBar()->addPermanentWidget(batchProgressBar_);
+    
+    batchCancelButton_ = new QToolButton;
+    batchCancelButton_->setText("Cancel");
+    batchCancelButton_->setToolTip("Stop the running check (Esc)");
+    batchCancelButton_->hide();
+    connect(batchCancelButton_, &QToolButton::clicked, this, &MainWindow::cancelBatch);
+    statusBar()->addPermanentWidget(batchCancelButton_);
+    
     statusBar()->showMessage("Ready");
 }
 
 void MainWindow::createDockWidgets() {
     propertiesPanel_ = new PropertiesPanel;
+    connect(propertiesPanel_, &PropertiesPanel::mipChainCheckRequested, this, &MainWindow::checkMipChain);
     
     propertiesDock_ = new QDockWidget("Properties", this);
     propertiesDock_->setObjectName("PropertiesDock");
@@ -433,143 +581,381 @@ void MainWindow::openDirectory() {
     }
 }
 
+void MainWindow::openGameInstall() {
+    QString gameInfo = QFileDialog::getOpenFileName(this, "Open Game Install", currentDirectory_,
+                                                    "Game Info (gameinfo.txt);;All Files (*)");
+    if (gameInfo.isEmpty()) {
+        return;
+    }
+    
+    // Only gameinfo.txt is read here; walking the search paths can take seconds on a
+    // real install, so that, the materials and the texture headers are all read in the
+    // background (see onGameIndexed)
+    auto index = std::make_shared<VTFLib::GameIndex>();
+    if (!index->LoadSearchPaths(gameInfo.toStdString())) {
+        QMessageBox::warning(this, "Open Game Install",
+                             "Could not read the search paths from this gameinfo.txt.");
+        return;
+    }
+    
+    TextureSource::shared().setGameIndex(nullptr);
+    gameMaterials_.reset();
+    gameMetadata_.reset();
+    rebuildTextureReferences();
+    
+    statusBar()->showMessage(QString("🎮 Indexing %1 search paths of %2...")
+        .arg(index->GetSearchPaths().size())
+        .arg(QString::fromStdString(index->GetGameName())));
+    directoryScanner_->indexGame(index, gameInfo);
+}
+
+void MainWindow::onGameIndexed(std::shared_ptr<const VTFLib::GameIndex> game,
+                               std::shared_ptr<const VTFLib::MaterialDatabase> materials,
+                               std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata, qint64 elapsedMs) {
+    TextureSource::shared().setGameIndex(game);
+    gameMaterials_ = materials;
+    gameMetadata_ = metadata;
+    rebuildTextureReferences();
+    
+    statusBar()->showMessage(QString("🎮 Indexed %1 files, %2 materials and %3 texture headers of %4 in %5s")
+        .arg(game->GetFileCount())
+        .arg(gameMaterials_ ? gameMaterials_->GetMaterialCount() : 0)
+        .arg(gameMetadata_->GetCount())
+        .arg(QString::fromStdString(game->GetGameName()))
+        .arg(elapsedMs / 1000.0, 0, 'f', 1), 5000);
+}
+
+void MainWindow::onBatchProgress(const QString& label, quint64 done, quint64 total) {
+    batchProgressBar_->show();
+    batchCancelButton_->show();
+    
+    // Totals grow as a batch discovers work, so an empty one shows as busy
+    if (total == 0) {
+        batchProgressBar_->setRange(0, 0);
+        statusBar()->showMessage(QString("⏳ %1...").arg(label));
+        return;
+    }
+    batchProgressBar_->setRange(0, 1000);
+    batchProgressBar_->setValue(static_cast<int>(std::min(done, total) * 1000 / total));
+    statusBar()->showMessage(QString("⏳ %1... %2 of %3").arg(label).arg(std::min(done, total)).arg(total));
+}
+
+void MainWindow::cancelBatch() {
+    if (batchRunner_->isRunning()) {
+        batchRunner_->cancel();
+        statusBar()->showMessage("⏹ Cancelled", 3000);
+    }
+}
+
 void MainWindow::loadDirectory(const QString& path) {
     currentDirectory_ = path;
     galleryView_->clear();
     loadedTextures_.clear();
+    materialThumbnailer_->clear();
+    directoryWatcher_->stop();
+    batchRunner_->cancel();
+    
+    TextureSource::shared().unmountAll();
+    
+    directoryTextures_.clear();
+    directoryMaterialFiles_.clear();
+    directoryMetadata_.reset();
+    similarityIndex_->Clear();
+    scanQueue_.clear();
+    scanTextureCount_ = 0;
+    loadTimer_.start();
     
-    QDir dir(path);
-    QStringList filters;
-    filters << "*.vtf" << "*.vmt";
+    // Found files stream in from the scanner and are loaded as they arrive
+    directoryScanner_->scan(path, { ".vtf", ".vmt", "_dir.vpk", ".zip", ".bsp" }, recursiveScan_);
+    statusBar()->showMessage(QString("🔍 Scanning %1...").arg(QFileInfo(path).fileName()));
     
-    QFileInfoList files;
-    if (recursiveScan_) {
-        QDirIterator it(path, filters, QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            it.next();
-            files.append(it.fileInfo());
+    // Add to recent directories
+    addToRecentDirectories(path);
+}
+
+void MainWindow::onScanFilesFound(const QStringList& files) {
+    scanQueue_.append(files);
+    if (!scanQueueScheduled_) {
+        scanQueueScheduled_ = true;
+        QTimer::singleShot(0, this, &MainWindow::processScanQueue);
+    }
+}
+
+void MainWindow::processScanQueue() {
+    scanQueueScheduled_ = false;
+    
+    // Load in short slices so the window stays responsive while the scan goes on
+    QElapsedTimer slice;
+    slice.start();
+    int loaded = 0;
+    while (loaded < scanQueue_.size() && slice.elapsed() < SCAN_LOAD_SLICE_MS) {
+        const QString filename = scanQueue_.at(loaded++);
+        
+        if (TextureSource::isArchiveFile(QFileInfo(filename).fileName())) {
+            // Loose textures plus the contents of any VPKs, zips and map pakfiles, as virtual paths
+            if (TextureSource::shared().mountArchive(filename)) {
+                scanQueue_.append(TextureSource::shared().archiveTextures(filename));
+            }
+        } else if (filename.endsWith(".vtf", Qt::CaseInsensitive)) {
+            directoryTextures_ << filename;
+            if (thumbnailTexture(filename, true)) {
+                scanTextureCount_++;
+            }
+        } else if (filename.endsWith(".vmt", Qt::CaseInsensitive)) {
+            // Listed right away; the base texture's thumbnail replaces the icon once resolved
+            directoryMaterialFiles_ << filename;
+            galleryView_->addTexture(filename, materialPlaceholder_);
         }
+    }
+    scanQueue_.erase(scanQueue_.begin(), scanQueue_.begin() + loaded);
+    
+    // Show the first texture as soon as there is one
+    if (galleryView_->getCurrentFilename().isEmpty() && galleryView_->getCount() > 0) {
+        galleryView_->selectFirst();
+    }
+    updateTextureCount();
+    
+    if (!scanQueue_.isEmpty()) {
+        scanQueueScheduled_ = true;
+        QTimer::singleShot(0, this, &MainWindow::processScanQueue);
+    } else if (!directoryScanner_->isScanning()) {
+        finishDirectoryLoad();
     } else {
-        files = dir.entryInfoList(filters, QDir::Files);
+        statusBar()->showMessage(QString("🔍 Scanning %1... %2 textures loaded")
+            .arg(QFileInfo(currentDirectory_).fileName()).arg(scanTextureCount_));
+    }
+}
+
+void MainWindow::onScanFinished(int fileCount, qint64 elapsedMs) {
+    Q_UNUSED(fileCount);
+    Q_UNUSED(elapsedMs);
+    
+    // Files still queued are finished off by processScanQueue
+    if (!scanQueueScheduled_ && scanQueue_.isEmpty()) {
+        finishDirectoryLoad();
     }
+}
+
+void MainWindow::onMetadataReady(std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata) {
+    directoryMetadata_ = metadata;
+    
+    // Dimensions for every texture, including those whose thumbnail is still pending
+    for (const QString& filename : directoryTextures_) {
+        size_t row = metadata->Find(filename.toStdString());
+        if (row != VTFLib::TextureMetadataIndex::NOT_FOUND) {
+            VTFLib::TextureMetadata texture = metadata->GetMetadata(row);
+            if (texture.IsValid()) {
+                galleryView_->setTextureDimensions(filename, texture.width, texture.height);
+            }
+        }
+    }
+}
+
+void MainWindow::finishDirectoryLoad() {
+    const QString& path = currentDirectory_;
+    
+    // Materials and references need the complete file list
+    rebuildDirectoryMaterials();
+    rebuildTextureReferences();
+    
+    // Later edits to the tree are applied as deltas rather than by reloading
+    directoryWatcher_->watch(path, { "*.vtf", "*.vmt", "*_dir.vpk", "*.zip", "*.bsp" }, recursiveScan_);
     
-    if (files.isEmpty()) {
+    if (galleryView_->getCount() == 0) {
+        statusBar()->clearMessage();
         QMessageBox::information(this, "No Files Found",
                                "No VTF or VMT files found in the selected directory.");
         return;
     }
     
-    QProgressDialog progress("Loading textures...", "Cancel", 0, files.size(), this);
-    progress.setWindowModality(Qt::WindowModal);
+    // Materials resolve off the UI thread, reusing the texture thumbnails made above
+    materialThumbnailer_->request(directoryMaterialFiles_, 128);
     
-    QElapsedTimer loadTimer;
-    loadTimer.start();
+    double elapsed = loadTimer_.elapsed() / 1000.0;
+    statusBar()->showMessage(QString("✅ Loaded %1 textures and %2 materials from %3 in %4s")
+        .arg(scanTextureCount_).arg(directoryMaterialFiles_.size()).arg(QFileInfo(path).fileName()).arg(elapsed, 0, 'f', 1));
+    updateTextureCount();
     
-    int count = 0;
-    for (const QFileInfo& fileInfo : files) {
-        if (progress.wasCanceled()) {
-            break;
+    // Update title bar with directory info
+    setWindowTitle(QString("%1 (%2 textures) — VTF-Viewer").arg(QFileInfo(path).fileName()).arg(scanTextureCount_));
+}
+
+bool MainWindow::thumbnailTexture(const QString& filename, bool addToGallery) {
+    VTFReader reader;
+    if (!reader.loadFile(filename)) {
+        return false;
+    }
+    QImage thumbnail = reader.getThumbnail(128);
+    if (thumbnail.isNull()) {
+        return false;
+    }
+    
+    // Described from a small mip while the file is loaded anyway
+    VTFLib::PerceptualDescriptor descriptor;
+    if (VTFLib::SimilarityIndex::Describe(*reader.getFile(), descriptor)) {
+        similarityIndex_->Set(filename.toStdString(), descriptor);
+    }
+    
+    if (addToGallery) {
+        galleryView_->addTexture(filename, thumbnail, TextureSource::shared().textureSize(filename));
+        loadedTextures_[QFileInfo(filename).fileName()] = filename;
+    } else {
+        galleryView_->setThumbnail(filename, thumbnail);
+    }
+    galleryView_->setTextureDimensions(filename, reader.getWidth(), reader.getHeight());
+    materialThumbnailer_->addTextureThumbnail(filename, thumbnail, reader.getWidth(), reader.getHeight());
+    return true;
+}
+
+void MainWindow::rebuildDirectoryMaterials() {
+    // One parallel pass over the materials; queries then run against the table
+    std::vector<std::string> materials;
+    materials.reserve(directoryMaterialFiles_.size());
+    for (const QString& filename : directoryMaterialFiles_) {
+        materials.push_back(filename.toStdString());
+    }
+    directoryMaterials_ = VTFLib::MaterialDatabase::Open(materials);
+    directoryMaterialsStale_ = false;
+}
+
+void MainWindow::ensureDirectoryMaterials() {
+    if (directoryMaterialsStale_) {
+        rebuildDirectoryMaterials();
+    }
+}
+
+void MainWindow::applyDirectoryChanges(const QStringList& added, const QStringList& modified,
+                                       const QStringList& removed) {
+    // Archive contents are listed when mounted, so a changed archive needs a full reload
+    for (const QStringList* files : { &added, &modified, &removed }) {
+        for (const QString& filename : *files) {
+            if (TextureSource::isArchiveFile(QFileInfo(filename).fileName())) {
+                reloadDirectory();
+                return;
+            }
         }
-        
-        QString filename = fileInfo.absoluteFilePath();
-        
-        if (fileInfo.suffix().toLower() == "vtf") {
-            VTFReader reader;
-            if (reader.loadFile(filename)) {
-                QImage thumbnail = reader.getThumbnail(128);
-                if (!thumbnail.isNull()) {
-                    galleryView_->addTexture(filename, thumbnail);
-                    galleryView_->setTextureDimensions(filename, reader.getWidth(), reader.getHeight());
-                    loadedTextures_[fileInfo.fileName()] = filename;
-                    count++;
+    }
+    
+    QString currentFile = galleryView_->getCurrentFilename();
+    QStringList staleMaterials;
+    bool materialsChanged = false;
+    bool texturesChanged = false;
+    
+    for (const QString& filename : removed) {
+        galleryView_->removeTexture(filename);
+        if (filename.endsWith(".vtf", Qt::CaseInsensitive)) {
+            QString name = QFileInfo(filename).fileName();
+            if (loadedTextures_.value(name) == filename) {
+                loadedTextures_.remove(name);
+            }
+            directoryTextures_.removeOne(filename);
+            materialThumbnailer_->removeTextureThumbnail(filename);
+            similarityIndex_->Remove(filename.toStdString());
+            textureReferences_->RemoveTexture(textureReferencePath(filename));
+            texturesChanged = true;
+        } else {
+            directoryMaterialFiles_.removeOne(filename);
+            textureReferences_->RemoveMaterial(filename.toStdString());
+            materialsChanged = true;
+        }
+    }
+    
+    // Only the files that changed are decoded or parsed again
+    for (const QStringList* files : { &added, &modified }) {
+        bool isNew = files == &added;
+        for (const QString& filename : *files) {
+            if (filename.endsWith(".vtf", Qt::CaseInsensitive)) {
+                if (isNew) {
+                    directoryTextures_ << filename;
+                    textureReferences_->AddTexture(textureReferencePath(filename));
+                }
+                thumbnailTexture(filename, isNew);
+                texturesChanged = true;
+                
+                // Materials showing this texture pick up the new thumbnail from the cache
+                for (const std::string& material : textureReferences_->GetMaterialsUsing(textureReferencePath(filename))) {
+                    staleMaterials << QString::fromStdString(material);
+                }
+            } else {
+                if (isNew) {
+                    galleryView_->addTexture(filename, materialPlaceholder_);
+                    directoryMaterialFiles_ << filename;
+                }
+                VMTParser parser;
+                std::vector<std::string> textures;
+                if (parser.loadFile(filename)) {
+                    for (const QString& texture : parser.getTextureReferences()) {
+                        textures.push_back(texture.toStdString());
+                    }
                 }
+                textureReferences_->SetMaterial(filename.toStdString(), textures);
+                staleMaterials << filename;
+                materialsChanged = true;
             }
         }
-        
-        progress.setValue(progress.value() + 1);
-        QApplication::processEvents();
     }
     
-    double elapsed = loadTimer.elapsed() / 1000.0;
-    statusBar()->showMessage(QString("✅ Loaded %1 textures from %2 in %3s")
-        .arg(count).arg(QFileInfo(path).fileName()).arg(elapsed, 0, 'f', 1));
-    updateTextureCount();
+    // The references were updated per material above; the table behind Find Materials is
+    // rebuilt once, the next time it is needed, however many edits arrive before then
+    if (materialsChanged) {
+        directoryMaterialsStale_ = true;
+    }
     
-    // Update title bar with directory info
-    setWindowTitle(QString("%1 (%2 textures) — VTF-Viewer").arg(QFileInfo(path).fileName()).arg(count));
+    // Statistics, the VRAM budget and duplicate bucketing read the metadata index; only
+    // the changed headers are read again, in the background (see onMetadataReady)
+    if (texturesChanged) {
+        directoryScanner_->refreshMetadata(directoryTextures_);
+    }
     
-    // Auto-select first texture for immediate preview
-    if (count > 0) {
-        galleryView_->selectFirst();
+    // Only materials in the gallery get thumbnails
+    QStringList refresh;
+    for (const QString& material : staleMaterials) {
+        if (directoryMaterialFiles_.contains(material) && !refresh.contains(material)) {
+            refresh << material;
+        }
     }
+    materialThumbnailer_->request(refresh, 128);
     
-    // Add to recent directories
-    addToRecentDirectories(path);
+    if (removed.contains(currentFile)) {
+        closeCurrent();
+    } else if (modified.contains(currentFile)) {
+        loadTexture(currentFile);
+    }
+    
+    updateTextureCount();
+    statusBar()->showMessage(QString("👀 %1 added, %2 modified, %3 removed")
+        .arg(added.size()).arg(modified.size()).arg(removed.size()), 3000);
 }
 
 void MainWindow::onTextureSelected(const QString& filename) {
     loadTexture(filename);
     if (autoFitOnSelect_) {
         fitToWindow();
+        fitOnPreview_ = true;
     }
 }
 
 void MainWindow::onTextureDoubleClicked(const QString& filename) {
     loadTexture(filename);
     fitToWindow();
+    fitOnPreview_ = true;
 }
 
 void MainWindow::loadTexture(const QString& filename) {
     QFileInfo fileInfo(filename);
     
-    // Clean up previous readers
+    // Clean up previous readers and drop anything still loading for them, even when
+    // this texture (a VMT without a base texture) requests nothing new
+    decodeScheduler_->cancel();
     delete currentVTF_;
     delete currentVMT_;
     currentVTF_ = nullptr;
     currentVMT_ = nullptr;
+    fitOnPreview_ = false;
     
     if (fileInfo.suffix().toLower() == "vtf") {
-        currentVTF_ = new VTFReader;
-        if (currentVTF_->loadFile(filename)) {
-            QImage image = currentVTF_->getImage();
-            imageViewer_->setImage(image);
-            
-            propertiesPanel_->setVTFProperties(
-                filename,
-                currentVTF_->getWidth(),
-                currentVTF_->getHeight(),
-                currentVTF_->getFormat(),
-                currentVTF_->getFrameCount(),
-                currentVTF_->getMipmapCount(),
-                currentVTF_->getFlags()
-            );
-            
-            statusBar()->showMessage(QString("Loaded: %1 (%2x%3, %4)")
-                .arg(fileInfo.fileName())
-                .arg(currentVTF_->getWidth())
-                .arg(currentVTF_->getHeight())
-                .arg(currentVTF_->getFormat()));
-            
-            // Update title bar with current file
-            setWindowTitle(QString("%1 — VTF-Viewer").arg(fileInfo.fileName()));
-            
-            // Update dimensions in status bar
-            imageDimensionsLabel_->setText(QString("%1×%2").arg(currentVTF_->getWidth()).arg(currentVTF_->getHeight()));
-            
-            // Update format indicator
-            formatLabel_->setText(currentVTF_->getFormat());
-            
-            // Update mipmap selector range
-            mipmapSpinBox_->setMaximum(std::max(0, currentVTF_->getMipmapCount() - 1));
-            mipmapSpinBox_->setValue(0);
-            currentMipLevel_ = 0;
-            
-            // Update alpha channel indicator
-            QString fmt = currentVTF_->getFormat();
-            bool hasAlpha = fmt.contains('A') || fmt.contains("alpha", Qt::CaseInsensitive);
-            alphaLabel_->setText(hasAlpha ? "α" : "");
-            alphaLabel_->setToolTip(hasAlpha ? "Has alpha channel" : "No alpha channel");
-        }
+        // Loaded and decoded in the background; see onTextureFileLoaded
+        decodeScheduler_->requestFile(filename);
     } else if (fileInfo.suffix().toLower() == "vmt") {
         currentVMT_ = new VMTParser;
         if (currentVMT_->loadFile(filename)) {
@@ -578,19 +964,17 @@ void MainWindow::loadTexture(const QString& filename) {
                 currentVMT_->getAllParameters()
             );
             
-            // Try to load the base texture
-            QString baseTexture = currentVMT_->getBaseTexture();
-            if (!baseTexture.isEmpty()) {
-                QString vtfPath = fileInfo.absolutePath() + "/" + baseTexture + ".vtf";
-                QFileInfo vtfInfo(vtfPath);
-                
-                if (vtfInfo.exists()) {
-                    currentVTF_ = new VTFReader;
-                    if (currentVTF_->loadFile(vtfPath)) {
-                        QImage image = currentVTF_->getImage();
-                        imageViewer_->setImage(image);
-                    }
-                }
+            // Pick up edits to the material since the directory was scanned
+            std::vector<std::string> textures;
+            for (const QString& texture : currentVMT_->getTextureReferences()) {
+                textures.push_back(texture.toStdString());
+            }
+            textureReferences_->SetMaterial(filename.toStdString(), textures);
+            
+            // Try to load the base texture, from the game install first
+            QString vtfPath = TextureSource::shared().resolveMaterialTexture(filename, currentVMT_->getBaseTexture());
+            if (!vtfPath.isEmpty()) {
+                decodeScheduler_->requestFile(vtfPath);
             }
             
             statusBar()->showMessage(QString("Loaded VMT: %1 (Shader: %2)")
@@ -606,6 +990,76 @@ void MainWindow::loadTexture(const QString& filename) {
     }
 }
 
+void MainWindow::onTextureFileLoaded(const QString& filename, std::shared_ptr<const VTFLib::VTFFile> file) {
+    QFileInfo fileInfo(filename);
+    
+    delete currentVTF_;
+    currentVTF_ = nullptr;
+    if (!file) {
+        statusBar()->showMessage(QString("⚠️ Could not load %1").arg(fileInfo.fileName()), 2000);
+        return;
+    }
+    currentVTF_ = new VTFReader(std::move(file));
+    
+    // A material's base texture only provides the image; the VMT owns the panel
+    if (currentVMT_) {
+        return;
+    }
+    
+    propertiesPanel_->setVTFProperties(
+        filename,
+        currentVTF_->getWidth(),
+        currentVTF_->getHeight(),
+        currentVTF_->getFormat(),
+        currentVTF_->getFrameCount(),
+        currentVTF_->getMipmapCount(),
+        currentVTF_->getFlags(),
+        currentVTF_->getVRAMSize()
+    );
+    
+    QStringList materials;
+    for (const std::string& material : textureReferences_->GetMaterialsUsing(textureReferencePath(filename))) {
+        materials << QString::fromStdString(material);
+    }
+    propertiesPanel_->setReferencingMaterials(materials);
+    
+    statusBar()->showMessage(QString("Loaded: %1 (%2x%3, %4)")
+        .arg(fileInfo.fileName())
+        .arg(currentVTF_->getWidth())
+        .arg(currentVTF_->getHeight())
+        .arg(currentVTF_->getFormat()));
+    
+    // Update title bar with current file
+    setWindowTitle(QString("%1 — VTF-Viewer").arg(fileInfo.fileName()));
+    
+    // Update dimensions in status bar
+    imageDimensionsLabel_->setText(QString("%1×%2").arg(currentVTF_->getWidth()).arg(currentVTF_->getHeight()));
+    
+    // Update format indicator
+    formatLabel_->setText(currentVTF_->getFormat());
+    
+    // Update mipmap selector range
+    // (without re-requesting mip 0, which the scheduler is already decoding)
+    QSignalBlocker blocker(mipmapSpinBox_);
+    mipmapSpinBox_->setMaximum(std::max(0, currentVTF_->getMipmapCount() - 1));
+    mipmapSpinBox_->setValue(0);
+    currentMipLevel_ = 0;
+    
+    // Update alpha channel indicator
+    QString fmt = currentVTF_->getFormat();
+    bool hasAlpha = fmt.contains('A') || fmt.contains("alpha", Qt::CaseInsensitive);
+    alphaLabel_->setText(hasAlpha ? "α" : "");
+    alphaLabel_->setToolTip(hasAlpha ? "Has alpha channel" : "No alpha channel");
+}
+
+void MainWindow::onPreviewReady(const QImage& image, const QSize& fullSize) {
+    imageViewer_->setPreviewImage(image, fullSize);
+    if (fitOnPreview_) {
+        fitOnPreview_ = false;
+        fitToWindow();
+    }
+}
+
 void MainWindow::exportCurrent() {
     QString currentFile = galleryView_->getCurrentFilename();
     if (currentFile.isEmpty()) {
@@ -1049,7 +1503,7 @@ void MainWindow::rotateImageCCW() {
 
 void MainWindow::updateTextureCount() {
     int visible = galleryView_->getVisibleCount();
-    int total = loadedTextures_.size();
+    int total = galleryView_->getCount();
     if (visible == total) {
         textureCountLabel_->setText(QString("%1 textures").arg(total));
     } else {
@@ -1117,8 +1571,13 @@ void MainWindow::keyPressEvent(QKeyEvent* event) {
             showNormal();
             fullScreenAction_->setChecked(false);
             statusBar()->showMessage("Exited full screen", 2000);
+        } else if (batchRunner_->isRunning()) {
+            cancelBatch();
+        } else if (imageViewer_->isComparing()) {
+            stopComparing();
         } else {
             // Clear selection and reset title
+            decodeScheduler_->cancel();
             imageViewer_->clear();
             propertiesPanel_->clear();
             imageDimensionsLabel_->setText("");
@@ -1148,6 +1607,7 @@ void MainWindow::keyPressEvent(QKeyEvent* event) {
 // ============================================================================
 
 void MainWindow::closeCurrent() {
+    decodeScheduler_->cancel();
     imageViewer_->clear();
     propertiesPanel_->clear();
     imageDimensionsLabel_->setText("");
@@ -1192,7 +1652,7 @@ void MainWindow::openContainingDir() {
         }
         return;
     }
-    QFileInfo fileInfo(currentFile);
+    QFileInfo fileInfo(TextureSource::containerPath(currentFile));
     QDesktopServices::openUrl(QUrl::fromLocalFile(fileInfo.absolutePath()));
     statusBar()->showMessage(QString("📂 Opened: %1").arg(fileInfo.absolutePath()), 2000);
 }
@@ -1317,45 +1777,496 @@ void MainWindow::toggleAutoFit() {
 // ============================================================================
 
 void MainWindow::showDirectoryStats() {
-    if (currentDirectory_.isEmpty() || loadedTextures_.isEmpty()) {
-        statusBar()->showMessage("⚠️ No directory loaded", 3000);
+    // Everything comes from the metadata index; no texture file is opened or stat'ed
+    std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata = directoryMetadata_ ? directoryMetadata_ : gameMetadata_;
+    if (!metadata) {
+        statusBar()->showMessage(currentDirectory_.isEmpty() ? "⚠️ No directory loaded" : "⏳ Still indexing textures", 3000);
         return;
     }
     
-    qint64 totalSize = 0;
-    int fileCount = loadedTextures_.size();
+    QElapsedTimer statsTimer;
+    statsTimer.start();
+    VTFLib::TextureStatistics statistics = VTFLib::TextureStatistics::Compute(*metadata);
+    double elapsed = statsTimer.nsecsElapsed() / 1000000.0;
     
-    for (auto it = loadedTextures_.begin(); it != loadedTextures_.end(); ++it) {
-        QFileInfo fi(it.value());
-        totalSize += fi.size();
+    StatsDialog dialog(directoryMetadata_ ? QFileInfo(currentDirectory_).fileName() : QString("Game install"),
+                       metadata, statistics, elapsed, this);
+    dialog.exec();
+}
+
+// ============================================================================
+// Find Materials
+// ============================================================================
+
+void MainWindow::findMaterials() {
+    // The open game install covers every material; otherwise use the loaded directory
+    ensureDirectoryMaterials();
+    std::shared_ptr<const VTFLib::MaterialDatabase> database = gameMaterials_ ? gameMaterials_ : directoryMaterials_;
+    if (!database) {
+        statusBar()->showMessage("⚠️ No materials loaded", 3000);
+        return;
     }
     
-    QString avgSize;
-    if (fileCount > 0) {
-        qint64 avg = totalSize / fileCount;
-        if (avg < 1024) avgSize = QString("%1 B").arg(avg);
-        else if (avg < 1024 * 1024) avgSize = QString("%1 KB").arg(avg / 1024.0, 0, 'f', 1);
-        else avgSize = QString("%1 MB").arg(avg / (1024.0 * 1024.0), 0, 'f', 2);
+    bool ok = false;
+    QString query = QInputDialog::getText(this, "Find Materials",
+        "Shader or parameter (e.g. VertexLitGeneric or $envmap).\nLeave empty to list the shaders in use:",
+        QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok) {
+        return;
+    }
+    
+    QElapsedTimer queryTimer;
+    queryTimer.start();
+    
+    QString summary;
+    QStringList lines;
+    if (query.isEmpty()) {
+        auto shaders = database->GetShaders();
+        for (const auto& shader : shaders) {
+            lines << QString("%1  %2").arg(shader.second, 7).arg(QString::fromStdString(shader.first));
+        }
+        summary = QString("%1 shaders in use by %2 materials").arg(shaders.size()).arg(database->GetMaterialCount());
+    } else {
+        std::string key = query.toStdString();
+        bool isParameter = query.startsWith('$') || query.startsWith('%');
+        std::vector<uint32_t> matches = isParameter ? database->FindMaterialsWithParameter(key)
+                                                    : database->FindMaterialsWithShader(key);
+        for (uint32_t material : matches) {
+            QString line = QString::fromStdString(database->GetPath(material));
+            if (isParameter) {
+                line += QString("  =  %1").arg(QString::fromStdString(database->GetParameter(material, key)));
+            }
+            lines << line;
+        }
+        summary = QString("%1 of %2 materials %3 %4").arg(matches.size()).arg(database->GetMaterialCount())
+            .arg(isParameter ? "set" : "use").arg(query);
+    }
+    
+    double elapsed = queryTimer.nsecsElapsed() / 1e6;
+    statusBar()->showMessage(QString("🔎 %1 (%2 ms)").arg(summary).arg(elapsed, 0, 'f', 2));
+    
+    QMessageBox box(QMessageBox::Information, "Find Materials", summary, QMessageBox::Ok, this);
+    box.setDetailedText(lines.join('\n'));
+    box.exec();
+}
+
+// ============================================================================
+// Texture References
+// ============================================================================
+
+void MainWindow::rebuildTextureReferences() {
+    textureReferences_->Clear();
+    
+    // Directory materials resolve against the game's textures as well as their own
+    if (std::shared_ptr<const VTFLib::GameIndex> game = TextureSource::shared().gameIndex()) {
+        for (const std::string& texture : game->GetFiles(".vtf")) {
+            textureReferences_->AddTexture(texture);
+        }
+    }
+    if (gameMaterials_) {
+        textureReferences_->AddMaterials(*gameMaterials_);
+    }
+    
+    for (const QString& texture : directoryTextures_) {
+        textureReferences_->AddTexture(textureReferencePath(texture));
+    }
+    ensureDirectoryMaterials();
+    if (directoryMaterials_) {
+        textureReferences_->AddMaterials(*directoryMaterials_);
+    }
+}
+
+std::string MainWindow::textureReferencePath(const QString& filename) const {
+    // Below a materials directory the path already matches material references;
+    // otherwise treat the loaded directory as the materials root
+    if (filename.contains("/materials/", Qt::CaseInsensitive) || currentDirectory_.isEmpty()) {
+        return filename.toStdString();
+    }
+    return QDir(currentDirectory_).relativeFilePath(filename).toStdString();
+}
+
+void MainWindow::showTextureReferenceReport() {
+    if (textureReferences_->GetMaterialCount() == 0 && textureReferences_->GetTextureCount() == 0) {
+        statusBar()->showMessage("⚠️ No materials or textures loaded", 3000);
+        return;
+    }
+    
+    QElapsedTimer reportTimer;
+    reportTimer.start();
+    auto missing = textureReferences_->GetMissingReferences();
+    auto orphans = textureReferences_->GetOrphanTextures();
+    double elapsed = reportTimer.nsecsElapsed() / 1e6;
+    
+    QSet<QString> brokenMaterials;
+    QStringList lines;
+    lines << QString("Missing textures (%1):").arg(missing.size());
+    for (const auto& reference : missing) {
+        QString material = QString::fromStdString(reference.first);
+        brokenMaterials.insert(material);
+        lines << QString("  %1  ->  %2").arg(material, QString::fromStdString(reference.second));
+    }
+    lines << QString() << QString("Unreferenced textures (%1):").arg(orphans.size());
+    for (const std::string& texture : orphans) {
+        lines << QString("  %1").arg(QString::fromStdString(texture));
     }
     
-    QString totalSizeStr;
-    if (totalSize < 1024) totalSizeStr = QString("%1 B").arg(totalSize);
-    else if (totalSize < 1024 * 1024) totalSizeStr = QString("%1 KB").arg(totalSize / 1024.0, 0, 'f', 1);
-    else if (totalSize < 1024LL * 1024 * 1024) totalSizeStr = QString("%1 MB").arg(totalSize / (1024.0 * 1024.0), 0, 'f', 2);
-    else totalSizeStr = QString("%1 GB").arg(totalSize / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+    QString summary = QString("%1 missing textures in %2 of %3 materials\n%4 of %5 textures are unreferenced")
+        .arg(missing.size()).arg(brokenMaterials.size()).arg(textureReferences_->GetMaterialCount())
+        .arg(orphans.size()).arg(textureReferences_->GetTextureCount());
+    statusBar()->showMessage(QString("🔗 Reference report in %1 ms").arg(elapsed, 0, 'f', 1), 3000);
     
-    QMessageBox::information(this, "Directory Statistics",
-        QString("<h3>📊 Directory Statistics</h3>"
-                "<table cellpadding='4'>"
-                "<tr><td><b>Directory:</b></td><td>%1</td></tr>"
-                "<tr><td><b>Textures:</b></td><td>%2</td></tr>"
-                "<tr><td><b>Total Size:</b></td><td>%3</td></tr>"
-                "<tr><td><b>Average Size:</b></td><td>%4</td></tr>"
-                "</table>")
-        .arg(QFileInfo(currentDirectory_).fileName())
-        .arg(fileCount)
-        .arg(totalSizeStr)
-        .arg(avgSize));
+    QMessageBox box(QMessageBox::Information, "Texture Reference Report", summary, QMessageBox::Ok, this);
+    box.setDetailedText(lines.join('\n'));
+    box.exec();
+}
+
+// ============================================================================
+// Find Duplicates
+// ============================================================================
+
+void MainWindow::findDuplicates() {
+    // Only loose files are hashed; archived textures share storage already
+    std::vector<std::string> textures;
+    for (const QString& filename : directoryTextures_) {
+        if (!TextureSource::isArchivePath(filename)) {
+            textures.push_back(filename.toStdString());
+        }
+    }
+    if (textures.empty()) {
+        statusBar()->showMessage("⚠️ No textures loaded", 3000);
+        return;
+    }
+    
+    // Hashing a whole tree can take minutes; it runs on the batch worker
+    auto groups = std::make_shared<std::vector<VTFLib::DuplicateGroup>>();
+    std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata = directoryMetadata_;
+    size_t textureCount = textures.size();
+    batchRunner_->run("Finding duplicates", [textures, metadata, groups](VTFLib::BatchProgress& progress) {
+        *groups = VTFLib::DuplicateFinder::Find(textures, metadata.get(), &progress);
+    }, [this, groups, textureCount](qint64 elapsedMs) {
+        showDuplicates(*groups, textureCount, elapsedMs / 1000.0);
+    });
+}
+
+void MainWindow::showDuplicates(const std::vector<VTFLib::DuplicateGroup>& groups, size_t textureCount, double elapsed) {
+    if (groups.empty()) {
+        statusBar()->showMessage(QString("✅ No duplicate textures among %1 (%2s)").arg(textureCount).arg(elapsed, 0, 'f', 1), 5000);
+        return;
+    }
+    
+    QList<QStringList> files;
+    QStringList labels;
+    quint64 totalWasted = 0;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        QStringList group;
+        for (const std::string& filename : groups[i].files) {
+            group << QString::fromStdString(filename);
+        }
+        files << group;
+        labels << QString("#%1 %2 %3 KB").arg(i + 1).arg(groups[i].identicalFiles ? "=" : "≈")
+            .arg(groups[i].wastedBytes / 1024.0, 0, 'f', 1);
+        totalWasted += groups[i].wastedBytes;
+    }
+    galleryView_->showGroups(files, labels);
+    
+    statusBar()->showMessage(QString("🧬 %1 duplicate groups wasting %2 MB (= identical files, ≈ same image data) in %3s")
+        .arg(groups.size()).arg(totalWasted / (1024.0 * 1024.0), 0, 'f', 2).arg(elapsed, 0, 'f', 1));
+}
+
+// ============================================================================
+// Find Similar
+// ============================================================================
+
+void MainWindow::findSimilar() {
+    QString currentFile = galleryView_->getCurrentFilename();
+    VTFLib::PerceptualDescriptor query;
+    if (currentFile.isEmpty() || !similarityIndex_->Get(currentFile.toStdString(), query)) {
+        statusBar()->showMessage("⚠️ Select a texture to find similar ones", 3000);
+        return;
+    }
+    
+    // Past this distance textures rarely look alike
+    const size_t maxMatches = 50;
+    const uint32_t maxDistance = 200;
+    
+    QElapsedTimer findTimer;
+    findTimer.start();
+    std::vector<VTFLib::SimilarityIndex::Match> matches = similarityIndex_->FindSimilar(query, maxMatches + 1, maxDistance);
+    double elapsed = findTimer.nsecsElapsed() / 1000000.0;
+    
+    // The selected texture leads, then one group per match so each shows its distance
+    QList<QStringList> files;
+    QStringList labels;
+    files << QStringList(currentFile);
+    labels << "Selected";
+    for (const VTFLib::SimilarityIndex::Match& match : matches) {
+        QString filename = QString::fromStdString(match.key);
+        if (filename != currentFile && files.size() <= static_cast<int>(maxMatches)) {
+            files << QStringList(filename);
+            labels << QString("Δ %1").arg(match.distance);
+        }
+    }
+    
+    QString name = QFileInfo(currentFile).fileName();
+    if (files.size() == 1) {
+        statusBar()->showMessage(QString("✅ Nothing looks like %1 among %2 textures").arg(name).arg(similarityIndex_->GetCount()), 5000);
+        return;
+    }
+    galleryView_->showGroups(files, labels);
+    
+    statusBar()->showMessage(QString("🔎 %1 textures similar to %2 among %3 in %4 ms")
+        .arg(files.size() - 1).arg(name).arg(similarityIndex_->GetCount()).arg(elapsed, 0, 'f', 1));
+}
+
+// ============================================================================
+// Validate Textures
+// ============================================================================
+
+void MainWindow::validateTextures() {
+    // Loose files are validated directly, archived ones through their whole archive so
+    // every entry's CRC is checked too; the game install adds its own tree and VPKs
+    std::vector<std::string> files;
+    std::vector<std::string> archives;
+    for (const QString& filename : directoryTextures_) {
+        if (!TextureSource::isArchivePath(filename)) {
+            files.push_back(filename.toStdString());
+        } else {
+            std::string archive = TextureSource::containerPath(filename).toStdString();
+            if (std::find(archives.begin(), archives.end(), archive) == archives.end()) {
+                archives.push_back(archive);
+            }
+        }
+    }
+    std::shared_ptr<const VTFLib::GameIndex> game = TextureSource::shared().gameIndex();
+    if (files.empty() && archives.empty() && !game) {
+        statusBar()->showMessage("⚠️ No textures loaded", 3000);
+        return;
+    }
+    
+    // A whole install takes minutes; listing its loose textures is left to the worker too
+    struct Result {
+        std::vector<VTFLib::ValidationReport> reports;
+        size_t fileCount = 0;
+        size_t archiveCount = 0;
+    };
+    auto result = std::make_shared<Result>();
+    batchRunner_->run("Validating textures", [files, archives, game, result](VTFLib::BatchProgress& progress) mutable {
+        std::vector<std::shared_ptr<const VTFLib::VPKFile>> gameArchives;
+        if (game) {
+            for (const VTFLib::GameSearchPath& searchPath : game->GetSearchPaths()) {
+                if (searchPath.vpk) {
+                    gameArchives.push_back(searchPath.vpk);
+                    continue;
+                }
+                for (const std::string& file : searchPath.files) {
+                    if (QString::fromStdString(file).endsWith(".vtf", Qt::CaseInsensitive)) {
+                        files.push_back(searchPath.path + "/" + file);
+                    }
+                }
+            }
+        }
+        result->fileCount = files.size();
+        result->archiveCount = archives.size() + gameArchives.size();
+        
+        result->reports = VTFLib::VTFValidator::ValidateFiles(files, &progress);
+        for (const std::string& archive : archives) {
+            if (progress.IsCancelled()) {
+                return;
+            }
+            std::vector<VTFLib::ValidationReport> found = VTFLib::VTFValidator::ValidateArchive(archive, &progress);
+            result->reports.insert(result->reports.end(), found.begin(), found.end());
+        }
+        for (const auto& vpk : gameArchives) {
+            if (progress.IsCancelled()) {
+                return;
+            }
+            std::vector<VTFLib::ValidationReport> found = VTFLib::VTFValidator::ValidateVPK(*vpk, &progress);
+            result->reports.insert(result->reports.end(), found.begin(), found.end());
+        }
+    }, [this, result](qint64 elapsedMs) {
+        showValidation(result->reports, QString("%1 files and %2 archives").arg(result->fileCount).arg(result->archiveCount),
+                       elapsedMs / 1000.0);
+    });
+}
+
+void MainWindow::showValidation(const std::vector<VTFLib::ValidationReport>& reports, const QString& checked, double elapsed) {
+    if (reports.empty()) {
+        statusBar()->showMessage(QString("✅ No problems in %1 (%2s)").arg(checked).arg(elapsed, 0, 'f', 1), 5000);
+        return;
+    }
+    
+    int broken = 0;
+    QStringList lines;
+    for (const VTFLib::ValidationReport& report : reports) {
+        broken += report.HasErrors() ? 1 : 0;
+        lines << QString::fromStdString(report.path);
+        for (const VTFLib::ValidationIssue& issue : report.issues) {
+            lines << QString("  %1: %2").arg(issue.severity == VTFLib::VALIDATION_ERROR ? "error" : "warning",
+                                             QString::fromStdString(issue.message));
+        }
+    }
+    
+    QString summary = QString("%1 with errors and %2 with warnings only, in %3")
+        .arg(broken).arg(static_cast<int>(reports.size()) - broken).arg(checked);
+    statusBar()->showMessage(QString("🩺 Validated %1 in %2s").arg(checked).arg(elapsed, 0, 'f', 1), 5000);
+    
+    QMessageBox box(broken ? QMessageBox::Warning : QMessageBox::Information, "Validate Textures", summary,
+                    QMessageBox::Ok, this);
+    box.setDetailedText(lines.join('\n'));
+    box.exec();
+}
+
+// ============================================================================
+// Mip Chain Check
+// ============================================================================
+
+void MainWindow::checkMipChain() {
+    if (currentVTF_ == nullptr || !currentVTF_->isLoaded()) {
+        statusBar()->showMessage("⚠️ No texture loaded", 3000);
+        return;
+    }
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer checkTimer;
+    checkTimer.start();
+    std::vector<VTFLib::MipComparison> mips;
+    bool decoded = VTFLib::MipChainChecker::Check(*currentVTF_->getFile(), mips);
+    double elapsed = checkTimer.nsecsElapsed() / 1000000.0;
+    QApplication::restoreOverrideCursor();
+    
+    if (!decoded) {
+        statusBar()->showMessage("⚠️ Could not decode the mip chain", 3000);
+        return;
+    }
+    propertiesPanel_->setMipChain(mips, elapsed);
+}
+
+void MainWindow::checkMipChains() {
+    // Only loose files, as for duplicates; they are decoded in place from a mapping
+    std::vector<std::string> textures;
+    for (const QString& filename : directoryTextures_) {
+        if (!TextureSource::isArchivePath(filename)) {
+            textures.push_back(filename.toStdString());
+        }
+    }
+    if (textures.empty()) {
+        statusBar()->showMessage("⚠️ No textures loaded", 3000);
+        return;
+    }
+    
+    // Every mip of every texture is decoded; it runs on the batch worker
+    auto reports = std::make_shared<std::vector<VTFLib::MipChainReport>>();
+    size_t textureCount = textures.size();
+    batchRunner_->run("Checking mip chains", [textures, reports](VTFLib::BatchProgress& progress) {
+        *reports = VTFLib::MipChainChecker::CheckFiles(textures, &progress);
+    }, [this, reports, textureCount](qint64 elapsedMs) {
+        showMipChainReports(*reports, textureCount, elapsedMs / 1000.0);
+    });
+}
+
+void MainWindow::showMipChainReports(const std::vector<VTFLib::MipChainReport>& reports, size_t textureCount,
+                                     double elapsed) {
+    if (reports.empty()) {
+        statusBar()->showMessage(QString("✅ Every mip chain among %1 textures looks consistent (%2s)")
+            .arg(textureCount).arg(elapsed, 0, 'f', 1), 5000);
+        return;
+    }
+    
+    // One group per texture, labelled with its worst mip
+    QList<QStringList> files;
+    QStringList labels;
+    for (const VTFLib::MipChainReport& report : reports) {
+        const VTFLib::MipComparison* worst = report.GetWorst();
+        files << QStringList(QString::fromStdString(report.path));
+        labels << QString("⚠️ mip %1 SSIM %2").arg(worst->mipmap).arg(worst->ssim, 0, 'f', 2);
+    }
+    galleryView_->showGroups(files, labels);
+    
+    statusBar()->showMessage(QString("🪜 %1 of %2 textures have mips unlike their parent, in %3s")
+        .arg(reports.size()).arg(textureCount).arg(elapsed, 0, 'f', 1));
+}
+
+// ============================================================================
+// Compare
+// ============================================================================
+
+void MainWindow::compareWithFile() {
+    if (currentVTF_ == nullptr || !currentVTF_->isLoaded()) {
+        statusBar()->showMessage("⚠️ No texture loaded", 3000);
+        return;
+    }
+    
+    QString filename = QFileDialog::getOpenFileName(this, "Compare With", currentDirectory_, "VTF Textures (*.vtf)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    VTFReader other;
+    if (!other.loadFile(filename)) {
+        QApplication::restoreOverrideCursor();
+        statusBar()->showMessage(QString("⚠️ Could not load %1").arg(QFileInfo(filename).fileName()), 3000);
+        return;
+    }
+    
+    // Line up the other texture's mip of the same size, so a re-export at double the
+    // resolution is compared at the resolution on screen
+    int width = std::max(1, currentVTF_->getWidth() >> currentMipLevel_);
+    int height = std::max(1, currentVTF_->getHeight() >> currentMipLevel_);
+    int otherMip = 0;
+    for (int mip = 0; mip < other.getMipmapCount(); ++mip) {
+        if (std::max(1, other.getWidth() >> mip) == width && std::max(1, other.getHeight() >> mip) == height) {
+            otherMip = mip;
+            break;
+        }
+    }
+    
+    QString currentName = QFileInfo(galleryView_->getCurrentFilename()).fileName();
+    QImage a = currentVTF_->getImage(0, currentMipLevel_);
+    QImage b = other.getImage(0, otherMip);
+    QApplication::restoreOverrideCursor();
+    startComparison(a, QString("%1 mip %2").arg(currentName).arg(currentMipLevel_),
+                    b, QString("%1 mip %2").arg(QFileInfo(filename).fileName()).arg(otherMip));
+}
+
+void MainWindow::compareWithNextMip() {
+    if (currentVTF_ == nullptr || !currentVTF_->isLoaded()) {
+        statusBar()->showMessage("⚠️ No texture loaded", 3000);
+        return;
+    }
+    if (currentMipLevel_ + 1 >= currentVTF_->getMipmapCount()) {
+        statusBar()->showMessage("⚠️ No smaller mip to compare with", 3000);
+        return;
+    }
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QImage a = currentVTF_->getImage(0, currentMipLevel_);
+    QImage b = currentVTF_->getImage(0, currentMipLevel_ + 1);
+    QApplication::restoreOverrideCursor();
+    startComparison(a, QString("mip %1").arg(currentMipLevel_), b, QString("mip %1 (scaled up)").arg(currentMipLevel_ + 1));
+}
+
+void MainWindow::startComparison(const QImage& a, const QString& labelA, const QImage& b, const QString& labelB) {
+    if (a.isNull() || b.isNull()) {
+        statusBar()->showMessage("⚠️ Could not decode the images to compare", 3000);
+        return;
+    }
+    
+    imageViewer_->compareImages(a, labelA, b, labelB);
+    setCompareMode(compareModeGroup_->checkedAction());
+    statusBar()->showMessage(QString("🔀 Comparing %1 with %2 (Esc to stop)").arg(labelA, labelB), 5000);
+}
+
+void MainWindow::setCompareMode(QAction* action) {
+    imageViewer_->setCompareMode(static_cast<CompareView::Mode>(action->data().toInt()));
+}
+
+void MainWindow::stopComparing() {
+    if (!imageViewer_->isComparing()) {
+        return;
+    }
+    imageViewer_->stopComparing();
+    statusBar()->showMessage("Stopped comparing", 2000);
 }
 
 // ============================================================================
@@ -1368,7 +2279,8 @@ void MainWindow::saveCurrentView() {
         return;
     }
     
-    QImage image = imageViewer_->getRotatedImage();
+    // Save from a straight-alpha decode; the viewer holds a premultiplied display copy
+    QImage image = imageViewer_->applyRotation(currentVTF_->getImage(0, currentMipLevel_));
     if (image.isNull()) {
         statusBar()->showMessage("⚠️ No image to save", 3000);
         return;
@@ -10,12 +10,36 @@
 #include <QSettings>
 #include <QLabel>
 #include <QSpinBox>
+#include <QImage>
+#include <QElapsedTimer>
+#include <memory>
+#include <vector>
 
+class QActionGroup;
 class GalleryView;
 class ImageViewer;
 class PropertiesPanel;
 class VTFReader;
 class VMTParser;
+class DecodeScheduler;
+class MaterialThumbnailer;
+class DirectoryWatcher;
+class DirectoryScanner;
+class BatchRunner;
+class QProgressBar;
+class QToolButton;
+
+namespace VTFLib {
+    class VTFFile;
+    struct DuplicateGroup;
+    struct ValidationReport;
+    struct MipChainReport;
+    class GameIndex;
+    class MaterialDatabase;
+    class TextureReferenceIndex;
+    class TextureMetadataIndex;
+    class SimilarityIndex;
+}
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -23,9 +47,10 @@ class MainWindow : public QMainWindow {
 public:
     explicit MainWindow(QWidget* parent = nullptr);
     ~MainWindow() override;
-
+    
 private slots:
     void openDirectory();
+    void openGameInstall();
     void exportCurrent();
     void exportAll();
     void onTextureSelected(const QString& filename);
@@ -62,8 +87,31 @@ private slots:
     void randomTexture();
     void toggleAutoFit();
     void showDirectoryStats();
+    void findMaterials();
+    void showTextureReferenceReport();
+    void findDuplicates();
+    void findSimilar();
+    void validateTextures();
+    void checkMipChain();
+    void checkMipChains();
+    void compareWithFile();
+    void compareWithNextMip();
+    void setCompareMode(QAction* action);
+    void stopComparing();
     void saveCurrentView();
     void toggleAlwaysOnTop();
+    void onTextureFileLoaded(const QString& filename, std::shared_ptr<const VTFLib::VTFFile> file);
+    void onPreviewReady(const QImage& image, const QSize& fullSize);
+    void applyDirectoryChanges(const QStringList& added, const QStringList& modified, const QStringList& removed);
+    void onScanFilesFound(const QStringList& files);
+    void onScanFinished(int fileCount, qint64 elapsedMs);
+    void processScanQueue();
+    void onMetadataReady(std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata);
+    void onGameIndexed(std::shared_ptr<const VTFLib::GameIndex> game,
+                       std::shared_ptr<const VTFLib::MaterialDatabase> materials,
+                       std::shared_ptr<const VTFLib::TextureMetadataIndex> metadata, qint64 elapsedMs);
+    void onBatchProgress(const QString& label, quint64 done, quint64 total);
+    void cancelBatch();
     
 private:
     void createActions();
@@ -73,6 +121,9 @@ private:
     void createDockWidgets();
     
     void loadDirectory(const QString& path);
+    void showDuplicates(const std::vector<VTFLib::DuplicateGroup>& groups, size_t textureCount, double elapsed);
+    void showValidation(const std::vector<VTFLib::ValidationReport>& reports, const QString& checked, double elapsed);
+    void showMipChainReports(const std::vector<VTFLib::MipChainReport>& reports, size_t textureCount, double elapsed);
     void loadTexture(const QString& filename);
     void exportTexture(const QString& filename, const QString& outputPath, 
                       const QString& format, int quality);
@@ -86,6 +137,7 @@ private:
     
     // Actions
     QAction* openDirAction_;
+    QAction* openGameInstallAction_;
     QAction* exportCurrentAction_;
     QAction* exportAllAction_;
     QAction* exitAction_;
@@ -117,6 +169,19 @@ private:
     QAction* randomTextureAction_;
     QAction* autoFitAction_;
     QAction* directoryStatsAction_;
+    QAction* findMaterialsAction_;
+    QAction* textureReferenceReportAction_;
+    QAction* findDuplicatesAction_;
+    QAction* findSimilarAction_;
+    QAction* validateTexturesAction_;
+    QAction* checkMipChainsAction_;
+    QAction* compareWithFileAction_;
+    QAction* compareWithNextMipAction_;
+    QAction* compareSideBySideAction_;
+    QAction* compareSwipeAction_;
+    QAction* compareDifferenceAction_;
+    QAction* stopComparingAction_;
+    QActionGroup* compareModeGroup_;
     QAction* saveCurrentViewAction_;
     QAction* alwaysOnTopAction_;
     QMenu* recentMenu_;
@@ -127,6 +192,8 @@ private:
     QLabel* imageDimensionsLabel_;
     QLabel* formatLabel_;
     QLabel* alphaLabel_;
+    QProgressBar* batchProgressBar_;   // shown while a batch check runs
+    QToolButton* batchCancelButton_;
     
     // Data
     QMap<QString, QString> loadedTextures_; // filename -> full path
@@ -142,11 +209,38 @@ private:
     QString lastExportFormat_;
     int currentMipLevel_;
     QSpinBox* mipmapSpinBox_;
+    DecodeScheduler* decodeScheduler_;
+    MaterialThumbnailer* materialThumbnailer_;
+    DirectoryWatcher* directoryWatcher_;
+    DirectoryScanner* directoryScanner_;
+    BatchRunner* batchRunner_;     // duplicates, validation and mip chain checks of the whole tree
+    QStringList scanQueue_;        // files found by the scanner and not yet loaded
+    bool scanQueueScheduled_;      // processScanQueue is already queued
+    int scanTextureCount_;         // textures loaded so far from the current scan
+    QElapsedTimer loadTimer_;
+    QImage materialPlaceholder_;  // gallery icon of a material until its thumbnail arrives
+    bool fitOnPreview_; // fit the next preview once it arrives from the scheduler
+    std::shared_ptr<const VTFLib::MaterialDatabase> directoryMaterials_; // VMTs of the loaded directory
+    bool directoryMaterialsStale_;                                       // a VMT changed since it was built
+    std::shared_ptr<const VTFLib::MaterialDatabase> gameMaterials_;      // VMTs of the open game install
+    QStringList directoryTextures_;                                      // VTFs of the loaded directory
+    QStringList directoryMaterialFiles_;                                 // VMTs of the loaded directory
+    std::unique_ptr<VTFLib::TextureReferenceIndex> textureReferences_;   // game plus directory
+    std::shared_ptr<const VTFLib::TextureMetadataIndex> directoryMetadata_; // loose VTFs of the loaded directory
+    std::shared_ptr<const VTFLib::TextureMetadataIndex> gameMetadata_;      // VTFs of the open game install
+    std::unique_ptr<VTFLib::SimilarityIndex> similarityIndex_;             // descriptors of every thumbnailed VTF
     
+    bool thumbnailTexture(const QString& filename, bool addToGallery);
+    void finishDirectoryLoad();
+    void rebuildDirectoryMaterials();
+    void ensureDirectoryMaterials();
+    void rebuildTextureReferences();
+    std::string textureReferencePath(const QString& filename) const;
     void updateRecentDirectoriesMenu();
     void addToRecentDirectories(const QString& path);
     void loadSettings();
     void saveSettings();
+    void startComparison(const QImage& a, const QString& labelA, const QImage& b, const QString& labelB);
     
 protected:
     void dragEnterEvent(QDragEnterEvent* event) override;
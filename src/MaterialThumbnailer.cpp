@@ -0,0 +1,103 @@
+#include "MaterialThumbnailer.h"
+#include "TextureSource.h"
+#include "VMTParser.h"
+#include "VTFReader.h"
+
+MaterialThumbnailer::MaterialThumbnailer(QObject* parent)
+    : QObject(parent), generation_(0), size_(128) {
+}
+
+MaterialThumbnailer::~MaterialThumbnailer() {
+    clear();
+    pool_.waitForDone();
+}
+
+void MaterialThumbnailer::addTextureThumbnail(const QString& texturePath, const QImage& thumbnail,
+                                              int width, int height) {
+    thumbnails_.insert(texturePath, Thumbnail{ thumbnail, width, height });
+}
+
+void MaterialThumbnailer::removeTextureThumbnail(const QString& texturePath) {
+    thumbnails_.remove(texturePath);
+}
+
+void MaterialThumbnailer::request(const QStringList& materials, int size) {
+    size_ = size;
+    quint64 generation = generation_;
+    
+    for (const QString& material : materials) {
+        pool_.start([this, material, generation]() {
+            // Parsing is all this job does; the decode is shared per texture
+            VMTParser parser;
+            QString texturePath;
+            if (parser.loadFile(material)) {
+                texturePath = TextureSource::shared().resolveMaterialTexture(material, parser.getBaseTexture());
+            }
+            if (texturePath.isEmpty()) {
+                return;
+            }
+            deliver(generation, [this, material, texturePath]() {
+                onTextureResolved(material, texturePath);
+            });
+        });
+    }
+}
+
+void MaterialThumbnailer::clear() {
+    // Anything already queued for delivery is dropped by the generation check
+    generation_++;
+    pool_.clear();
+    thumbnails_.clear();
+    waiting_.clear();
+}
+
+void MaterialThumbnailer::onTextureResolved(const QString& material, const QString& texturePath) {
+    auto cached = thumbnails_.constFind(texturePath);
+    if (cached != thumbnails_.constEnd()) {
+        if (!cached->image.isNull()) {
+            emit thumbnailReady(material, cached->image, cached->width, cached->height);
+        }
+        return;
+    }
+    
+    // Another material already started this texture; wait for that decode
+    auto pending = waiting_.find(texturePath);
+    if (pending != waiting_.end()) {
+        pending->append(material);
+        return;
+    }
+    waiting_.insert(texturePath, QStringList{ material });
+    
+    quint64 generation = generation_;
+    int size = size_;
+    pool_.start([this, texturePath, generation, size]() {
+        VTFReader reader;
+        Thumbnail thumbnail{ QImage(), 0, 0 };
+        if (reader.loadFile(texturePath)) {
+            thumbnail = Thumbnail{ reader.getThumbnail(size), reader.getWidth(), reader.getHeight() };
+        }
+        deliver(generation, [this, texturePath, thumbnail]() {
+            onTextureDecoded(texturePath, thumbnail);
+        });
+    });
+}
+
+void MaterialThumbnailer::onTextureDecoded(const QString& texturePath, const Thumbnail& thumbnail) {
+    // Failures are cached too, so later materials don't retry them
+    thumbnails_.insert(texturePath, thumbnail);
+    QStringList materials = waiting_.take(texturePath);
+    if (thumbnail.image.isNull()) {
+        return;
+    }
+    for (const QString& material : materials) {
+        emit thumbnailReady(material, thumbnail.image, thumbnail.width, thumbnail.height);
+    }
+}
+
+void MaterialThumbnailer::deliver(quint64 generation, std::function<void()> handler) {
+    QMetaObject::invokeMethod(this, [this, generation, handler]() {
+        if (generation == generation_) {
+            handler();
+        }
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,56 @@
+#ifndef MATERIALTHUMBNAILER_H
+#define MATERIALTHUMBNAILER_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+// Background thumbnails for materials. Each VMT is parsed on the pool to find its base
+// texture; a texture that already has a thumbnail (from the directory scan, or another
+// material) is reused, and each texture is decoded at most once even when many materials
+// share it. Bookkeeping happens on the thumbnailer's thread only; clear() drops every
+// job in flight.
+class MaterialThumbnailer : public QObject {
+    Q_OBJECT
+    
+public:
+    explicit MaterialThumbnailer(QObject* parent = nullptr);
+    ~MaterialThumbnailer() override;
+    
+    // Record a thumbnail already decoded for a VTF so materials using it share it
+    void addTextureThumbnail(const QString& texturePath, const QImage& thumbnail, int width, int height);
+    void removeTextureThumbnail(const QString& texturePath);
+    
+    // Queue materials for thumbnails of the given size
+    void request(const QStringList& materials, int size);
+    
+    // Cancel outstanding work and forget every thumbnail
+    void clear();
+    
+signals:
+    // width and height are those of the base texture
+    void thumbnailReady(const QString& material, const QImage& thumbnail, int width, int height);
+    
+private:
+    struct Thumbnail {
+        QImage image;
+        int width;
+        int height;
+    };
+    
+    QThreadPool pool_;
+    quint64 generation_;
+    int size_;
+    QHash<QString, Thumbnail> thumbnails_;     // by texture path
+    QHash<QString, QStringList> waiting_;      // texture being decoded -> materials using it
+    
+    void onTextureResolved(const QString& material, const QString& texturePath);
+    void onTextureDecoded(const QString& texturePath, const Thumbnail& thumbnail);
+    void deliver(quint64 generation, std::function<void()> handler);
+};
+
+#endif // MATERIALTHUMBNAILER_H
@@ -1,17 +1,25 @@
 #include "PropertiesPanel.h"
 #include "VTFFormat.h"
+#include "MipChainChecker.h"
 #include <QVBoxLayout>
 #include <QFileInfo>
 #include <QDateTime>
+#include <cmath>
 #include <numeric>
 
 PropertiesPanel::PropertiesPanel(QWidget* parent) : QWidget(parent) {
     textEdit_ = new QTextEdit;
     textEdit_->setReadOnly(true);
     
+    checkMipChainButton_ = new QPushButton("Check Mip Chain");
+    checkMipChainButton_->setToolTip("Compare every mip with a box-filtered version of the mip above it");
+    checkMipChainButton_->setEnabled(false);
+    connect(checkMipChainButton_, &QPushButton::clicked, this, &PropertiesPanel::mipChainCheckRequested);
+    
     QVBoxLayout* layout = new QVBoxLayout(this);
     layout->setContentsMargins(0, 0, 0, 0);
     layout->addWidget(textEdit_);
+    layout->addWidget(checkMipChainButton_);
 }
 
 QString PropertiesPanel::formatFileSize(qint64 bytes) {
@@ -27,7 +35,7 @@ QString PropertiesPanel::formatFileSize(qint64 bytes) {
 }
 
 void PropertiesPanel::setVTFProperties(const QString& filename, int width, int height,
-                                      const QString& format, int frames, int mipmaps, quint32 flags) {
+                                      const QString& format, int frames, int mipmaps, quint32 flags, quint64 vramBytes) {
     QFileInfo fileInfo(filename);
     
     // Calculate pixel count for display
@@ -52,11 +60,12 @@ void PropertiesPanel::setVTFProperties(const QString& filename, int width, int h
     html += QString("<tr><td><b>Format:</b></td><td>%1</td></tr>").arg(format);
     html += QString("<tr><td><b>Frames:</b></td><td>%1</td></tr>").arg(frames);
     html += QString("<tr><td><b>Mipmaps:</b></td><td>%1</td></tr>").arg(mipmaps);
-    html += QString("<tr><td><b>Est. VRAM:</b></td><td>%1</td></tr>").arg(estimateMemorySize(width, height, mipmaps));
+    html += QString("<tr><td><b>VRAM:</b></td><td>%1</td></tr>").arg(formatFileSize(static_cast<qint64>(vramBytes)));
     html += QString("<tr><td><b>Flags:</b></td><td>%1</td></tr>").arg(formatFlags(flags));
     html += "</table>";
     
     textEdit_->setHtml(html);
+    checkMipChainButton_->setEnabled(mipmaps > 1);
 }
 
 void PropertiesPanel::setVMTProperties(const QString& shader, const QMap<QString, QString>& parameters) {
@@ -72,10 +81,51 @@ void PropertiesPanel::setVMTProperties(const QString& shader, const QMap<QString
     
     html += "</table>";
     textEdit_->setHtml(html);
+    checkMipChainButton_->setEnabled(false);
+}
+
+void PropertiesPanel::setReferencingMaterials(const QStringList& materials) {
+    QString html = QString("<h4>Used by %1 material%2</h4>")
+        .arg(materials.size()).arg(materials.size() == 1 ? "" : "s");
+    if (materials.isEmpty()) {
+        html += "<p>⚠️ No loaded material references this texture</p>";
+    } else {
+        html += "<ul>";
+        for (const QString& material : materials) {
+            html += QString("<li>%1</li>").arg(material.toHtmlEscaped());
+        }
+        html += "</ul>";
+    }
+    textEdit_->append(html);
+}
+
+void PropertiesPanel::setMipChain(const std::vector<VTFLib::MipComparison>& mips, double elapsedMs) {
+    int outliers = 0;
+    QString rows;
+    for (const VTFLib::MipComparison& mip : mips) {
+        outliers += mip.outlier ? 1 : 0;
+        QString psnr = std::isinf(mip.psnr) ? QString("∞") : QString("%1 dB").arg(mip.psnr, 0, 'f', 1);
+        rows += QString("<tr><td>%1</td><td>%2 x %3</td><td>%4</td><td>%5</td><td>%6</td></tr>")
+            .arg(mip.mipmap).arg(mip.width).arg(mip.height).arg(psnr).arg(mip.ssim, 0, 'f', 3)
+            .arg(mip.outlier ? "⚠️" : "");
+    }
+    
+    QString html = "<h4>Mip Chain</h4>";
+    if (mips.empty()) {
+        html += "<p>No mips large enough to compare</p>";
+    } else {
+        html += outliers ? QString("<p>⚠️ %1 of %2 mips don't match the mip above</p>").arg(outliers).arg(mips.size())
+                         : QString("<p>✅ Every mip matches a downsample of the mip above</p>");
+        html += "<table cellpadding='2'><tr><th>Mip</th><th>Size</th><th>PSNR</th><th>SSIM</th><th></th></tr>";
+        html += rows + "</table>";
+    }
+    html += QString("<p><i>Checked in %1 ms</i></p>").arg(elapsedMs, 0, 'f', 1);
+    textEdit_->append(html);
 }
 
 void PropertiesPanel::clear() {
     textEdit_->clear();
+    checkMipChainButton_->setEnabled(false);
 }
 
 QString PropertiesPanel::formatFlags(quint32 flags) {
@@ -107,19 +157,3 @@ QString PropertiesPanel::calculateAspectRatio(int width, int height) {
     int g = std::gcd(width, height);
     return QString("%1:%2").arg(width / g).arg(height / g);
 }
-
-QString PropertiesPanel::estimateMemorySize(int width, int height, int mipmaps) {
-    // Base RGBA size (4 bytes per pixel)
-    qint64 baseSize = static_cast<qint64>(width) * height * 4;
-    
-    // Add mipmap levels (each is 1/4 of previous, sum ~= 1.33x base)
-    qint64 totalSize = baseSize;
-    int mipW = width, mipH = height;
-    for (int i = 1; i < mipmaps; ++i) {
-        mipW = std::max(1, mipW / 2);
-        mipH = std::max(1, mipH / 2);
-        totalSize += static_cast<qint64>(mipW) * mipH * 4;
-    }
-    
-    return formatFileSize(totalSize);
-}
@@ -3,6 +3,12 @@
 
 #include <QWidget>
 #include <QTextEdit>
+#include <QPushButton>
+#include <vector>
+
+namespace VTFLib {
+    struct MipComparison;
+}
 
 class PropertiesPanel : public QWidget {
     Q_OBJECT
@@ -11,17 +17,22 @@ public:
     explicit PropertiesPanel(QWidget* parent = nullptr);
     
     void setVTFProperties(const QString& filename, int width, int height, 
-                         const QString& format, int frames, int mipmaps, quint32 flags);
+                         const QString& format, int frames, int mipmaps, quint32 flags, quint64 vramBytes);
     void setVMTProperties(const QString& shader, const QMap<QString, QString>& parameters);
+    void setReferencingMaterials(const QStringList& materials);  // appended below the texture's properties
+    void setMipChain(const std::vector<VTFLib::MipComparison>& mips, double elapsedMs);  // appended likewise
     void clear();
     
+signals:
+    void mipChainCheckRequested();
+    
 private:
     QTextEdit* textEdit_;
+    QPushButton* checkMipChainButton_;
     
     QString formatFlags(quint32 flags);
     QString formatFileSize(qint64 bytes);
     QString calculateAspectRatio(int width, int height);
-    QString estimateMemorySize(int width, int height, int mipmaps);
 };
 
 #endif // PROPERTIESPANEL_H
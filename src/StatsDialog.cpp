@@ -0,0 +1,222 @@
+#include "StatsDialog.h"
+#include "TextureMetadataIndex.h"
+#include "TextureStatistics.h"
+#include "VRAMBudget.h"
+#include "VTFFormat.h"
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTabWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+// Cells shown formatted but sorted by the number in their Qt::UserRole
+class SortItem : public QTableWidgetItem {
+public:
+    SortItem(const QString& text, double value) : QTableWidgetItem(text) {
+        setData(Qt::UserRole, value);
+        setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    
+    bool operator<(const QTableWidgetItem& other) const override {
+        return data(Qt::UserRole).toDouble() < other.data(Qt::UserRole).toDouble();
+    }
+};
+
+} // namespace
+
+StatsDialog::StatsDialog(const QString& source, std::shared_ptr<const VTFLib::TextureMetadataIndex> index,
+                         const VTFLib::TextureStatistics& statistics, double elapsedMs, QWidget* parent)
+    : QDialog(parent), index_(std::move(index)) {
+    setWindowTitle("Directory Statistics");
+    resize(760, 560);
+    
+    const VTFLib::TextureTally& total = statistics.total;
+    QTabWidget* tabs = new QTabWidget;
+    
+    // Summary
+    auto row = [](const QString& name, const QString& value) {
+        return QString("<tr><td><b>%1:</b></td><td>%2</td></tr>").arg(name, value);
+    };
+    auto share = [&total](quint64 count) {
+        return total.count ? QString("%1 (%2%)").arg(count).arg(100.0 * count / total.count, 0, 'f', 1) : QString::number(count);
+    };
+    QString html = "<h3>📊 Directory Statistics</h3><table cellpadding='4'>";
+    html += row("Directory", source.toHtmlEscaped());
+    html += row("Textures", QString::number(total.count));
+    html += row("Total Size", formatBytes(total.fileBytes));
+    html += row("Average Size", total.count ? formatBytes(total.fileBytes / total.count) : QString("—"));
+    html += row("VRAM", formatBytes(total.vramBytes));
+    html += row("Formats", QString::number(statistics.formats.size()));
+    html += row("Full Mip Chain", share(statistics.fullMipChain));
+    html += row("Partial Mip Chain", share(statistics.partialMipChain));
+    html += row("No Mipmaps", share(statistics.noMipChain));
+    html += row("Non-Power of 2", share(statistics.nonPowerOfTwo));
+    html += row("Cubemaps", share(statistics.cubemaps));
+    html += row("Animated", share(statistics.animated));
+    html += row("Volume", share(statistics.volumes));
+    html += row("Unreadable", QString::number(statistics.unreadable));
+    html += "</table>";
+    html += QString("<p><i>From texture headers in %1 ms</i></p>").arg(elapsedMs, 0, 'f', 1);
+    QLabel* summary = new QLabel(html);
+    summary->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+    summary->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    tabs->addTab(summary, "Summary");
+    
+    // By format
+    QTableWidget* formats = createTable({ "Format", "Textures", "File Size", "VRAM", "VRAM %" });
+    formats->setRowCount(static_cast<int>(statistics.formats.size()));
+    for (int i = 0; i < formats->rowCount(); ++i) {
+        const VTFLib::FormatStatistics& format = statistics.formats[i];
+        formats->setItem(i, 0, new QTableWidgetItem(VTFLib::GetImageFormatName(static_cast<VTFLib::VTFImageFormat>(format.format))));
+        formats->setItem(i, 1, createNumberItem(format.tally.count));
+        formats->setItem(i, 2, createBytesItem(format.tally.fileBytes));
+        formats->setItem(i, 3, createBytesItem(format.tally.vramBytes));
+        formats->setItem(i, 4, createPercentItem(format.tally.vramBytes, total.vramBytes));
+    }
+    formats->setSortingEnabled(true);
+    formats->sortByColumn(3, Qt::DescendingOrder);
+    tabs->addTab(formats, "Formats");
+    
+    // By resolution
+    QTableWidget* resolutions = createTable({ "Resolution", "Pixels", "Textures", "File Size", "VRAM", "VRAM %" });
+    resolutions->setRowCount(static_cast<int>(statistics.resolutions.size()));
+    for (int i = 0; i < resolutions->rowCount(); ++i) {
+        const VTFLib::ResolutionStatistics& resolution = statistics.resolutions[i];
+        resolutions->setItem(i, 0, new QTableWidgetItem(QString("%1 x %2").arg(resolution.width).arg(resolution.height)));
+        resolutions->setItem(i, 1, createNumberItem(static_cast<quint64>(resolution.width) * resolution.height));
+        resolutions->setItem(i, 2, createNumberItem(resolution.tally.count));
+        resolutions->setItem(i, 3, createBytesItem(resolution.tally.fileBytes));
+        resolutions->setItem(i, 4, createBytesItem(resolution.tally.vramBytes));
+        resolutions->setItem(i, 5, createPercentItem(resolution.tally.vramBytes, total.vramBytes));
+    }
+    resolutions->setSortingEnabled(true);
+    resolutions->sortByColumn(4, Qt::DescendingOrder);
+    tabs->addTab(resolutions, "Resolutions");
+    
+    // Largest textures
+    QTableWidget* largest = createTable({ "Texture", "Format", "Size", "Mips", "Frames", "VRAM" });
+    largest->setRowCount(static_cast<int>(statistics.largest.size()));
+    for (int i = 0; i < largest->rowCount(); ++i) {
+        const VTFLib::LargestTexture& texture = statistics.largest[i];
+        VTFLib::TextureMetadata metadata = index_->GetMetadata(texture.row);
+        std::string_view path = index_->GetPath(texture.row);
+        largest->setItem(i, 0, new QTableWidgetItem(QString::fromUtf8(path.data(), static_cast<int>(path.size()))));
+        largest->setItem(i, 1, new QTableWidgetItem(VTFLib::GetImageFormatName(static_cast<VTFLib::VTFImageFormat>(metadata.format))));
+        largest->setItem(i, 2, new SortItem(QString("%1 x %2").arg(metadata.width).arg(metadata.height),
+                                            static_cast<double>(metadata.width) * metadata.height));
+        largest->setItem(i, 3, createNumberItem(metadata.mipmapCount));
+        largest->setItem(i, 4, createNumberItem(metadata.frames));
+        largest->setItem(i, 5, createBytesItem(texture.vramBytes));
+    }
+    largest->setSortingEnabled(true);
+    largest->sortByColumn(5, Qt::DescendingOrder);
+    largest->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    tabs->addTab(largest, QString("Largest %1").arg(statistics.largest.size()));
+    tabs->addTab(createWhatIfPage(), "What-If");
+    
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(tabs);
+    mainLayout->addWidget(buttonBox);
+}
+
+QWidget* StatsDialog::createWhatIfPage() {
+    compressCheck_ = new QCheckBox("Recompress uncompressed textures to DXT1/DXT5");
+    compressCheck_->setChecked(true);
+    dropMipsSpinBox_ = new QSpinBox;
+    dropMipsSpinBox_->setRange(0, 4);
+    dropMipsSpinBox_->setPrefix("Drop top mips: ");
+    projectionLabel_ = new QLabel;
+    projectionTable_ = createTable({ "Directory", "Textures", "VRAM", "Compression Saves", "Mip Drop Saves", "Total Saves", "Projected" });
+    projectionTable_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    projectionTable_->horizontalHeader()->setSortIndicator(5, Qt::DescendingOrder);
+    
+    connect(compressCheck_, &QCheckBox::toggled, this, &StatsDialog::updateProjection);
+    connect(dropMipsSpinBox_, QOverload<int>::of(&QSpinBox::valueChanged), this, &StatsDialog::updateProjection);
+    
+    QHBoxLayout* controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(compressCheck_);
+    controlsLayout->addWidget(dropMipsSpinBox_);
+    controlsLayout->addStretch();
+    
+    QWidget* page = new QWidget;
+    QVBoxLayout* layout = new QVBoxLayout(page);
+    layout->addLayout(controlsLayout);
+    layout->addWidget(projectionLabel_);
+    layout->addWidget(projectionTable_);
+    
+    updateProjection();
+    return page;
+}
+
+void StatsDialog::updateProjection() {
+    VTFLib::BudgetScenario scenario;
+    scenario.compress = compressCheck_->isChecked();
+    scenario.droppedMips = static_cast<uint32_t>(dropMipsSpinBox_->value());
+    std::vector<VTFLib::BudgetProjection> projections = VTFLib::VRAMBudget::Project(*index_, scenario);
+    
+    // Sorting is off while filling, or rows would move under the loop
+    projectionTable_->setSortingEnabled(false);
+    projectionTable_->setRowCount(static_cast<int>(projections.size()));
+    quint64 current = 0;
+    quint64 projected = 0;
+    for (int i = 0; i < projectionTable_->rowCount(); ++i) {
+        const VTFLib::BudgetProjection& directory = projections[i];
+        QString name = directory.directory.empty() ? QString("(root)") : QString::fromStdString(directory.directory);
+        projectionTable_->setItem(i, 0, new QTableWidgetItem(name));
+        projectionTable_->setItem(i, 1, createNumberItem(directory.count));
+        projectionTable_->setItem(i, 2, createBytesItem(directory.vramBytes));
+        projectionTable_->setItem(i, 3, createBytesItem(directory.compressionSaving));
+        projectionTable_->setItem(i, 4, createBytesItem(directory.mipSaving));
+        projectionTable_->setItem(i, 5, createBytesItem(directory.compressionSaving + directory.mipSaving));
+        projectionTable_->setItem(i, 6, createBytesItem(directory.ProjectedBytes()));
+        current += directory.vramBytes;
+        projected += directory.ProjectedBytes();
+    }
+    projectionTable_->setSortingEnabled(true);
+    
+    projectionLabel_->setText(QString("<b>Projected VRAM:</b> %1 of %2 — saves %3 (%4%)")
+        .arg(formatBytes(projected), formatBytes(current), formatBytes(current - projected))
+        .arg(current ? 100.0 * (current - projected) / current : 0.0, 0, 'f', 1));
+}
+
+QString StatsDialog::formatBytes(quint64 bytes) {
+    if (bytes < 1024) {
+        return QString("%1 B").arg(bytes);
+    } else if (bytes < 1024 * 1024) {
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    } else if (bytes < 1024ULL * 1024 * 1024) {
+        return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 2);
+    } else {
+        return QString("%1 GB").arg(bytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+    }
+}
+
+QTableWidget* StatsDialog::createTable(const QStringList& headers) {
+    QTableWidget* table = new QTableWidget(0, headers.size());
+    table->setHorizontalHeaderLabels(headers);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setAlternatingRowColors(true);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    return table;
+}
+
+QTableWidgetItem* StatsDialog::createNumberItem(quint64 value) {
+    return new SortItem(QString::number(value), static_cast<double>(value));
+}
+
+QTableWidgetItem* StatsDialog::createBytesItem(quint64 bytes) {
+    return new SortItem(formatBytes(bytes), static_cast<double>(bytes));
+}
+
+QTableWidgetItem* StatsDialog::createPercentItem(quint64 part, quint64 total) {
+    double percent = total ? 100.0 * part / total : 0.0;
+    return new SortItem(QString("%1%").arg(percent, 0, 'f', 1), percent);
+}
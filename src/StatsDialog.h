@@ -0,0 +1,47 @@
+#ifndef STATSDIALOG_H
+#define STATSDIALOG_H
+
+#include <QCheckBox>
+#include <QDialog>
+#include <QLabel>
+#include <QSpinBox>
+#include <QStringList>
+#include <QTableWidget>
+#include <memory>
+
+namespace VTFLib {
+    class TextureMetadataIndex;
+    struct TextureStatistics;
+}
+
+// Directory statistics: a summary page, sortable breakdowns by format and resolution, the
+// textures taking the most VRAM, and a what-if page projecting the VRAM saved per
+// directory by recompressing or dropping mips
+class StatsDialog : public QDialog {
+    Q_OBJECT
+    
+public:
+    StatsDialog(const QString& source, std::shared_ptr<const VTFLib::TextureMetadataIndex> index,
+                const VTFLib::TextureStatistics& statistics, double elapsedMs, QWidget* parent = nullptr);
+    
+    // Sizes as B, KB, MB or GB
+    static QString formatBytes(quint64 bytes);
+    
+private slots:
+    void updateProjection();
+    
+private:
+    std::shared_ptr<const VTFLib::TextureMetadataIndex> index_;
+    QCheckBox* compressCheck_;
+    QSpinBox* dropMipsSpinBox_;
+    QLabel* projectionLabel_;
+    QTableWidget* projectionTable_;
+    
+    QWidget* createWhatIfPage();
+    static QTableWidget* createTable(const QStringList& headers);
+    static QTableWidgetItem* createNumberItem(quint64 value);
+    static QTableWidgetItem* createBytesItem(quint64 bytes);
+    static QTableWidgetItem* createPercentItem(quint64 part, quint64 total);
+};
+
+#endif // STATSDIALOG_H
@@ -0,0 +1,225 @@
+#include "TextureSource.h"
+#include "GameIndex.h"
+#include "VPKFile.h"
+#include "ZipFile.h"
+#include "VTFFile.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+namespace {
+
+// Archive names as they end inside a virtual path, before the entry path
+const char* const ARCHIVE_MARKERS[] = { "_dir.vpk/", ".zip/", ".bsp/" };
+
+// Length of the archive part of a virtual path (-1 for plain paths)
+int archivePathLength(const QString& path) {
+    int length = -1;
+    for (const char* marker : ARCHIVE_MARKERS) {
+        int index = path.indexOf(QLatin1String(marker), 0, Qt::CaseInsensitive);
+        if (index >= 0) {
+            int end = index + static_cast<int>(qstrlen(marker)) - 1;
+            if (length < 0 || end < length) {
+                length = end;
+            }
+        }
+    }
+    return length;
+}
+
+} // namespace
+
+TextureSource& TextureSource::shared() {
+    static TextureSource source;
+    return source;
+}
+
+bool TextureSource::mountArchive(const QString& archivePath) {
+    QString key = QFileInfo(archivePath).absoluteFilePath();
+    {
+        QMutexLocker locker(&mutex_);
+        if (archives_.contains(key)) {
+            return true;
+        }
+    }
+    
+    // Parse outside the lock; indexing a large archive shouldn't block texture loads
+    Archive archive;
+    if (key.endsWith(".vpk", Qt::CaseInsensitive)) {
+        archive.vpk = VTFLib::VPKFile::Open(key.toStdString());
+    } else {
+        archive.zip = VTFLib::ZipFile::Open(key.toStdString());
+    }
+    if (!archive.vpk && !archive.zip) {
+        return false;
+    }
+    
+    QMutexLocker locker(&mutex_);
+    archives_.insert(key, archive);
+    return true;
+}
+
+void TextureSource::unmountAll() {
+    QMutexLocker locker(&mutex_);
+    archives_.clear();
+    mountGameArchives();
+}
+
+void TextureSource::setGameIndex(std::shared_ptr<const VTFLib::GameIndex> index) {
+    QMutexLocker locker(&mutex_);
+    gameIndex_ = std::move(index);
+    mountGameArchives();
+}
+
+std::shared_ptr<const VTFLib::GameIndex> TextureSource::gameIndex() const {
+    QMutexLocker locker(&mutex_);
+    return gameIndex_;
+}
+
+QString TextureSource::resolveGamePath(const QString& relativePath) const {
+    std::shared_ptr<const VTFLib::GameIndex> index = gameIndex();
+    VTFLib::GameFileLocation location;
+    if (!index || !index->Find(relativePath.toStdString(), location)) {
+        return QString();
+    }
+    return QString::fromStdString(index->GetFilePath(location));
+}
+
+QString TextureSource::resolveMaterialTexture(const QString& materialPath, const QString& texture) const {
+    QString relative = QDir::fromNativeSeparators(texture);
+    if (relative.isEmpty()) {
+        return QString();
+    }
+    if (!relative.endsWith(".vtf", Qt::CaseInsensitive)) {
+        relative += ".vtf";
+    }
+    
+    QString gamePath = resolveGamePath("materials/" + relative);
+    if (!gamePath.isEmpty()) {
+        return gamePath;
+    }
+    
+    const QString materialsDirName = "/materials/";
+    QString material = QDir::fromNativeSeparators(materialPath);
+    int materialsDir = material.lastIndexOf(materialsDirName, -1, Qt::CaseInsensitive);
+    if (materialsDir >= 0) {
+        QString candidate = QDir::cleanPath(material.left(materialsDir + materialsDirName.size()) + relative);
+        if (QFileInfo::exists(candidate)) {
+            return candidate;
+        }
+    }
+    
+    QString candidate = QDir::cleanPath(QFileInfo(material).absolutePath() + "/" + relative);
+    return QFileInfo::exists(candidate) ? candidate : QString();
+}
+
+void TextureSource::mountGameArchives() {
+    if (!gameIndex_) {
+        return;
+    }
+    
+    // The index already opened these; share them rather than parsing again
+    for (const VTFLib::GameSearchPath& searchPath : gameIndex_->GetSearchPaths()) {
+        if (searchPath.vpk) {
+            Archive archive;
+            archive.vpk = searchPath.vpk;
+            archives_.insert(QString::fromStdString(searchPath.path), archive);
+        }
+    }
+}
+
+QStringList TextureSource::archiveTextures(const QString& archivePath) const {
+    QString key = QFileInfo(archivePath).absoluteFilePath();
+    Archive archive;
+    {
+        QMutexLocker locker(&mutex_);
+        archive = archives_.value(key);
+    }
+    
+    QStringList entryPaths;
+    if (archive.vpk) {
+        for (size_t i = 0; i < archive.vpk->GetEntryCount(); ++i) {
+            entryPaths.append(QString::fromUtf8(archive.vpk->GetEntryPath(archive.vpk->GetEntry(i))));
+        }
+    } else if (archive.zip) {
+        for (size_t i = 0; i < archive.zip->GetEntryCount(); ++i) {
+            entryPaths.append(QString::fromUtf8(archive.zip->GetEntryPath(archive.zip->GetEntry(i))));
+        }
+    }
+    
+    QStringList textures;
+    for (const QString& entryPath : entryPaths) {
+        if (entryPath.endsWith(".vtf")) {
+            textures.append(key + "/" + entryPath);
+        }
+    }
+    return textures;
+}
+
+std::shared_ptr<const VTFLib::VTFFile> TextureSource::openTexture(const QString& path) const {
+    if (!isArchivePath(path)) {
+        return VTFLib::VTFFile::Open(path.toStdString());
+    }
+    
+    QString entryPath;
+    Archive archive = findArchive(path, entryPath);
+    std::string entryName = entryPath.toStdString();
+    
+    if (archive.vpk) {
+        const VTFLib::VPKEntry* entry = archive.vpk->FindEntry(entryName);
+        return entry ? archive.vpk->OpenVTF(*entry) : nullptr;
+    }
+    if (archive.zip) {
+        const VTFLib::ZipEntry* entry = archive.zip->FindEntry(entryName);
+        return entry ? archive.zip->OpenVTF(*entry) : nullptr;
+    }
+    return nullptr;
+}
+
+qint64 TextureSource::textureSize(const QString& path) const {
+    if (!isArchivePath(path)) {
+        QFileInfo fileInfo(path);
+        return fileInfo.exists() ? fileInfo.size() : -1;
+    }
+    
+    QString entryPath;
+    Archive archive = findArchive(path, entryPath);
+    std::string entryName = entryPath.toStdString();
+    
+    if (archive.vpk) {
+        const VTFLib::VPKEntry* entry = archive.vpk->FindEntry(entryName);
+        return entry ? static_cast<qint64>(entry->preloadBytes) + entry->length : -1;
+    }
+    if (archive.zip) {
+        const VTFLib::ZipEntry* entry = archive.zip->FindEntry(entryName);
+        return entry ? static_cast<qint64>(entry->compressedSize) : -1;
+    }
+    return -1;
+}
+
+bool TextureSource::isArchiveFile(const QString& filename) {
+    return filename.endsWith("_dir.vpk", Qt::CaseInsensitive) ||
+           filename.endsWith(".zip", Qt::CaseInsensitive) ||
+           filename.endsWith(".bsp", Qt::CaseInsensitive);
+}
+
+bool TextureSource::isArchivePath(const QString& path) {
+    return archivePathLength(path) >= 0;
+}
+
+QString TextureSource::containerPath(const QString& path) {
+    int length = archivePathLength(path);
+    return length < 0 ? path : path.left(length);
+}
+
+TextureSource::Archive TextureSource::findArchive(const QString& path, QString& entryPath) const {
+    int length = archivePathLength(path);
+    if (length < 0) {
+        return Archive();
+    }
+    
+    entryPath = path.mid(length + 1);
+    
+    QMutexLocker locker(&mutex_);
+    return archives_.value(path.left(length));
+}
@@ -0,0 +1,74 @@
+#ifndef TEXTURESOURCE_H
+#define TEXTURESOURCE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+namespace VTFLib {
+    class GameIndex;
+    class VTFFile;
+    class VPKFile;
+    class ZipFile;
+}
+
+// Resolves texture paths to loaded files. Besides plain files on disk it understands
+// virtual paths into mounted archives, "<dir>/pak01_dir.vpk/materials/foo.vtf", for VPKs,
+// zips and BSP pakfiles; their textures are read straight out of the mapped archive.
+// Thread-safe.
+class TextureSource {
+public:
+    static TextureSource& shared();
+    
+    // Index a VPK, zip or BSP so its entries can be opened through virtual paths
+    bool mountArchive(const QString& archivePath);
+    void unmountAll();
+    
+    // Use a game install to resolve game-relative paths; its VPKs stay mounted until replaced
+    void setGameIndex(std::shared_ptr<const VTFLib::GameIndex> index);
+    std::shared_ptr<const VTFLib::GameIndex> gameIndex() const;
+    
+    // Path of a game file such as "materials/brick/wall.vtf" (empty without an index or match)
+    QString resolveGamePath(const QString& relativePath) const;
+    
+    // VTF a material's texture parameter points at: the game install first, then the
+    // materials directory holding the material, then the material's own directory
+    // (empty if none exists)
+    QString resolveMaterialTexture(const QString& materialPath, const QString& texture) const;
+    
+    // Virtual paths of every texture in a mounted archive
+    QStringList archiveTextures(const QString& archivePath) const;
+    
+    // Load a texture from disk or a mounted archive (nullptr on failure)
+    std::shared_ptr<const VTFLib::VTFFile> openTexture(const QString& path) const;
+    
+    // Stored size of a texture (-1 if it can't be found)
+    qint64 textureSize(const QString& path) const;
+    
+    // Whether a file on disk is an archive mountArchive() accepts
+    static bool isArchiveFile(const QString& filename);
+    
+    static bool isArchivePath(const QString& path);
+    
+    // The file on disk holding a texture: the archive for archived ones, otherwise the path itself
+    static QString containerPath(const QString& path);
+    
+private:
+    // Exactly one of the two is set
+    struct Archive {
+        std::shared_ptr<const VTFLib::VPKFile> vpk;
+        std::shared_ptr<const VTFLib::ZipFile> zip;
+    };
+    
+    mutable QMutex mutex_;
+    QHash<QString, Archive> archives_;
+    std::shared_ptr<const VTFLib::GameIndex> gameIndex_;
+    
+    void mountGameArchives();
+    
+    Archive findArchive(const QString& path, QString& entryPath) const;
+};
+
+#endif // TEXTURESOURCE_H
@@ -1,6 +1,14 @@
 #include "VMTParser.h"
 #include "VMTFile.h"
 
+namespace {
+
+QString toQString(std::string_view text) {
+    return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+}
+
+} // namespace
+
 VMTParser::VMTParser() : vmtFile_(std::make_unique<VTFLib::VMTFile>()) {
 }
 
@@ -30,9 +38,11 @@ QString VMTParser::getParameter(const QString& name) const {
         return QString();
     }
     
-    VTFLib::VMTNode* node = const_cast<VTFLib::VMTFile*>(vmtFile_.get())->GetRoot()->FindChild(name.toStdString());
+    // Nested keys are reached with a path such as "Proxies/AnimatedTexture/animatedtextureframerate"
+    QByteArray key = name.toUtf8();
+    const VTFLib::VMTNode* node = vmtFile_->GetRoot()->FindPath(std::string_view(key.constData(), key.size()));
     if (node) {
-        return QString::fromStdString(node->GetValue());
+        return toQString(node->GetValue());
     }
     
     return QString();
@@ -49,6 +59,18 @@ QMap<QString, QString> VMTParser::getAllParameters() const {
     return params;
 }
 
+QStringList VMTParser::getTextureReferences() const {
+    QStringList textures;
+    if (!isLoaded()) {
+        return textures;
+    }
+    
+    for (const VTFLib::VMTNode* reference : vmtFile_->GetTextureReferences()) {
+        textures << toQString(reference->GetValue());
+    }
+    return textures;
+}
+
 void VMTParser::extractParameters(QMap<QString, QString>& params) const {
     const VTFLib::VMTNode* root = vmtFile_->GetRoot();
     if (!root) {
@@ -56,8 +78,8 @@ void VMTParser::extractParameters(QMap<QString, QString>& params) const {
     }
     
     for (const auto& child : root->GetChildren()) {
-        QString name = QString::fromStdString(child.GetName());
-        QString value = QString::fromStdString(child.GetValue());
+        QString name = toQString(child.GetName());
+        QString value = toQString(child.GetValue());
         params[name] = value;
     }
 }
@@ -3,6 +3,7 @@
 
 #include <QString>
 #include <QMap>
+#include <QStringList>
 #include <memory>
 
 namespace VTFLib {
@@ -18,8 +19,9 @@ public:
     
     QString getShader() const;
     QString getBaseTexture() const;
-    QString getParameter(const QString& name) const;
+    QString getParameter(const QString& name) const;  // name may be a "Block/key" path
     QMap<QString, QString> getAllParameters() const;
+    QStringList getTextureReferences() const;  // values of every texture parameter
     
     bool isLoaded() const;
     
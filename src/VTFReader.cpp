@@ -1,19 +1,55 @@
 #include "VTFReader.h"
 #include "VTFFile.h"
 #include "VTFFormat.h"
+#include "BufferPool.h"
+#include "TextureSource.h"
 #include <QDebug>
 
-VTFReader::VTFReader() : vtfFile_(std::make_unique<VTFLib::VTFFile>()) {
+namespace {
+
+void releasePooledBuffer(void* buffer) {
+    VTFLib::BufferPool::Shared().Release(buffer);
+}
+
+} // namespace
+
+VTFReader::VTFReader() : vtfFile_(std::make_shared<VTFLib::VTFFile>()) {
+}
+
+VTFReader::VTFReader(std::shared_ptr<const VTFLib::VTFFile> file)
+    : vtfFile_(file ? std::move(file) : std::make_shared<VTFLib::VTFFile>()) {
 }
 
 VTFReader::~VTFReader() {
 }
 
 bool VTFReader::loadFile(const QString& filename) {
-    return vtfFile_->Load(filename.toStdString());
+    std::shared_ptr<const VTFLib::VTFFile> file = TextureSource::shared().openTexture(filename);
+    if (!file) {
+        vtfFile_ = std::make_shared<VTFLib::VTFFile>();
+        return false;
+    }
+    
+    vtfFile_ = std::move(file);
+    return true;
 }
 
-QImage VTFReader::getImage(int frame, int mipmap) {
+QImage VTFReader::getImage(int frame, int mipmap) const {
+    return decodeImage(frame, mipmap, VTFLib::PIXEL_LAYOUT_RGBA8888, QImage::Format_RGBA8888);
+}
+
+QImage VTFReader::getDisplayImage(int frame, int mipmap, const std::atomic<bool>* cancel) const {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // Premultiplied BGRA bytes are ARGB32_Premultiplied, so QPixmap::fromImage won't convert
+    return decodeImage(frame, mipmap, VTFLib::PIXEL_LAYOUT_BGRA8888_PREMULTIPLIED,
+                       QImage::Format_ARGB32_Premultiplied, cancel);
+#else
+    return decodeImage(frame, mipmap, VTFLib::PIXEL_LAYOUT_RGBA8888, QImage::Format_RGBA8888, cancel);
+#endif
+}
+
+QImage VTFReader::decodeImage(int frame, int mipmap, VTFLib::VTFPixelLayout layout,
+                              QImage::Format format, const std::atomic<bool>* cancel) const {
     if (!vtfFile_->IsLoaded()) {
         return QImage();
     }
@@ -21,16 +57,47 @@ QImage VTFReader::getImage(int frame, int mipmap) {
     int width = std::max(1, vtfFile_->GetWidth() >> mipmap);
     int height = std::max(1, vtfFile_->GetHeight() >> mipmap);
     
+    // Decode into a pooled, 64-byte aligned buffer and hand it to QImage without a copy;
+    // the buffer goes back to the pool when the last QImage sharing it is destroyed
+    void* buffer = VTFLib::BufferPool::Shared().Acquire(static_cast<size_t>(width) * height * 4);
+    if (!buffer) {
+        return QImage();
+    }
+    
+    QImage image(static_cast<uchar*>(buffer), width, height, width * 4, format,
+                 releasePooledBuffer, buffer);
+    
+    if (vtfFile_->GetImageData(static_cast<uint8_t*>(buffer), frame, mipmap, layout, cancel)) {
+        return image;
+    }
+    
+    return QImage();
+}
+
+QImage VTFReader::getReducedImage(int reduction, int frame, int mipmap) const {
+    if (!vtfFile_->IsLoaded()) {
+        return QImage();
+    }
+    
+    uint16_t width, height;
+    vtfFile_->GetReducedSize(reduction, mipmap, width, height);
+    
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    VTFLib::VTFPixelLayout layout = VTFLib::PIXEL_LAYOUT_BGRA8888_PREMULTIPLIED;
+#else
     QImage image(width, height, QImage::Format_RGBA8888);
+    VTFLib::VTFPixelLayout layout = VTFLib::PIXEL_LAYOUT_RGBA8888;
+#endif
     
-    if (vtfFile_->GetImageData(image.bits(), frame, mipmap)) {
+    if (vtfFile_->GetImageDataReduced(image.bits(), reduction, frame, mipmap, layout)) {
         return image;
     }
     
     return QImage();
 }
 
-QImage VTFReader::getThumbnail(int maxSize) {
+QImage VTFReader::getThumbnail(int maxSize) const {
     if (!vtfFile_->IsLoaded()) {
         return QImage();
     }
@@ -50,7 +117,24 @@ QImage VTFReader::getThumbnail(int maxSize) {
         mipmap++;
     }
     
-    QImage img = getImage(0, mipmap);
+    // Without small enough mips, average straight from the block data at 1/4 to 1/16
+    // resolution instead of decoding the whole mip and smooth-scaling it down
+    int mipWidth = std::max(1, width >> mipmap);
+    int mipHeight = std::max(1, height >> mipmap);
+    int reduction = 0;
+    for (int r = 4; r >= 2; --r) {
+        if ((mipWidth >> r) >= maxSize && (mipHeight >> r) >= maxSize) {
+            reduction = r;
+            break;
+        }
+    }
+    
+    QImage img;
+    if (reduction > 0) {
+        img = getReducedImage(reduction, 0, mipmap);
+    } else {
+        img = getDisplayImage(0, mipmap);
+    }
     
     // Scale to fit maxSize if needed
     if (img.width() > maxSize || img.height() > maxSize) {
@@ -84,6 +168,10 @@ quint32 VTFReader::getFlags() const {
     return vtfFile_->GetFlags();
 }
 
+quint64 VTFReader::getVRAMSize() const {
+    return vtfFile_->GetVRAMSize();
+}
+
 bool VTFReader::isLoaded() const {
     return vtfFile_->IsLoaded();
 }
@@ -1,22 +1,36 @@
 #ifndef VTFREADER_H
 #define VTFREADER_H
 
+#include "VTFFormat.h"
 #include <QImage>
 #include <QString>
 #include <memory>
+#include <atomic>
 
 namespace VTFLib {
     class VTFFile;
 }
 
+// Qt wrapper around a loaded VTF. The underlying file is immutable and shared, so
+// readers created from getFile() decode from the same load on any thread.
 class VTFReader {
 public:
     VTFReader();
+    explicit VTFReader(std::shared_ptr<const VTFLib::VTFFile> file);
     ~VTFReader();
     
+    // Loads from disk or, for virtual paths, from a mounted VPK (see TextureSource)
     bool loadFile(const QString& filename);
-    QImage getImage(int frame = 0, int mipmap = 0);
-    QImage getThumbnail(int maxSize = 128);
+    
+    // Straight-alpha RGBA8888, for export and the clipboard
+    QImage getImage(int frame = 0, int mipmap = 0) const;
+    
+    // Display-native ARGB32_Premultiplied, which QPixmap takes without a conversion pass.
+    // Reduced images and thumbnails are display images too. Returns a null image if
+    // *cancel gets set while decoding.
+    QImage getDisplayImage(int frame = 0, int mipmap = 0, const std::atomic<bool>* cancel = nullptr) const;
+    QImage getReducedImage(int reduction, int frame = 0, int mipmap = 0) const;
+    QImage getThumbnail(int maxSize = 128) const;
     
     int getWidth() const;
     int getHeight() const;
@@ -24,11 +38,16 @@ public:
     int getMipmapCount() const;
     QString getFormat() const;
     quint32 getFlags() const;
+    quint64 getVRAMSize() const;  // every frame, face, slice and mip
     
     bool isLoaded() const;
+    std::shared_ptr<const VTFLib::VTFFile> getFile() const { return vtfFile_; }
     
 private:
-    std::unique_ptr<VTFLib::VTFFile> vtfFile_;
+    std::shared_ptr<const VTFLib::VTFFile> vtfFile_;
+    
+    QImage decodeImage(int frame, int mipmap, VTFLib::VTFPixelLayout layout, QImage::Format format,
+                       const std::atomic<bool>* cancel = nullptr) const;
 };
 
 #endif // VTFREADER_H